@@ -1,15 +1,28 @@
 #include <ArduinoUniqueID.h>
 
 #include <debug.h>
+#include <tuxp.h>
 
 #include "arduino_unique_id_generator.h"
 
+#ifdef MUD_NO_HEAP
+static char thingIdBuff[MAX_SIZE_ATTRIBUTE_DATA + 1];
+#endif
+
 char *generateThingIdUsingUniqueIdLibrary(const char* modelName) {
+#ifdef MUD_NO_HEAP
+  char *thingId = thingIdBuff;
+  snprintf(thingId, sizeof(thingIdBuff), "%.*s-%x%x%x%x%x%x%x%x",
+      MAX_SIZE_ATTRIBUTE_DATA - 1 - 8, modelName,
+      UniqueID8[0] / 16, UniqueID8[1] / 16, UniqueID8[2] / 16, UniqueID8[3] / 16,
+      UniqueID8[4] / 16, UniqueID8[5] / 16, UniqueID8[6] / 16, UniqueID8[7] / 16);
+#else
   int modelNameLength = strlen(modelName);
   char *thingId = malloc(sizeof(char) * (modelNameLength + 1 + 8 + 1));
   sprintf(thingId, "%s-%x%x%x%x%x%x%x%x", modelName,
       UniqueID8[0] / 16, UniqueID8[1] / 16, UniqueID8[2] / 16, UniqueID8[3] / 16,
       UniqueID8[4] / 16, UniqueID8[5] / 16, UniqueID8[6] / 16, UniqueID8[7] / 16);
+#endif
 
 #ifdef ENABLE_DEBUG
   char buffer[64];
@@ -14,6 +14,10 @@ SoftwareSerial softwareSerial(SOFTWARE_SERIAL_RX_PIN, SOFTWARE_SERIAL_TX_PIN);
 
 static char *modelName;
 
+#ifdef MUD_NO_HEAP
+static char thingIdBuff[MAX_SIZE_ATTRIBUTE_DATA + 1];
+#endif
+
 void debugOutputImpl(const char out[]) {
 	Serial.println(out);
 }
@@ -135,14 +139,22 @@ void loadThingInfoImpl(ThingInfo *thingInfo) {
 
     thingInfo->thingId = NULL;
     thingInfo->dacState = NONE;
+#ifndef MUD_NO_HEAP
     thingInfo->address = NULL;
+#endif
     thingInfo->uplinkChannelBegin = -1;
 	thingInfo->uplinkChannelEnd = -1;
     thingInfo->uplinkAddressHighByte = 0xff;
 	thingInfo->uplinkAddressLowByte = 0xff;
   } else {
     int position = 1;
+#ifdef MUD_NO_HEAP
+    if (thingIdSize > MAX_SIZE_ATTRIBUTE_DATA)
+      thingIdSize = MAX_SIZE_ATTRIBUTE_DATA;
+    thingInfo->thingId = thingIdBuff;
+#else
     thingInfo->thingId = malloc(sizeof(char) * (thingIdSize + 1));
+#endif
     for (int i = 0; i < thingIdSize; i++) {
       *((thingInfo->thingId) + i) = EEPROM.read(i + 1);
     }
@@ -166,7 +178,9 @@ void loadThingInfoImpl(ThingInfo *thingInfo) {
 	  thingInfo->uplinkAddressLowByte = EEPROM.read(position);
 	  position++;
 	  
+#ifndef MUD_NO_HEAP
       thingInfo->address = malloc(SIZE_RADIO_ADDRESS);
+#endif
       readAddressFromEepRom(thingInfo->address, position);
     }
   }
@@ -229,9 +243,13 @@ void resetAll() {
 }
 
 void configureMcuBoard(const char *_modelName) {
+#ifdef MUD_NO_HEAP
+  modelName = (char *)_modelName;
+#else
   int modelNameLength = strlen(_modelName);
   modelName = malloc(sizeof(char) * (modelNameLength + 1));
   strcpy(modelName, _modelName);
+#endif
   
 #ifdef ENABLE_DEBUG
   configureSerial();
@@ -13,6 +13,7 @@ extern SoftwareSerial softwareSerial;
 #endif
 
 static uint8_t radioConfigs[5];
+static ReceiveRing radioDataRing;
 
 void configureSerialUart() {
   SerialUart.begin(9600);
@@ -28,12 +29,35 @@ int readDataFromUart(uint8_t buff[], int buffSize) {
   return SerialUart.readBytes(buff, buffSize);
 }
 
+// Moves what the UART has received into the ring. Never waits for more bytes.
+void pumpRadioUart() {
+  int available = SerialUart.available();
+  while (available-- > 0) {
+    if (!ringPutByte(&radioDataRing, SerialUart.read()))
+      break;
+  }
+}
+
+// Called by the core after every loop() while the UART has data. A software serial has no
+// such event, its data is pumped when the thing asks for it.
+#if defined(ARDUINO_MICRO)
+void serialEvent1() {
+  pumpRadioUart();
+}
+#elif defined(ARDUINO_UNO) && !defined(USE_SOFTWARE_SERIAL)
+void serialEvent() {
+  pumpRadioUart();
+}
+#endif
+
 int receiveRadioDataImpl(uint8_t buff[], int buffSize) {
-	int dataSize = readDataFromUart(buff, buffSize);
-	if (dataSize > 0)
-		printToSerialPort("Radio data received. Data: ", buff, dataSize);
-	
-	return dataSize;
+  pumpRadioUart();
+
+  int dataSize = ringTakeBytes(&radioDataRing, buff, buffSize);
+  if (dataSize > 0)
+    printToSerialPort("Radio data received. Data: ", buff, dataSize);
+
+  return dataSize;
 }
 
 bool isOk(uint8_t response[], int responseSize) {
@@ -104,6 +128,7 @@ bool initializeRadioImpl(uint8_t address[]) {
   pinMode(LORA_CHIP_MD1_PIN, OUTPUT);
 
   configureSerialUart();
+  initReceiveRing(&radioDataRing);
 
   delay(1000);
   
@@ -170,23 +195,20 @@ bool changeRadioAddressImpl(RadioAddress address, bool savePersistently) {
   return result;
 }
 
-void sendRadioDataImpl(RadioAddress address, uint8_t data[], int dataSize) {
-  uint8_t finalDataBeSent[3 + dataSize];
-  finalDataBeSent[0] = address[0];
-  finalDataBeSent[1] = address[1];
-  finalDataBeSent[2] = address[2];
-
-  for (int i = 0; i < dataSize; i++)
-    finalDataBeSent[3 + i] = data[i];
-  
-  printToSerialPort("Send data to peer. Data: ", finalDataBeSent, 3 + dataSize);
-  SerialUart.write(finalDataBeSent, 3 + dataSize);
+void sendRadioFrameImpl(uint8_t frame[], int frameSize) {
+  printToSerialPort("Send data to peer. Data: ", frame, frameSize);
+  SerialUart.write(frame, frameSize);
 }
 
 void configureRadioModule() {
   registerRadioInitializer(initializeRadioImpl);
   registerRadioConfigurer(configureRadioImpl);
   registerRadioAddressChanger(changeRadioAddressImpl);
-  registerRadioDataSender(sendRadioDataImpl);
+  registerRadioFrameSender(sendRadioFrameImpl);
+#if defined(ARDUINO_UNO) && defined(USE_SOFTWARE_SERIAL)
   registerRadioDataReceiver(receiveRadioDataImpl);
+  setRadioDataReceivingInterval(0);
+#else
+  registerRadioDataRing(&radioDataRing);
+#endif
 }
@@ -3,6 +3,18 @@
 
 // #define ENABLE_DEBUG 1
 
+// Keep thing and tuxp off the heap. All memory is sized at compile time.
+// #define MUD_NO_HEAP 1
+
+// Child protocols without a heap, e.g. for batched reports. Each one costs sizeof(Protocol) of SRAM.
+// #define SIZE_POOL_PROTOCOL_BLOCKS 2
+
+// Send ints and floats as binary values instead of text. The gateway must understand them.
+// #define TUXP_NATIVE_NUMBERS 1
+
+// Receive payloads larger than a frame in fragments. Reassembly needs about half a KB of SRAM.
+// #define MUD_FRAGMENTATION 1
+
 // For my two Arduino Micro boards.
 #define ARDUINO_MICRO 1
 
@@ -0,0 +1,162 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <thing.h>
+#include <debug.h>
+
+#include "uart_radio_adaptation.h"
+
+#define SIZE_UART_READ_BUFF 64
+#define UART_RING_WAIT_NANOSECONDS 1000000
+#define UART_POLL_TIMEOUT 100
+
+static ReceiveRing radioDataRing;
+static int uartFd = -1;
+static pthread_t readerThread;
+static volatile bool readerRunning = false;
+
+static speed_t toSpeed(int baudRate) {
+	switch (baudRate) {
+	case 1200:
+		return B1200;
+	case 2400:
+		return B2400;
+	case 4800:
+		return B4800;
+	case 19200:
+		return B19200;
+	case 38400:
+		return B38400;
+	case 57600:
+		return B57600;
+	case 115200:
+		return B115200;
+	default:
+		return B9600;
+	}
+}
+
+// The reader is the only producer of the ring. When the thing falls behind it waits for
+// room instead of dropping bytes, the kernel buffers the port meanwhile.
+static void *readUart(void *arg) {
+	(void)arg;
+
+	uint8_t buff[SIZE_UART_READ_BUFF];
+	struct timespec wait = {0, UART_RING_WAIT_NANOSECONDS};
+	struct pollfd uart = {uartFd, POLLIN, 0};
+	while (readerRunning) {
+		// Wakes up now and then to see whether it's stopped.
+		int ready = poll(&uart, 1, UART_POLL_TIMEOUT);
+		if (ready == 0 || (ready < 0 && errno == EINTR))
+			continue;
+
+		if (ready < 0)
+			break;
+
+		ssize_t size = read(uartFd, buff, sizeof(buff));
+		if (size < 0 && errno == EINTR)
+			continue;
+
+		if (size <= 0)
+			break;
+
+		int put = 0;
+		while (readerRunning && put < size) {
+			int room = SIZE_RECEIVE_RING - ringAvailable(&radioDataRing);
+			if (room == 0) {
+				nanosleep(&wait, NULL);
+				continue;
+			}
+
+			put += ringPutBytes(&radioDataRing, buff + put, size - put < room ? size - put : room);
+		}
+	}
+
+	readerRunning = false;
+	return NULL;
+}
+
+static void sendRadioFrameImpl(uint8_t frame[], int frameSize) {
+	int written = 0;
+	while (written < frameSize) {
+		ssize_t size = write(uartFd, frame + written, frameSize - written);
+		if (size < 0 && errno == EINTR)
+			continue;
+
+		if (size <= 0) {
+			debugOut("Failed to write a frame to the UART.");
+			return;
+		}
+
+		written += size;
+	}
+}
+
+bool configureUartRadioOnFd(int fd) {
+	if (readerRunning)
+		return false;
+
+	uartFd = fd;
+	initReceiveRing(&radioDataRing);
+
+	readerRunning = true;
+	if (pthread_create(&readerThread, NULL, readUart, NULL) != 0) {
+		readerRunning = false;
+		return false;
+	}
+
+	registerRadioFrameSender(sendRadioFrameImpl);
+	registerRadioDataRing(&radioDataRing);
+
+	return true;
+}
+
+bool configureUartRadio(const char *device, int baudRate) {
+	int fd = open(device, O_RDWR | O_NOCTTY);
+	if (fd < 0)
+		return false;
+
+	struct termios options;
+	if (tcgetattr(fd, &options) != 0) {
+		close(fd);
+		return false;
+	}
+
+	cfmakeraw(&options);
+	cfsetispeed(&options, toSpeed(baudRate));
+	cfsetospeed(&options, toSpeed(baudRate));
+	// Return as soon as a byte is there.
+	options.c_cc[VMIN] = 1;
+	options.c_cc[VTIME] = 0;
+	if (tcsetattr(fd, TCSANOW, &options) != 0) {
+		close(fd);
+		return false;
+	}
+
+	if (!configureUartRadioOnFd(fd)) {
+		close(fd);
+		return false;
+	}
+
+	return true;
+}
+
+void stopUartRadio() {
+	if (uartFd < 0)
+		return;
+
+	readerRunning = false;
+	pthread_join(readerThread, NULL);
+	close(uartFd);
+	uartFd = -1;
+}
+
+ReceiveRing *getUartRadioRing() {
+	return &radioDataRing;
+}
@@ -0,0 +1,17 @@
+#ifndef MUD_UART_RADIO_ADAPTATION_H
+#define MUD_UART_RADIO_ADAPTATION_H
+
+#include <stdbool.h>
+
+#include <thing.h>
+
+// Radio hooks for a radio module on a serial port of a Linux host, or on any file
+// descriptor such as one end of a pipe or a pseudo terminal in host tests. A thread
+// reads the port into a receive ring, which the thing drains without waiting.
+bool configureUartRadio(const char *device, int baudRate);
+bool configureUartRadioOnFd(int fd);
+void stopUartRadio();
+
+ReceiveRing *getUartRadioRing();
+
+#endif
@@ -0,0 +1,144 @@
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "unity.h"
+
+#include "uart_radio_adaptation.h"
+
+static const ProtocolName NAME_PROTOCOL_QUERY = {{0xf7, 0x01}, 0x04};
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_QUERY 0x01
+
+// The reader thread fills the ring on its own time.
+#define MAX_TIMES_WAIT_FOR_READER 200
+#define READER_WAIT_NANOSECONDS 5000000
+
+static uint8_t thingAddress[] = {0x00, 0x01, 0x17};
+static int queryExecutedTimes = 0;
+
+void resetImpl() {}
+
+bool initializeRadioImpl(RadioAddress address) {
+	return true;
+}
+
+char *loadThingIdImpl() {
+	return "SL-LE01-C980AFE9";
+}
+
+char *loadRegistrationCodeImpl() {
+	return "abcdefghijkl";
+}
+
+bool configureRadioImpl() {
+	return true;
+}
+
+bool changeRadioAddressImpl(RadioAddress address, bool savePersistently) {
+	return true;
+}
+
+void loadThingInfoImpl(ThingInfo *thingInfo) {
+	thingInfo->thingId = "SL-LE01-C980AFE9";
+	thingInfo->dacState = CONFIGURED;
+	thingInfo->uplinkChannelBegin = 0x17;
+	thingInfo->uplinkChannelEnd = 0x17;
+	thingInfo->uplinkAddressHighByte = 0x00;
+	thingInfo->uplinkAddressLowByte = 0x00;
+#ifdef MUD_NO_HEAP
+	memcpy(thingInfo->address, thingAddress, SIZE_RADIO_ADDRESS);
+#else
+	thingInfo->address = thingAddress;
+#endif
+}
+
+void saveThingInfoImpl(ThingInfo *thingInfo) {}
+
+// A query isn't answered, so nothing is written back to the read end of the pipe.
+int8_t executeQuery(Protocol *protocol) {
+	(void)protocol;
+	queryExecutedTimes++;
+	return 0;
+}
+
+void configureThingProtocolsImpl() {
+	registerExecutionProtocol(NAME_PROTOCOL_QUERY, executeQuery, true);
+}
+
+long getTimeImpl() {
+	time_t current;
+	time(&current);
+
+	return current;
+}
+
+void setUp() {
+	registerRadioInitializer(initializeRadioImpl);
+	registerThingIdLoader(loadThingIdImpl);
+	registerRegistrationCodeLoader(loadRegistrationCodeImpl);
+	registerRadioConfigurer(configureRadioImpl);
+	registerRadioAddressChanger(changeRadioAddressImpl);
+	registerThingInfoLoader(loadThingInfoImpl);
+	registerThingInfoSaver(saveThingInfoImpl);
+	registerResetter(resetImpl);
+	registerTimer(getTimeImpl);
+	registerThingProtocolsConfigurer(configureThingProtocolsImpl);
+}
+
+void tearDown() {}
+
+static void waitForQueries(int times) {
+	struct timespec wait = {0, READER_WAIT_NANOSECONDS};
+	for (int i = 0; i < MAX_TIMES_WAIT_FOR_READER && queryExecutedTimes < times; i++) {
+		TEST_ASSERT_EQUAL_INT(0, doWorksAThingShouldDo());
+		nanosleep(&wait, NULL);
+	}
+}
+
+void testProcessFramesFromPipe(void) {
+	int fds[2];
+	TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+	TEST_ASSERT_TRUE(configureUartRadioOnFd(fds[0]));
+	TEST_ASSERT_FALSE(configureUartRadioOnFd(fds[0]));
+	TEST_ASSERT_EQUAL_INT(0, toBeAThing());
+
+	TinyId requestId;
+	if (makeTinyId(0, REQUEST, 12 * (60 * 60 * 1000), requestId) != 0)
+		TEST_FAIL_MESSAGE("Failed to create things tiny ID.");
+
+	Protocol query = createProtocol(NAME_PROTOCOL_QUERY);
+	TEST_ASSERT_EQUAL_INT(0, addIntAttribute(&query, NAME_ATTRIBUTE_REPEAT_PROTOCOL_QUERY, 5));
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateLanExecution(requestId, &query, &pData));
+	releaseProtocol(&query);
+
+	// A frame split across two writes.
+	queryExecutedTimes = 0;
+	TEST_ASSERT_EQUAL_INT(6, write(fds[1], pData.data, 6));
+	waitForQueries(1);
+	TEST_ASSERT_EQUAL_INT(0, queryExecutedTimes);
+	TEST_ASSERT_EQUAL_INT(pData.dataSize - 6, write(fds[1], pData.data + 6, pData.dataSize - 6));
+	waitForQueries(1);
+	TEST_ASSERT_EQUAL_INT(1, queryExecutedTimes);
+
+	// Two frames in one write.
+	uint8_t data[MAX_SIZE_PROTOCOL_DATA * 2];
+	memcpy(data, pData.data, pData.dataSize);
+	memcpy(data + pData.dataSize, pData.data, pData.dataSize);
+	TEST_ASSERT_EQUAL_INT(pData.dataSize * 2, write(fds[1], data, pData.dataSize * 2));
+	waitForQueries(3);
+	TEST_ASSERT_EQUAL_INT(3, queryExecutedTimes);
+
+	releaseProtocolData(&pData);
+	stopUartRadio();
+	close(fds[1]);
+	registerRadioDataRing(NULL);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testProcessFramesFromPipe);
+
+	return UNITY_END();
+}
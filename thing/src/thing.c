@@ -3,6 +3,12 @@
 #include <stdio.h>
 
 #include "thing.h"
+#include "frame_reassembler.h"
+#ifdef MUD_FRAGMENTATION
+#include "fragmentation.h"
+#endif
+#include "allocator.h"
+#include "header_compression.h"
 
 static void (*reset)() = NULL;
 static long (*getTime)() = NULL;
@@ -15,22 +21,79 @@ static void (*loadThingInfo)(ThingInfo *) = NULL;
 static void (*saveThingInfo)(ThingInfo *) = NULL;
 static void (*configureThingProtocols)() = NULL;
 static void (*sendRadioData)(RadioAddress, uint8_t[], int) = NULL;
+static void (*sendRadioFrame)(uint8_t[], int) = NULL;
 static int (*receiveRadioData)(uint8_t[], int) = NULL;
+static ReceiveRing *radioDataRing = NULL;
+#ifdef MUD_FRAGMENTATION
+static void (*processFragmentedData)(TinyId, const uint8_t[], int) = NULL;
+#endif
 
 static ThingInfo thingInfo = {NULL, NONE, NULL, NULL, NULL};
 static RadioAddress currentRadioAddress = {0x00, 0x00, 0xff};
 
-static uint8_t messages[MAX_SIZE_PROTOCOL_DATA * 2];
-static int messagesLength = 0;
+static uint8_t txBuff[SIZE_RADIO_ADDRESS + MAX_SIZE_PROTOCOL_DATA];
+
+static FrameReassembler frameReassembler;
+
+static ProtocolFormat preferredProtocolFormat = PROTOCOL_FORMAT_ESCAPED;
+static bool preferredHeaderCompression = false;
+static CompressionContext compressionContext;
 
 static const uint8_t dacServiceAddress[] = DAC_SERVICE_ADDRESS;
 static const uint8_t dacClientAddress[] = DAC_CLIENT_ADDRESS;
 
-static ExecutionProtocolRegistration *executionProtocolRegistrations = NULL;
+// Registrations and report states are found by their packed protocol names.
+static uint32_t executionProtocolKeys[MAX_SIZE_EXECUTION_PROTOCOL_REGISTRATIONS];
+static void *executionProtocolValues[MAX_SIZE_EXECUTION_PROTOCOL_REGISTRATIONS];
+static ProtocolRegistry executionProtocolRegistrations = {0, MAX_SIZE_EXECUTION_PROTOCOL_REGISTRATIONS,
+	executionProtocolKeys, executionProtocolValues};
 static LanNotificationAndRexInfo *lanNotificationAndRexInfos = NULL;
 
-static ReportProtocolRegistration *reportProtocolRegistrations = NULL;
-static ReportState *reportStates = NULL;
+static uint32_t reportProtocolKeys[MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS];
+static void *reportProtocolValues[MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS];
+static ProtocolRegistry reportProtocolRegistrations = {0, MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS,
+	reportProtocolKeys, reportProtocolValues};
+
+// Tables stay where they are declared. Their entries are copied out when they are used.
+static const ExecutionProtocolRegistration *executionProtocolTable = NULL;
+static uint8_t executionProtocolTableSize = 0;
+static const ReportProtocolRegistration *reportProtocolTable = NULL;
+static ReportState *reportProtocolTableStates = NULL;
+static uint8_t reportProtocolTableSize = 0;
+
+#if defined(__AVR__)
+#define readTableEntry(to, from, size) memcpy_P(to, from, size)
+#else
+#define readTableEntry(to, from, size) memcpy(to, from, size)
+#endif
+
+// A report protocol registered on its own keeps its state with it. The state comes first, so a
+// scheduled state which isn't in the table is the protocol itself.
+typedef struct {
+	ReportState state;
+	ReportProtocolRegistration registration;
+} RegisteredReportProtocol;
+
+// A batch is taken when a report's first sample is written and given back once it's sent.
+typedef struct ReportBatch {
+	ProtocolWriter writer;
+	uint8_t frame[MAX_SIZE_PROTOCOL_DATA];
+} ReportBatch;
+
+// Report states as a min-heap on the time they are due next.
+static ReportState *reportSchedule[MAX_SIZE_SCHEDULED_REPORTS];
+static int reportScheduleSize = 0;
+
+#ifdef MUD_NO_HEAP
+static ExecutionProtocolRegistration executionProtocolRegistrationSlots[MAX_SIZE_EXECUTION_PROTOCOL_REGISTRATIONS];
+static bool executionProtocolRegistrationSlotsUsed[MAX_SIZE_EXECUTION_PROTOCOL_REGISTRATIONS];
+
+static RegisteredReportProtocol reportProtocolRegistrationSlots[MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS];
+static bool reportProtocolRegistrationSlotsUsed[MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS];
+
+static ReportBatch reportBatchSlots[MAX_SIZE_REPORT_BATCHES];
+static bool reportBatchSlotsUsed[MAX_SIZE_REPORT_BATCHES];
+#endif
 
 #define DEFAULT_RADIO_DATA_RECEIVING_INTERVAL 1000
 
@@ -82,136 +145,385 @@ void registerRadioDataSender(void (*_sendRadioData)(RadioAddress address, uint8_
 	sendRadioData = _sendRadioData;
 }
 
+void registerRadioFrameSender(void (*_sendRadioFrame)(uint8_t frame[], int frameSize)) {
+	sendRadioFrame = _sendRadioFrame;
+}
+
 void registerRadioDataReceiver(int (*_receiveRadioData)(uint8_t buff[], int buffSize)) {
 	receiveRadioData = _receiveRadioData;
 }
 
-void registerExecutionProtocol(ProtocolName name,
+void registerRadioDataRing(ReceiveRing *ring) {
+	radioDataRing = ring;
+}
+
+#ifdef MUD_FRAGMENTATION
+void registerFragmentedDataProcessor(void (*_processFragmentedData)(TinyId tinyId, const uint8_t data[], int dataSize)) {
+	processFragmentedData = _processFragmentedData;
+}
+#endif
+
+#ifdef MUD_NO_HEAP
+static void *takeSlot(void *slots, size_t slotSize, bool used[], int size) {
+	for (int i = 0; i < size; i++) {
+		if (!used[i]) {
+			used[i] = true;
+			return (uint8_t *)slots + i * slotSize;
+		}
+	}
+
+	return NULL;
+}
+
+static void giveBackSlot(void *slots, size_t slotSize, bool used[], void *slot) {
+	used[((uint8_t *)slot - (uint8_t *)slots) / slotSize] = false;
+}
+#endif
+
+static ExecutionProtocolRegistration *newExecutionProtocolRegistration() {
+#ifdef MUD_NO_HEAP
+	return takeSlot(executionProtocolRegistrationSlots, sizeof(ExecutionProtocolRegistration),
+		executionProtocolRegistrationSlotsUsed, MAX_SIZE_EXECUTION_PROTOCOL_REGISTRATIONS);
+#else
+	return tuxpAlloc(sizeof(ExecutionProtocolRegistration), ALLOCATION_SITE_REGISTRATION);
+#endif
+}
+
+static void deleteExecutionProtocolRegistration(ExecutionProtocolRegistration *registration) {
+#ifdef MUD_NO_HEAP
+	giveBackSlot(executionProtocolRegistrationSlots, sizeof(ExecutionProtocolRegistration),
+		executionProtocolRegistrationSlotsUsed, registration);
+#else
+	tuxpFree(registration, sizeof(ExecutionProtocolRegistration));
+#endif
+}
+
+static RegisteredReportProtocol *newRegisteredReportProtocol() {
+#ifdef MUD_NO_HEAP
+	return takeSlot(reportProtocolRegistrationSlots, sizeof(RegisteredReportProtocol),
+		reportProtocolRegistrationSlotsUsed, MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS);
+#else
+	return tuxpAlloc(sizeof(RegisteredReportProtocol), ALLOCATION_SITE_REGISTRATION);
+#endif
+}
+
+static void deleteRegisteredReportProtocol(RegisteredReportProtocol *registered) {
+#ifdef MUD_NO_HEAP
+	giveBackSlot(reportProtocolRegistrationSlots, sizeof(RegisteredReportProtocol),
+		reportProtocolRegistrationSlotsUsed, registered);
+#else
+	tuxpFree(registered, sizeof(RegisteredReportProtocol));
+#endif
+}
+
+static ReportBatch *newReportBatch() {
+#ifdef MUD_NO_HEAP
+	return takeSlot(reportBatchSlots, sizeof(ReportBatch), reportBatchSlotsUsed, MAX_SIZE_REPORT_BATCHES);
+#else
+	return tuxpAlloc(sizeof(ReportBatch), ALLOCATION_SITE_REPORT_BATCH);
+#endif
+}
+
+static void deleteReportBatch(ReportBatch *batch) {
+#ifdef MUD_NO_HEAP
+	giveBackSlot(reportBatchSlots, sizeof(ReportBatch), reportBatchSlotsUsed, batch);
+#else
+	tuxpFree(batch, sizeof(ReportBatch));
+#endif
+}
+
+int registerExecutionProtocol(ProtocolName name,
 			int8_t (*executeAction)(Protocol *), bool isQueryProtocol) {
-	ExecutionProtocolRegistration *newestRegistration = malloc(sizeof(ExecutionProtocolRegistration));
-	newestRegistration->name = name;
-	newestRegistration->executeAction = executeAction;
-	newestRegistration->isQueryProtocol = isQueryProtocol;
-	newestRegistration->next = NULL;
-
-	if(executionProtocolRegistrations) {
-		ExecutionProtocolRegistration *last = executionProtocolRegistrations;
-		while(last->next) {
-			last = last->next;
+	// Registering a name again replaces what it was registered with.
+	ExecutionProtocolRegistration *registration = registryGet(&executionProtocolRegistrations, name);
+	if (!registration) {
+		registration = newExecutionProtocolRegistration();
+		if (!registration)
+			return debugErrorAndReturn("registerExecutionProtocol", TUXP_ERROR_OUT_OF_MEMEORY);
+
+		if (registryPut(&executionProtocolRegistrations, name, registration) != 0) {
+			deleteExecutionProtocolRegistration(registration);
+			return debugErrorAndReturn("registerExecutionProtocol", TUXP_ERROR_OUT_OF_MEMEORY);
 		}
+	}
 
-		last->next = newestRegistration;
-	} else {
-		executionProtocolRegistrations = newestRegistration;
+	registration->name = name;
+	registration->executeAction = executeAction;
+	registration->isQueryProtocol = isQueryProtocol;
+
+	return 0;
+}
+
+// Both registrations begin with the name.
+static ProtocolName readTableName(const void *table, size_t entrySize, int position) {
+	ProtocolName name;
+	readTableEntry(&name, (const uint8_t *)table + position * entrySize, sizeof(ProtocolName));
+
+	return name;
+}
+
+static bool isTableSorted(const void *table, size_t entrySize, uint8_t size) {
+	for (int i = 1; i < size; i++) {
+		if (packProtocolName(readTableName(table, entrySize, i - 1)) >=
+				packProtocolName(readTableName(table, entrySize, i)))
+			return false;
+	}
+
+	return true;
+}
+
+static int searchTable(const void *table, size_t entrySize, uint8_t size, ProtocolName name) {
+	uint32_t key = packProtocolName(name);
+	int low = 0;
+	int high = size;
+	while (low < high) {
+		int middle = (low + high) / 2;
+		uint32_t middleKey = packProtocolName(readTableName(table, entrySize, middle));
+		if (middleKey == key)
+			return middle;
+
+		if (middleKey < key)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return -1;
+}
+
+int registerExecutionProtocolTable(const ExecutionProtocolRegistration table[], uint8_t size) {
+	if (!isTableSorted(table, sizeof(ExecutionProtocolRegistration), size))
+		return debugErrorAndReturn("registerExecutionProtocolTable", THING_ERROR_UNSORTED_PROTOCOL_TABLE);
+
+	executionProtocolTable = table;
+	executionProtocolTableSize = size;
+
+	return 0;
+}
+
+// Protocols registered one by one come before the ones in the table.
+static bool findExecutionProtocol(ProtocolName name, ExecutionProtocolRegistration *registration) {
+	ExecutionProtocolRegistration *registered = registryGet(&executionProtocolRegistrations, name);
+	if (registered) {
+		*registration = *registered;
+		return true;
 	}
+
+	int position = searchTable(executionProtocolTable, sizeof(ExecutionProtocolRegistration),
+		executionProtocolTableSize, name);
+	if (position < 0)
+		return false;
+
+	readTableEntry(registration, executionProtocolTable + position, sizeof(ExecutionProtocolRegistration));
+	return true;
 }
 
 bool unregisterExecutionProtocol(ProtocolName name) {
-	if(!executionProtocolRegistrations)
+	ExecutionProtocolRegistration *registration = registryRemove(&executionProtocolRegistrations, name);
+	if (!registration)
 		return false;
 
-	ExecutionProtocolRegistration *current = executionProtocolRegistrations;
-	ExecutionProtocolRegistration *previous = NULL;
-	while(current) {
-		if(current->name.ns[0] != name.ns[0] ||
-			current->name.ns[1] != name.ns[1] ||
-			current->name.localName != name.localName) {
-			previous = current;
-			current = current->next;
+	deleteExecutionProtocolRegistration(registration);
+	return true;
+}
+
+int registerReportProtocol(ProtocolName name, int8_t (*aquireData)(Protocol *),
+			long samplingInterval) {
+	return registerBatchedReportProtocol(name, aquireData, samplingInterval, 1);
+}
+
+// Times wrap around, so they are added and compared by their difference without a signed overflow.
+static long addTime(long time, long interval) {
+	return (long)((unsigned long)time + (unsigned long)interval);
+}
+
+static long getTimeDifference(long time, long other) {
+	return (long)((unsigned long)time - (unsigned long)other);
+}
+
+static bool isDueBefore(const ReportState *reportState, const ReportState *other) {
+	return getTimeDifference(reportState->nextReportTime, other->nextReportTime) < 0;
+}
+
+static void swapScheduledReports(int i, int j) {
+	ReportState *reportState = reportSchedule[i];
+	reportSchedule[i] = reportSchedule[j];
+	reportSchedule[j] = reportState;
+}
+
+static void siftScheduledReportUp(int position) {
+	while (position > 0) {
+		int parent = (position - 1) / 2;
+		if (!isDueBefore(reportSchedule[position], reportSchedule[parent]))
+			return;
+
+		swapScheduledReports(position, parent);
+		position = parent;
+	}
+}
+
+static void siftScheduledReportDown(int position) {
+	while (true) {
+		int earliest = position;
+		int left = 2 * position + 1;
+		int right = left + 1;
+		if (left < reportScheduleSize && isDueBefore(reportSchedule[left], reportSchedule[earliest]))
+			earliest = left;
+		if (right < reportScheduleSize && isDueBefore(reportSchedule[right], reportSchedule[earliest]))
+			earliest = right;
+
+		if (earliest == position)
+			return;
+
+		swapScheduledReports(position, earliest);
+		position = earliest;
+	}
+}
+
+// A new report is due at once.
+static void scheduleReport(ReportState *reportState) {
+	reportState->lastReportTime = 0;
+	reportState->nextReportTime = 0;
+	reportState->batchedSamples = 0;
+	reportState->batch = NULL;
+
+	reportSchedule[reportScheduleSize] = reportState;
+	siftScheduledReportUp(reportScheduleSize);
+	reportScheduleSize++;
+}
+
+static int sendReportBatch(ReportState *reportState);
+
+static void unscheduleReport(ReportState *reportState) {
+	for (int i = 0; i < reportScheduleSize; i++) {
+		if (reportSchedule[i] != reportState)
 			continue;
-		}
 
-		if(previous) {
-			previous->next = current->next;
-		} else {
-			executionProtocolRegistrations = current->next;
+		reportScheduleSize--;
+		reportSchedule[i] = reportSchedule[reportScheduleSize];
+		if (i < reportScheduleSize) {
+			siftScheduledReportDown(i);
+			siftScheduledReportUp(i);
 		}
-
-		free(current);
-		return true;
+		break;
 	}
 
-	return false;
+	// The samples collected so far aren't lost.
+	if (reportState->batch)
+		sendReportBatch(reportState);
 }
 
-void registerReportProtocol(ProtocolName name, int8_t (*aquireData)(Protocol *),
-			long samplingInterval) {
-	ReportProtocolRegistration *newestRegistration = malloc(sizeof(ReportProtocolRegistration));
-	newestRegistration->name = name;
-	newestRegistration->acquireData = aquireData;
-	newestRegistration->samplingInterval = samplingInterval;
-	newestRegistration->next = NULL;
-
-	if(reportProtocolRegistrations) {
-		ReportProtocolRegistration *last = reportProtocolRegistrations;
-		while(last->next) {
-			last = last->next;
+// Samples are collected until there are batchSize of them, then they are reported as children of one frame.
+int registerBatchedReportProtocol(ProtocolName name, int8_t (*aquireData)(Protocol *),
+			long samplingInterval, uint8_t batchSize) {
+	if (batchSize == 0 || batchSize > MAX_SIZE_CHILDREN)
+		return debugErrorAndReturn("registerBatchedReportProtocol", TUXP_ERROR_TOO_MANY_CHILDREN);
+
+	RegisteredReportProtocol *registered = registryGet(&reportProtocolRegistrations, name);
+	if (!registered) {
+		if (reportScheduleSize >= MAX_SIZE_SCHEDULED_REPORTS)
+			return debugErrorAndReturn("registerBatchedReportProtocol", TUXP_ERROR_OUT_OF_MEMEORY);
+
+		registered = newRegisteredReportProtocol();
+		if (!registered)
+			return debugErrorAndReturn("registerBatchedReportProtocol", TUXP_ERROR_OUT_OF_MEMEORY);
+
+		if (registryPut(&reportProtocolRegistrations, name, registered) != 0) {
+			deleteRegisteredReportProtocol(registered);
+			return debugErrorAndReturn("registerBatchedReportProtocol", TUXP_ERROR_OUT_OF_MEMEORY);
 		}
 
-		last->next = newestRegistration;
-	} else {
-		reportProtocolRegistrations = newestRegistration;
+		scheduleReport(&registered->state);
+	} else if (registered->state.batch) {
+		// The samples collected so far go out as they were registered.
+		sendReportBatch(&registered->state);
 	}
+
+	registered->registration.name = name;
+	registered->registration.acquireData = aquireData;
+	registered->registration.samplingInterval = samplingInterval;
+	registered->registration.batchSize = batchSize;
+
+	return 0;
 }
 
 bool unregisterReportProtocol(ProtocolName name) {
-	if(!reportProtocolRegistrations)
+	RegisteredReportProtocol *registered = registryRemove(&reportProtocolRegistrations, name);
+	if (!registered)
 		return false;
 
-	ReportProtocolRegistration *current = reportProtocolRegistrations;
-	ReportProtocolRegistration *previous = NULL;
-	while(current) {
-		if(current->name.ns[0] != name.ns[0] ||
-			current->name.ns[1] != name.ns[1] ||
-			current->name.localName != name.localName) {
-			previous = current;
-			current = current->next;
-			continue;
-		}
+	unscheduleReport(&registered->state);
+	deleteRegisteredReportProtocol(registered);
+	return true;
+}
 
-		if(previous) {
-			previous->next = current->next;
-		} else {
-			reportProtocolRegistrations = current->next;
-		}
+int registerReportProtocolTable(const ReportProtocolRegistration table[], ReportState states[], uint8_t size) {
+	if (!isTableSorted(table, sizeof(ReportProtocolRegistration), size))
+		return debugErrorAndReturn("registerReportProtocolTable", THING_ERROR_UNSORTED_PROTOCOL_TABLE);
 
-		free(current);
-		return true;
+	if (reportScheduleSize - reportProtocolTableSize + size > MAX_SIZE_SCHEDULED_REPORTS)
+		return debugErrorAndReturn("registerReportProtocolTable", TUXP_ERROR_OUT_OF_MEMEORY);
+
+	for (int i = 0; i < size; i++) {
+		ReportProtocolRegistration registration;
+		readTableEntry(&registration, table + i, sizeof(ReportProtocolRegistration));
+		if (registration.batchSize == 0 || registration.batchSize > MAX_SIZE_CHILDREN)
+			return debugErrorAndReturn("registerReportProtocolTable", TUXP_ERROR_TOO_MANY_CHILDREN);
 	}
 
-	return false;
+	for (int i = 0; i < reportProtocolTableSize; i++)
+		unscheduleReport(reportProtocolTableStates + i);
+
+	for (int i = 0; i < size; i++)
+		scheduleReport(states + i);
+
+	reportProtocolTable = table;
+	reportProtocolTableStates = states;
+	reportProtocolTableSize = size;
+
+	return 0;
 }
 
 ReportState *getReportState(ProtocolName name) {
-	if (!reportStates) {
-		ReportState *reportState = malloc(sizeof(ReportState));
-		reportState->name = name;
-		reportState->lastReportTime = 0;
+	int position = searchTable(reportProtocolTable, sizeof(ReportProtocolRegistration),
+		reportProtocolTableSize, name);
+	if (position >= 0)
+		return reportProtocolTableStates + position;
 
-		reportStates = reportState;
+	RegisteredReportProtocol *registered = registryGet(&reportProtocolRegistrations, name);
+	return registered ? &registered->state : NULL;
+}
 
-		return reportState;
-	} else {
-		ReportState *current = reportStates;
-		while(true) {
-			if (current->name.ns[0] == name.ns[0] &&
-					current->name.ns[1] == name.ns[1] &&
-						current->name.localName == name.localName)
-				return current;
-
-			if(current->next)
-				current = current->next;
-			else
-				break;
-		}
+static void readScheduledReportRegistration(const ReportState *reportState,
+			ReportProtocolRegistration *registration) {
+	if (reportProtocolTableSize > 0 && reportState >= reportProtocolTableStates &&
+			reportState < reportProtocolTableStates + reportProtocolTableSize) {
+		readTableEntry(registration, reportProtocolTable + (reportState - reportProtocolTableStates),
+			sizeof(ReportProtocolRegistration));
+		return;
+	}
 
-		ReportState *reportState = malloc(sizeof(ReportState));
-		reportState->name = name;
-		reportState->lastReportTime = 0;
-		current->next = reportState;
+	*registration = ((const RegisteredReportProtocol *)reportState)->registration;
+}
 
-		return reportState;
-	}
+bool getNextReportDeadline(long *timeLeft) {
+	if (reportScheduleSize == 0)
+		return false;
+
+	long difference = getTimeDifference(reportSchedule[0]->nextReportTime, getTime());
+	*timeLeft = difference > 0 ? difference : 0;
+
+	return true;
+}
+
+// Asks the DAC service for another frame format. It's used once the service agrees in the allocation.
+void setPreferredProtocolFormat(ProtocolFormat format) {
+	preferredProtocolFormat = format;
+}
+
+// Asks the DAC service for header compression rules. Frames matching none of them are sent as they are.
+void setPreferredHeaderCompression(bool headerCompression) {
+	preferredHeaderCompression = headerCompression;
 }
 
 void unregisterThingHooks() {
@@ -225,7 +537,12 @@ void unregisterThingHooks() {
 	saveThingInfo = NULL;
 	configureThingProtocols = NULL;
 	sendRadioData = NULL;
+	sendRadioFrame = NULL;
 	receiveRadioData = NULL;
+	radioDataRing = NULL;
+#ifdef MUD_FRAGMENTATION
+	processFragmentedData = NULL;
+#endif
 }
 
 void chooseUplinkAddress(RadioAddress chosen) {
@@ -250,8 +567,28 @@ void chooseUplinkAddress(RadioAddress chosen) {
 	chosen[2] = thingInfo.uplinkChannelEnd + chosenChannelIndex;
 }
 
+static void sendTxFrame(RadioAddress to, int frameSize) {
+	memcpy(txBuff, to, SIZE_RADIO_ADDRESS);
+
+	if (sendRadioFrame)
+		sendRadioFrame(txBuff, frameSize);
+	else
+		sendRadioData(to, txBuff + SIZE_RADIO_ADDRESS, frameSize - SIZE_RADIO_ADDRESS);
+}
+
+static int compressTxFrame(int frameSize) {
+	return SIZE_RADIO_ADDRESS + compressFrame(&compressionContext, txBuff + SIZE_RADIO_ADDRESS,
+		frameSize - SIZE_RADIO_ADDRESS);
+}
+
 void sendAndRelease(RadioAddress to, ProtocolData *pData) {
-	sendRadioData(to, pData->data, pData->dataSize);
+	if (sendRadioFrame) {
+		memcpy(txBuff + SIZE_RADIO_ADDRESS, pData->data, pData->dataSize);
+		sendTxFrame(to, SIZE_RADIO_ADDRESS + pData->dataSize);
+	} else {
+		sendRadioData(to, pData->data, pData->dataSize);
+	}
+
 	releaseProtocolData(pData);
 }
 
@@ -271,6 +608,17 @@ int introduce(char *thingId, char *registrationCode) {
 			dacClientAddress, 3) != 0)
 		return THING_ERROR_SET_PROTOCOL_ATTRIBUTE;
 
+	// The introduction itself is always escaped. It only tells the DAC service what we prefer.
+	if (preferredProtocolFormat != PROTOCOL_FORMAT_ESCAPED &&
+			addRbsAttribute(&introduction, NAME_ATTRIBUTE_PROTOCOL_FORMAT_TUXP_PROTOCOL_INTRODUCTION,
+				preferredProtocolFormat) != 0)
+		return THING_ERROR_SET_PROTOCOL_ATTRIBUTE;
+
+	if (preferredHeaderCompression &&
+			addRbsAttribute(&introduction, NAME_ATTRIBUTE_HEADER_COMPRESSION_TUXP_PROTOCOL_INTRODUCTION,
+				0x01) != 0)
+		return THING_ERROR_SET_PROTOCOL_ATTRIBUTE;
+
 	if (setText(&introduction, registrationCode) != 0)
 		return THING_ERROR_SET_PROTOCOL_TEXT;
 	
@@ -323,8 +671,8 @@ bool checkHooks() {
 			configureRadio == NULL ||
 			changeRadioAddress == NULL ||
 			configureThingProtocols == NULL ||
-			sendRadioData== NULL ||
-			receiveRadioData == NULL ||
+			(sendRadioData == NULL && sendRadioFrame == NULL) ||
+			(receiveRadioData == NULL && radioDataRing == NULL) ||
 			reset == NULL ||
 			getTime == NULL) {
 		return false;
@@ -375,7 +723,7 @@ int doDac() {
 }
 
 void cleanMessages() {
-	messagesLength = 0;
+	resetFrameReassembler(&frameReassembler);
 }
 
 int toBeAThing() {
@@ -442,10 +790,23 @@ bool amIAThing() {
 	return thingInfo.dacState == CONFIGURED;
 }
 
+static void clearThingAddress() {
+#ifdef MUD_NO_HEAP
+	memset(thingInfo.address, 0, SIZE_RADIO_ADDRESS);
+#else
+	thingInfo.address = NULL;
+#endif
+}
+
 void resetThing() {
 	loadThingInfo(&thingInfo);
 
-	thingInfo.address = NULL;
+	clearThingAddress();
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+	initCompressionContext(&compressionContext, PROTOCOL_FORMAT_ESCAPED);
+#ifdef MUD_FRAGMENTATION
+	resetReassembly();
+#endif
 	thingInfo.uplinkChannelBegin = -1;
 	thingInfo.uplinkChannelEnd = -1;
 	thingInfo.uplinkAddressHighByte = 0xff;
@@ -464,34 +825,33 @@ uint8_t getLanId() {
 	return currentRadioAddress[1];
 }
 
-int findProtocolStartPosition() {
-	for (int i = 0; i < messagesLength - 1; i++) {
-		if (messages[i] == FLAG_DOC_BEGINNING_END) {
-			if (i - 1 >= 0 && messages[i - 1] == FLAG_ESCAPE)
-				continue;
+#ifdef MUD_FRAGMENTATION
+static int processFragment(ProtocolData *pData) {
+	FragmentAck ack;
+	bool ackRequired;
+	int result = receiveFragment(pData, &ack, &ackRequired);
+	if (result < 0)
+		return result;
 
-			if (messages[i + 1] == FLAG_DOC_BEGINNING_END)
-				continue;
+	if (ackRequired) {
+		int frameSize = encodeFragmentAck(&ack, txBuff, sizeof(txBuff), SIZE_RADIO_ADDRESS);
+		if (frameSize < 0)
+			return THING_ERROR_PROTOCOL_TRANSLATION;
 
-			return i;
-		}
+		RadioAddress chosen;
+		chooseUplinkAddress(chosen);
+		sendTxFrame(chosen, frameSize);
 	}
 
-	return -1;
-}
-
-int findProtocolEndPosition(int startPosition) {
-	for(int i = startPosition + 1; i < messagesLength; i++) {
-		if(i - 1 >= 0 && messages[i - 1] == FLAG_ESCAPE)
-			continue;
-
-		if(messages[i] == FLAG_DOC_BEGINNING_END) {
-			return i;
-		}
+	if (result == FRAGMENTS_REASSEMBLED && processFragmentedData) {
+		int dataSize;
+		const uint8_t *data = getReassembledData(ack.tinyId, &dataSize);
+		processFragmentedData(ack.tinyId, data, dataSize);
 	}
 
-	return -1;
+	return 0;
 }
+#endif
 
 int processProtocol(uint8_t data[], int size) {
 #if defined(ARDUINO) && defined(ENABLE_DEBUG)
@@ -501,6 +861,11 @@ int processProtocol(uint8_t data[], int size) {
 #endif
 
 	ProtocolData pData = {data, size};
+#ifdef MUD_FRAGMENTATION
+	if (isFragment(&pData))
+		return processFragment(&pData);
+#endif
+
 	if (isLanExecution(&pData)) {
 		TinyId requestId;
 		Protocol action = createEmptyProtocol();
@@ -509,42 +874,37 @@ int processProtocol(uint8_t data[], int size) {
 			return TUXP_ERROR_FAILED_TO_PARSE_PROTOCOL;
 		}
 
-		ExecutionProtocolRegistration *registration = getExecutionProtocolRegistration(action.name);
-		if(!registration) {
+		ExecutionProtocolRegistration registration;
+		if(!findExecutionProtocol(action.name, &registration)) {
 			releaseProtocol(&action);
 		 	return TUXP_ERROR_UNKNOWN_PROTOCOL_NAME;
 		}
 
-		if(!registration->executeAction) {
+		if(!registration.executeAction) {
 			releaseProtocol(&action);
 			return TUXP_ERROR_NO_REGISTRATED_PROCESSOR;
 		}
 
-		int8_t errorNumber = registration->executeAction(&action);
+		int8_t errorNumber = registration.executeAction(&action);
 		releaseProtocol(&action);
 
-		if (registration->isQueryProtocol)
+		if (registration.isQueryProtocol)
 			return 0;
 
-		ProtocolData pDataLanAnswer = {NULL, 0};
+		LanAnswer answer;
 		if (errorNumber == 0) {
-			LanAnswer answer = createLanResonse(requestId);
-			if (translateLanAnswer(&answer, &pDataLanAnswer) != 0) {
-				releaseProtocolData(&pDataLanAnswer);
-				return TUXP_ERROR_FAILED_TO_TRANSLATE_ANSWER;
-			}
+			answer = createLanResonse(requestId);
 		} else {
-			LanAnswer answer = createLanError(requestId, errorNumber);
-
-			if(translateLanAnswer(&answer, &pDataLanAnswer) != 0) {
-				releaseProtocolData(&pDataLanAnswer);
-				return TUXP_ERROR_FAILED_TO_TRANSLATE_ANSWER;
-			}
+			answer = createLanError(requestId, errorNumber);
 		}
 
+		int frameSize = encodeLanAnswer(&answer, txBuff, sizeof(txBuff), SIZE_RADIO_ADDRESS);
+		if (frameSize < 0)
+			return TUXP_ERROR_FAILED_TO_TRANSLATE_ANSWER;
+
 		RadioAddress chosen;
 		chooseUplinkAddress(chosen);
-		sendAndRelease(chosen, &pDataLanAnswer);
+		sendTxFrame(chosen, frameSize);
 		return 0;
 	} else {
 		Protocol protocol;
@@ -554,18 +914,18 @@ int processProtocol(uint8_t data[], int size) {
 			return result;
 		}
 
-		ExecutionProtocolRegistration *registration = getExecutionProtocolRegistration(protocol.name);
-		if (!registration) {
+		ExecutionProtocolRegistration registration;
+		if (!findExecutionProtocol(protocol.name, &registration)) {
 			releaseProtocol(&protocol);
 			return TUXP_ERROR_UNKNOWN_PROTOCOL_NAME;
 		}
 
-		if (!registration->executeAction) {
+		if (!registration.executeAction) {
 			releaseProtocol(&protocol);
 			return TUXP_ERROR_NO_REGISTRATED_PROCESSOR;
 		}
 
-		registration->executeAction(&protocol);
+		registration.executeAction(&protocol);
 		releaseProtocol(&protocol);
 
 		return 0;
@@ -595,9 +955,14 @@ int allocated(int uplinkChannelBegin, int uplinkChannelEnd, uint8_t uplinkAddres
 	thingInfo.uplinkAddressHighByte = uplinkAddressHighByte;
 	thingInfo.uplinkAddressLowByte = uplinkAddressLowByte;
 
-	thingInfo.address = malloc(sizeof(uint8_t) * allocatedAddress[0]);
+#ifdef MUD_NO_HEAP
+	if (allocatedAddress[0] != SIZE_RADIO_ADDRESS)
+		return TUXP_ERROR_ILLEGAL_ALLOCATED_ADDRESS;
+#else
+	thingInfo.address = tuxpAlloc(sizeof(uint8_t) * allocatedAddress[0], ALLOCATION_SITE_THING_INFO);
 	if (!thingInfo.address)
 		return TUXP_ERROR_OUT_OF_MEMEORY;
+#endif
 	memcpy(thingInfo.address, allocatedAddress + 1, allocatedAddress[0]);
 
 	thingInfo.dacState = ALLOCATED;
@@ -645,6 +1010,19 @@ int processAllocation(Protocol *allocation) {
 	if (allocatedAddress[0] != SIZE_RADIO_ADDRESS)
 		return TUXP_ERROR_ILLEGAL_ALLOCATED_ADDRESS;
 
+	uint8_t protocolFormat;
+	if (getRbsAttributeValue(allocation, NAME_ATTRIBUTE_PROTOCOL_FORMAT_TUXP_PROTOCOL_ALLOCATION, &protocolFormat) &&
+			protocolFormat == preferredProtocolFormat)
+		setProtocolFormat(protocolFormat);
+
+	// Rules only hold for the format agreed on above.
+	initCompressionContext(&compressionContext, getProtocolFormat());
+	uint8_t *compressionRules = getBytesAttributeValue(allocation,
+		NAME_ATTRIBUTE_COMPRESSION_RULES_TUXP_PROTOCOL_ALLOCATION);
+	if (preferredHeaderCompression && compressionRules &&
+			decodeCompressionRules(&compressionContext, compressionRules + 1, compressionRules[0]) != 0)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
 	return allocated(uplinkChannelBegin, uplinkChannelEnd,
 		uplinkAddress[1], uplinkAddress[2], allocatedAddress);
 }
@@ -660,7 +1038,9 @@ void processNotConfigured() {
 	thingInfo.uplinkChannelEnd = -1;
 	thingInfo.uplinkAddressHighByte = 0xff;
 	thingInfo.uplinkAddressLowByte = 0xff;
-	thingInfo.address = NULL;
+	clearThingAddress();
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+	initCompressionContext(&compressionContext, PROTOCOL_FORMAT_ESCAPED);
 	thingInfo.dacState = INITIAL;
 
 	saveThingInfo(&thingInfo);
@@ -757,52 +1137,45 @@ int processReceivedData(uint8_t data[], int dataSize) {
 	DEBUG_OUT("enter processReceivedData.");
 #endif
 
-	if(dataSize > MAX_SIZE_PROTOCOL_DATA * 2)
-		return TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE;
+	// Every frame in the data is processed, the first error is returned.
+	int result = 0;
+	bool processed = false;
+	int position = 0;
+	while (position < dataSize) {
+		int frameSize = reassembleFrame(&frameReassembler, data, dataSize, &position);
+		if (frameSize == 0)
+			break;
 
-	if(messagesLength + dataSize > MAX_SIZE_PROTOCOL_DATA * 2) {
-		cleanMessages();
-		return TUXP_ERROR_MESSAGES_BUFF_OVERFLOW;
-	}
-
-	memcpy(messages + messagesLength, data, dataSize);
-	messagesLength += dataSize;
-
-	int protocolStartPosition = findProtocolStartPosition();
-	if(protocolStartPosition == -1) {
-		cleanMessages();
-		return TUXP_ERROR_ABANDON_MALFORMED_DATA;
-	}
+		if (frameSize < 0) {
+			if (result == 0)
+				result = frameSize;
 
-	int protocolEndPosition = findProtocolEndPosition(protocolStartPosition);
-	if(protocolEndPosition == -1)
-		return TUXP_ERROR_WAITING_DATA;
+			continue;
+		}
 
 #if defined(ARDUINO) && defined(ENABLE_DEBUG)
-	Serial.println(F("Found a protocol. Process it."));
+		Serial.println(F("Found a protocol. Process it."));
 #else
-	DEBUG_OUT("Found a protocol. Process it.");
+		DEBUG_OUT("Found a protocol. Process it.");
 #endif
-	
-	int protocolSize = protocolEndPosition - protocolStartPosition + 1;
-	uint8_t protocolData[MAX_SIZE_PROTOCOL_DATA];
-	memcpy(protocolData, messages + protocolStartPosition, protocolSize);
 
-	if(protocolEndPosition == messagesLength - 1) {
-		cleanMessages();
-	} else {
-		messagesLength = messagesLength - (protocolEndPosition + 1);
-		memcpy(messages, messages + protocolEndPosition + 1, messagesLength);
-	}
+		// The frame stays in the reassembler until it's fed again.
+		int frameResult;
+		if (thingInfo.dacState == CONFIGURED) {
+			frameResult = processAsAThing(frameReassembler.frame, frameSize);
+		} else {
+			frameResult = processDac(frameReassembler.frame, frameSize);
+		}
 
-	int result;
-	if (thingInfo.dacState == CONFIGURED) {
-		result = processAsAThing(protocolData, protocolSize);
-	} else {
-		result = processDac(protocolData, protocolSize);
+		if (result == 0)
+			result = frameResult;
+		processed = true;
 	}
 
-	return result;
+	if (processed || result != 0)
+		return result;
+
+	return isReassemblingFrame(&frameReassembler) ? TUXP_ERROR_WAITING_DATA : TUXP_ERROR_ABANDON_MALFORMED_DATA;
 }
 
 int notify(TinyId requestId, Protocol *event) {
@@ -814,16 +1187,13 @@ int notify(TinyId requestId, Protocol *event) {
 	if (!amIAThing())
 		return debugErrorAndReturn("notify", THING_ERROR_NOT_A_THING_YET);
 
-	ProtocolData pData = {NULL, 0};
-	int result = translateLanNotification(requestId,  event, false, &pData);
-	if (result != 0) {
-		releaseProtocolData(&pData);
-		return debugErrorDetailAndReturn("notify", THING_ERROR_PROTOCOL_TRANSLATION, result);
-	}
+	int frameSize = encodeLanNotification(requestId, event, false, txBuff, sizeof(txBuff), SIZE_RADIO_ADDRESS);
+	if (frameSize < 0)
+		return debugErrorDetailAndReturn("notify", THING_ERROR_PROTOCOL_TRANSLATION, frameSize);
 
 	RadioAddress chosen;
 	chooseUplinkAddress(chosen);
-	sendAndRelease(chosen, &pData);
+	sendTxFrame(chosen, compressTxFrame(frameSize));
 
 	return 0;
 }
@@ -842,16 +1212,13 @@ int report(TinyId requestId, Protocol *data) {
 	if(!amIAThing())
 		return debugErrorAndReturn("report", THING_ERROR_NOT_A_THING_YET);
 
-	ProtocolData pData = {NULL, 0};
-	int result = translateLanReport(requestId, data, false, &pData);
-	if(result != 0) {
-		releaseProtocolData(&pData);
-		return debugErrorDetailAndReturn("report", THING_ERROR_PROTOCOL_TRANSLATION, result);
-	}
+	int frameSize = encodeLanReport(requestId, data, false, txBuff, sizeof(txBuff), SIZE_RADIO_ADDRESS);
+	if (frameSize < 0)
+		return debugErrorDetailAndReturn("report", THING_ERROR_PROTOCOL_TRANSLATION, frameSize);
 
 	RadioAddress chosen;
 	chooseUplinkAddress(chosen);
-	sendAndRelease(chosen, &pData);
+	sendTxFrame(chosen, compressTxFrame(frameSize));
 
 	return 0;
 }
@@ -866,26 +1233,34 @@ long getNextRexTime(int lanId, long elapsedTime) {
 
 
 ExecutionProtocolRegistration *getExecutionProtocolRegistration(ProtocolName name) {
-	ExecutionProtocolRegistration *current = executionProtocolRegistrations;
-	while(current) {
-		if(current->name.ns[0] == name.ns[0] &&
-			current->name.ns[1] == name.ns[1] &&
-			current->name.localName == name.localName) {
-
-			return current;
-		}
-
-		current = current->next;
-	}
-
-	return NULL;
+	return registryGet(&executionProtocolRegistrations, name);
 }
 
 void setRadioDataReceivingInterval(long interval) {
 	radioDataReceivingInterval = interval;
 }
 
+static int receiveAndProcessRadioDataRing() {
+	// Bytes the UART adds meanwhile wait for the next call.
+	int available = ringAvailable(radioDataRing);
+	int result = 0;
+	while (available > 0) {
+		int size = ringTakeBytes(radioDataRing, receivedRadioData,
+			available < MAX_SIZE_PROTOCOL_DATA ? available : MAX_SIZE_PROTOCOL_DATA);
+		available -= size;
+
+		int chunkResult = processReceivedData(receivedRadioData, size);
+		if (result == 0 && chunkResult != TUXP_ERROR_WAITING_DATA)
+			result = chunkResult;
+	}
+
+	return result;
+}
+
 int receiveAndProcessRadioData() {
+	if (radioDataRing)
+		return receiveAndProcessRadioDataRing();
+
 	long currentTime = getTime();
 	if(lastRadioDataReceivingTime != 0 &&
 		(currentTime - lastRadioDataReceivingTime) < radioDataReceivingInterval) {
@@ -901,41 +1276,141 @@ int receiveAndProcessRadioData() {
 	return processReceivedData(receivedRadioData, receivedRadioDataSize);
 }
 
-int doReport() {
-	if (!reportProtocolRegistrations)
-		return 0;
+static void closeReportBatch(ReportState *reportState) {
+	deleteReportBatch(reportState->batch);
+	reportState->batch = NULL;
+	reportState->batchedSamples = 0;
+}
 
-	ReportProtocolRegistration *current = reportProtocolRegistrations;
-	while (current) {
-		ReportState *reportState = getReportState(current->name);
+static int sendReportBatch(ReportState *reportState) {
+	int batchSize = writerEnd(&reportState->batch->writer);
+	if (batchSize >= 0)
+		memcpy(txBuff + SIZE_RADIO_ADDRESS, reportState->batch->frame, batchSize);
+	closeReportBatch(reportState);
+	if (batchSize < 0)
+		return batchSize;
 
-		long currentTime = getTime();
-		if (reportState->lastReportTime != 0 &&
-				(currentTime - reportState->lastReportTime) < current->samplingInterval)
-			continue;
+	RadioAddress chosen;
+	chooseUplinkAddress(chosen);
+	sendTxFrame(chosen, compressTxFrame(SIZE_RADIO_ADDRESS + batchSize));
 
-		Protocol data = createProtocol(current->name);
-		int result = current->acquireData(&data);
-		if (result != 0) {
-			return debugErrorDetailAndReturn("doReport", THING_ERROR_AQUIRE_DATA, result);
-		}
+	return 0;
+}
 
-		reportState->lastReportTime = currentTime;
+static int openReportBatch(ReportState *reportState, long currentTime) {
+	TinyId requestId;
+	int result = makeTinyId(getLanId(), REQUEST, currentTime, requestId);
+	if (result != 0)
+		return THING_ERROR_MAKE_TINY_ID;
 
-		TinyId requestId;
-		result = makeTinyId(getLanId(), REQUEST, currentTime, requestId);
-		if(result != 0)
-			return debugErrorDetailAndReturn("doReport", THING_ERROR_MAKE_TINY_ID, result);
+	reportState->batch = newReportBatch();
+	if (!reportState->batch)
+		return TUXP_ERROR_OUT_OF_MEMEORY;
+
+	result = beginLanReportBatch(&reportState->batch->writer, requestId, false,
+		reportState->batch->frame, MAX_SIZE_PROTOCOL_DATA, 0);
+	if (result != 0)
+		closeReportBatch(reportState);
+
+	return result;
+}
+
+// A sample is written into the report's own batch once acquired, batches of other reports are
+// left open.
+static int batchReport(ReportProtocolRegistration *registration, ReportState *reportState,
+			Protocol *data, long currentTime) {
+	int result;
+	if (!reportState->batch) {
+		result = openReportBatch(reportState, currentTime);
+		if (result != 0)
+			return result;
+	}
+
+	result = addLanReportSample(&reportState->batch->writer, data);
+	if (result == TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE && reportState->batchedSamples > 0) {
+		// The frame is full before the batch is. Send what we have and begin another one.
+		result = sendReportBatch(reportState);
+		if (result != 0)
+			return result;
+
+		result = openReportBatch(reportState, currentTime);
+		if (result != 0)
+			return result;
+
+		result = addLanReportSample(&reportState->batch->writer, data);
+	}
 
-		report(requestId, &data);
+	if (result != 0) {
+		closeReportBatch(reportState);
+		return result;
+	}
+
+	reportState->batchedSamples++;
+	if (reportState->batchedSamples >= registration->batchSize)
+		return sendReportBatch(reportState);
+
+	return 0;
+}
+
+// A report is due again a sampling interval later even if it fails, a sample which can't be
+// acquired is skipped.
+static int runReport(ReportProtocolRegistration *registration, ReportState *reportState, long currentTime) {
+	reportState->nextReportTime = addTime(currentTime, registration->samplingInterval);
+
+	Protocol data = createProtocol(registration->name);
+	int result = registration->acquireData(&data);
+	if (result != 0) {
 		releaseProtocol(&data);
+		return debugErrorDetailAndReturn("doReport", THING_ERROR_AQUIRE_DATA, result);
+	}
+
+	reportState->lastReportTime = currentTime;
+
+	if (registration->batchSize > 1) {
+		result = batchReport(registration, reportState, &data, currentTime);
+		releaseProtocol(&data);
+		if (result != 0)
+			return debugErrorDetailAndReturn("doReport", THING_ERROR_DO_REPORT, result);
 
-		current = current->next;
+		return 0;
 	}
 
+	TinyId requestId;
+	result = makeTinyId(getLanId(), REQUEST, currentTime, requestId);
+	if(result != 0) {
+		releaseProtocol(&data);
+		return debugErrorDetailAndReturn("doReport", THING_ERROR_MAKE_TINY_ID, result);
+	}
+
+	report(requestId, &data);
+	releaseProtocol(&data);
+
 	return 0;
 }
 
+// Only the reports which are due are looked at. Each runs once at most, even if its interval
+// is so short that it's due again already. A report which fails doesn't hold up the others, the
+// first error is returned once they all ran.
+int doReport() {
+	long currentTime = getTime();
+	int firstError = 0;
+	for (int runs = reportScheduleSize; runs > 0; runs--) {
+		ReportState *reportState = reportSchedule[0];
+		if (getTimeDifference(reportState->nextReportTime, currentTime) > 0)
+			break;
+
+		ReportProtocolRegistration registration;
+		readScheduledReportRegistration(reportState, &registration);
+
+		int result = runReport(&registration, reportState, currentTime);
+		siftScheduledReportDown(0);
+		if (result != 0 && firstError == 0)
+			firstError = result;
+	}
+
+	return firstError;
+}
+
 int doWorksAThingShouldDo() {
 	int result = receiveAndProcessRadioData();
 	if(result != 0) {
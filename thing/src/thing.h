@@ -6,6 +6,8 @@
 
 #include "debug.h"
 #include "tuxp.h"
+#include "receive_ring.h"
+#include "protocol_registry.h"
 
 #define THING_ERROR_LACK_OF_HOOKS -1
 #define THING_ERROR_INITIALIZE_RADIO -2
@@ -26,11 +28,39 @@
 #define THING_ERROR_DO_REPORT -17
 #define THING_ERROR_AQUIRE_DATA -18
 #define THING_ERROR_MAKE_TINY_ID -19
+#define THING_ERROR_UNSORTED_PROTOCOL_TABLE -20
+
+// Registration tables which never change after boot stay in flash on AVR. Declare them as
+// static const ExecutionProtocolRegistration table[] PROTOCOL_TABLE = {...}, sorted by name.
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define PROTOCOL_TABLE PROGMEM
+#else
+#define PROTOCOL_TABLE
+#endif
 
 #define SIZE_RADIO_ADDRESS 3
 #define DAC_SERVICE_ADDRESS {0xef, 0xef, 0x1f}
 #define DAC_CLIENT_ADDRESS {0xef, 0xee, 0x1f}
 
+#ifndef MAX_SIZE_EXECUTION_PROTOCOL_REGISTRATIONS
+#define MAX_SIZE_EXECUTION_PROTOCOL_REGISTRATIONS 8
+#endif
+
+#ifndef MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS
+#define MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS 4
+#endif
+
+// Report protocols registered one by one and in a table together.
+#ifndef MAX_SIZE_SCHEDULED_REPORTS
+#define MAX_SIZE_SCHEDULED_REPORTS (MAX_SIZE_REPORT_PROTOCOL_REGISTRATIONS + 8)
+#endif
+
+// Batched reports which have samples waiting at once. Each batch holds a frame.
+#ifndef MAX_SIZE_REPORT_BATCHES
+#define MAX_SIZE_REPORT_BATCHES 2
+#endif
+
 typedef uint8_t RadioAddress[SIZE_RADIO_ADDRESS];
 
 typedef enum {
@@ -49,27 +79,35 @@ typedef struct {
 	int uplinkChannelEnd;
 	uint8_t uplinkAddressHighByte;
 	uint8_t uplinkAddressLowByte;
+#ifdef MUD_NO_HEAP
+	RadioAddress address;
+#else
 	uint8_t *address;
+#endif
 } ThingInfo;
 
 typedef struct ExecutionProtocolRegistration {
 	ProtocolName name;
 	int8_t (*executeAction)(Protocol *);
 	bool isQueryProtocol;
-	struct ExecutionProtocolRegistration *next;
 } ExecutionProtocolRegistration;
 
 typedef struct ReportProtocolRegistration {
 	ProtocolName name;
 	int8_t (*acquireData)(Protocol *);
 	long samplingInterval;
-	struct ReportProtocolRegistration *next;
+	uint8_t batchSize;
 } ReportProtocolRegistration;
 
+struct ReportBatch;
+
+// What changes of a report protocol. A table's states are kept in an array in step with the table.
+// A batched report has a batch only while it has samples waiting.
 typedef struct ReportState {
-	ProtocolName name;
 	long lastReportTime;
-	struct ReportState *next;
+	long nextReportTime;
+	uint8_t batchedSamples;
+	struct ReportBatch *batch;
 } ReportState;
 
 typedef struct {
@@ -89,18 +127,38 @@ void registerThingInfoLoader(void (*loadThingInfo)(ThingInfo *thingInfo));
 void registerThingInfoSaver(void (*saveThingInfo)(ThingInfo *thingInfo));
 void registerThingProtocolsConfigurer(void (*configureThingProtocols)());
 void registerRadioDataSender(void (*sendRadioData)(RadioAddress address, uint8_t data[], int dataSize));
+void registerRadioFrameSender(void (*sendRadioFrame)(uint8_t frame[], int frameSize));
 void registerRadioDataReceiver(int (*receiveRadioData)(uint8_t buff[], int buffSize));
+// Takes radio data from a ring the UART fills instead, on every call of doWorksAThingShouldDo().
+void registerRadioDataRing(ReceiveRing *ring);
+#ifdef MUD_FRAGMENTATION
+// Reassembling fragments takes SIZE_REASSEMBLY_SLOTS * MAX_SIZE_FRAGMENTED_DATA bytes, so things
+// only receive them when built with MUD_FRAGMENTATION.
+void registerFragmentedDataProcessor(void (*processFragmentedData)(TinyId tinyId, const uint8_t data[], int dataSize));
+#endif
 void unregisterThingHooks();
+void setPreferredProtocolFormat(ProtocolFormat format);
+void setPreferredHeaderCompression(bool headerCompression);
 
-void registerExecutionProtocol(ProtocolName name,
+int registerExecutionProtocol(ProtocolName name,
 	int8_t (*executeAction)(Protocol *), bool isQueryProtocol);
 bool unregisterExecutionProtocol(ProtocolName name);
+// Only finds protocols registered one by one, not the ones in a table.
 ExecutionProtocolRegistration *getExecutionProtocolRegistration(ProtocolName name);
+int registerExecutionProtocolTable(const ExecutionProtocolRegistration table[], uint8_t size);
 
-void registerReportProtocol(ProtocolName name, int8_t (*aquireData)(Protocol *),
+int registerReportProtocol(ProtocolName name, int8_t (*aquireData)(Protocol *),
 	long samplingInterval);
+int registerBatchedReportProtocol(ProtocolName name, int8_t (*aquireData)(Protocol *),
+	long samplingInterval, uint8_t batchSize);
 bool unregisterReportProtocol(ProtocolName name);
+// The states of the table's protocols are kept in states, which has an element for each of them.
+int registerReportProtocolTable(const ReportProtocolRegistration table[], ReportState states[], uint8_t size);
+// NULL if the protocol isn't registered.
 ReportState *getReportState(ProtocolName name);
+// How long until the earliest report is due, 0 if it's due already, so the loop knows how long it
+// may sleep. false if there are no reports.
+bool getNextReportDeadline(long *timeLeft);
 
 int toBeAThing();
 bool amIAThing();
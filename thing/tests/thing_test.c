@@ -1,15 +1,28 @@
+#include <limits.h>
 #include <string.h>
 #include <time.h>
 
 #include "unity.h"
 
 #include "thing.h"
+#include "native_values.h"
+#include "allocator.h"
+#ifdef MUD_FRAGMENTATION
+#include "fragmentation.h"
+#endif
+
+// 14 as addIntAttribute() encodes it.
+#ifdef TUXP_NATIVE_NUMBERS
+#define ENCODED_INT_14 0xfd, TAG_VARINT_TYPE, 0x1c
+#else
+#define ENCODED_INT_14 0x31, 0x34
+#endif
 
 static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
 #define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
 
 static const char *thingId = "SL-LE01-C980AFE9";
-static ThingInfo thingInfoInStorage = {NULL, NONE, -1, -1, 0xff, 0xff, NULL};
+static ThingInfo thingInfoInStorage = {NULL, NONE, -1, -1, 0xff, 0xff};
 static int resetTimes = 0;
 static DacState dacState = INITIAL;
 static const uint8_t dacServiceAddress[] = {0xef, 0xef, 0x1f};
@@ -19,7 +32,10 @@ static const uint8_t gatewayUplinkAddress[] = {0x00, 0x00, 0x17};
 static uint8_t nodeAddress[] = {0x00, 0x00, 0x00};
 
 static bool flashExecuted = false;
+static int flashExecutedTimes = 0;
 static int lanAnswerTimes = 0;
+// Counted apart from lanAnswerTimes once it's not negative.
+static int burstAnswerTimes = -1;
 
 void resetImpl() {}
 
@@ -50,6 +66,7 @@ int8_t executeFlash(Protocol *protocol) {
 
 	if (repeat == 5) {
 		flashExecuted = true;
+		flashExecutedTimes++;
 		return 0;
 	}
 	
@@ -59,6 +76,18 @@ int8_t executeFlash(Protocol *protocol) {
 	return -1;
 }
 
+static int blinkExecutedTimes = 0;
+
+int8_t executeBlink(Protocol *protocol) {
+	(void)protocol;
+	blinkExecutedTimes++;
+	return 0;
+}
+
+int8_t acquireTemperature(Protocol *protocol) {
+	return addFloatAttribute(protocol, 0x01, 21.5f);
+}
+
 void configureThingProtocolsImpl() {
 	ProtocolName flashProtocolName = {{0xf7, 0x01}, 0x00};
 	registerExecutionProtocol(flashProtocolName, executeFlash, false);
@@ -71,12 +100,20 @@ void loadThingInfoImpl(ThingInfo *thingInfo) {
 	thingInfo->uplinkChannelEnd = thingInfoInStorage.uplinkChannelEnd;
 	thingInfo->uplinkAddressHighByte = thingInfoInStorage.uplinkAddressHighByte;
 	thingInfo->uplinkAddressLowByte = thingInfoInStorage.uplinkAddressLowByte;
+#ifdef MUD_NO_HEAP
+	memcpy(thingInfo->address, thingInfoInStorage.address, SIZE_RADIO_ADDRESS);
+#else
 	thingInfo->address = thingInfoInStorage.address;
+#endif
 }
 
 void saveThingInfoImpl(ThingInfo *thingInfo) {
 	thingInfoInStorage.thingId = thingInfo->thingId;
+#ifdef MUD_NO_HEAP
+	memcpy(thingInfoInStorage.address, thingInfo->address, SIZE_RADIO_ADDRESS);
+#else
 	thingInfoInStorage.address = thingInfo->address;
+#endif
 	thingInfoInStorage.uplinkChannelBegin = thingInfo->uplinkChannelBegin;
 	thingInfoInStorage.uplinkChannelEnd = thingInfo->uplinkChannelEnd;
 	thingInfoInStorage.uplinkAddressHighByte = thingInfo->uplinkAddressHighByte;
@@ -208,11 +245,17 @@ void sendToGatewayMock4(uint8_t address[], uint8_t data[], int dataSize) {
 	ProtocolData pData = {data, dataSize};
 	TEST_ASSERT_TRUE(isLanAnswer(&pData));
 
-	lanAnswerTimes++;
-
 	LanAnswer answer;
 	TEST_ASSERT_EQUAL(0, parseLanAnswer(&pData, &answer));
 
+	if (burstAnswerTimes >= 0) {
+		burstAnswerTimes++;
+		TEST_ASSERT_TRUE(isResponseTinyId(answer.traceId));
+		return;
+	}
+
+	lanAnswerTimes++;
+
 	if (lanAnswerTimes == 1) {
 		TEST_ASSERT_TRUE(isResponseTinyId(answer.traceId));
 	} else if (lanAnswerTimes == 2) {
@@ -290,6 +333,15 @@ void tearDown() {
 	resetTimes++;
 }
 
+static void assertNoAddress(ThingInfo *thingInfo) {
+#ifdef MUD_NO_HEAP
+	uint8_t noAddress[SIZE_RADIO_ADDRESS] = {0};
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(noAddress, thingInfo->address, SIZE_RADIO_ADDRESS);
+#else
+	TEST_ASSERT_NULL(thingInfo->address);
+#endif
+}
+
 void testLoraDacAllocated() {
 	ThingInfo thingInfo;
 	loadThingInfoImpl(&thingInfo);
@@ -299,7 +351,7 @@ void testLoraDacAllocated() {
 	TEST_ASSERT_EQUAL_INT(-1,thingInfo.uplinkChannelEnd);
 	TEST_ASSERT_EQUAL_INT8(0xff, thingInfo.uplinkAddressHighByte);
 	TEST_ASSERT_EQUAL_INT8(0xff, thingInfo.uplinkAddressLowByte);
-	TEST_ASSERT_NULL(thingInfo.address);
+	assertNoAddress(&thingInfo);
 
 	TEST_ASSERT_EQUAL(0, toBeAThing());
 
@@ -331,7 +383,7 @@ void testLoraDacNotConfigured() {
 	TEST_ASSERT_EQUAL_INT(-1, thingInfo.uplinkChannelEnd);
 	TEST_ASSERT_EQUAL_UINT8(0xff, thingInfo.uplinkAddressHighByte);
 	TEST_ASSERT_EQUAL_UINT8(0xff,thingInfo.uplinkAddressLowByte);
-	TEST_ASSERT_NULL(thingInfo.address);
+	assertNoAddress(&thingInfo);
 
 	TEST_ASSERT_EQUAL_UINT8_ARRAY(dacClientAddress, nodeAddress, 3);
 }
@@ -397,7 +449,7 @@ void testExecuteFlashAction() {
 			0xf8, 0x04, 0x05, 0x01, 0x01,
 				0x06, 0xfb, 0x00, 0x0b, 0x17, 0xd3, 0xe5, 0xfe,
 				0xf7, 0x01, 0x00, 0x01, 0x00,
-					0x01, 0x31, 0x34,
+					0x01, ENCODED_INT_14,
 		0xff
 	};
 	TEST_ASSERT_EQUAL(sizeof(expectedLanExecutionData), pDataProtocolWithErrorAttribute.dataSize);
@@ -417,6 +469,390 @@ void testExecuteFlashAction() {
 	releaseProtocolData(&pDataProtocolWithErrorAttribute);
 }
 
+void testProcessFramesInOneChunk() {
+	TEST_ASSERT_EQUAL(0, toBeAThing());
+
+	TinyId requestId;
+	if(makeTinyId(0, REQUEST, 12 * (60 * 60 * 1000), requestId) != 0)
+		TEST_FAIL_MESSAGE("Failed to create things tiny ID.");
+
+	Protocol flash = createProtocol(NAME_PROTOCOL_FLASH);
+	TEST_ASSERT_EQUAL(0, addIntAttribute(&flash, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5));
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL(0, translateLanExecution(requestId, &flash, &pData));
+	releaseProtocol(&flash);
+
+	// Noise, three frames and the beginning of a fourth one.
+	uint8_t data[MAX_SIZE_PROTOCOL_DATA * 4];
+	data[0] = 0x31;
+	for (int i = 0; i < 4; i++)
+		memcpy(data + 1 + i * pData.dataSize, pData.data, pData.dataSize);
+
+	flashExecutedTimes = 0;
+	burstAnswerTimes = 0;
+	TEST_ASSERT_EQUAL_INT(0, processReceivedData(data, 1 + 3 * pData.dataSize + 4));
+	TEST_ASSERT_EQUAL_INT(3, flashExecutedTimes);
+	TEST_ASSERT_EQUAL_INT(3, burstAnswerTimes);
+
+	TEST_ASSERT_EQUAL_INT(0, processReceivedData(data + 1 + 3 * pData.dataSize + 4, pData.dataSize - 4));
+	TEST_ASSERT_EQUAL_INT(4, flashExecutedTimes);
+
+	// From a ring the UART fills, a frame split across two calls.
+	ReceiveRing ring;
+	initReceiveRing(&ring);
+	registerRadioDataRing(&ring);
+	ringPutBytes(&ring, pData.data, 6);
+	TEST_ASSERT_EQUAL_INT(0, doWorksAThingShouldDo());
+	ringPutBytes(&ring, pData.data + 6, pData.dataSize - 6);
+	TEST_ASSERT_EQUAL_INT(0, doWorksAThingShouldDo());
+	TEST_ASSERT_EQUAL_INT(5, flashExecutedTimes);
+	registerRadioDataRing(NULL);
+	burstAnswerTimes = -1;
+
+	releaseProtocolData(&pData);
+}
+
+void testProtocolTables() {
+	static const ExecutionProtocolRegistration unsortedExecutions[] PROTOCOL_TABLE = {
+		{{{0xf7, 0x01}, 0x03}, executeBlink, false},
+		{{{0xf7, 0x01}, 0x02}, executeBlink, false}
+	};
+	TEST_ASSERT_EQUAL_INT(THING_ERROR_UNSORTED_PROTOCOL_TABLE,
+		registerExecutionProtocolTable(unsortedExecutions, 2));
+
+	static const ExecutionProtocolRegistration executions[] PROTOCOL_TABLE = {
+		{{{0xf7, 0x01}, 0x00}, executeBlink, false},
+		{{{0xf7, 0x01}, 0x02}, executeBlink, false},
+		{{{0xf7, 0x01}, 0x03}, executeBlink, true}
+	};
+	TEST_ASSERT_EQUAL_INT(0, registerExecutionProtocolTable(executions, 3));
+
+	static const ReportProtocolRegistration reports[] PROTOCOL_TABLE = {
+		{{{0xf7, 0x02}, 0x01}, acquireTemperature, 60 * 1000, 1},
+		{{{0xf7, 0x02}, 0x02}, acquireTemperature, 60 * 1000, 4}
+	};
+	ReportState reportStates[2];
+	TEST_ASSERT_EQUAL_INT(0, registerReportProtocolTable(reports, reportStates, 2));
+	ProtocolName temperatures = {{0xf7, 0x02}, 0x02};
+	TEST_ASSERT_EQUAL_PTR(reportStates + 1, getReportState(temperatures));
+
+	TinyId requestId;
+	if(makeTinyId(0, REQUEST, 13 * (60 * 60 * 1000), requestId) != 0)
+		TEST_FAIL_MESSAGE("Failed to create things tiny ID.");
+
+	// Flash was registered on its own, which comes before the table.
+	ProtocolName names[] = {{{0xf7, 0x01}, 0x02}, {{0xf7, 0x01}, 0x00}, {{0xf7, 0x01}, 0x03}};
+	blinkExecutedTimes = 0;
+	flashExecutedTimes = 0;
+	burstAnswerTimes = 0;
+	for (int i = 0; i < 3; i++) {
+		Protocol action = createProtocol(names[i]);
+		TEST_ASSERT_EQUAL(0, addIntAttribute(&action, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5));
+
+		ProtocolData pData;
+		TEST_ASSERT_EQUAL(0, translateLanExecution(requestId, &action, &pData));
+		TEST_ASSERT_EQUAL_INT(0, processReceivedData(pData.data, pData.dataSize));
+		releaseProtocolData(&pData);
+		releaseProtocol(&action);
+	}
+
+	TEST_ASSERT_EQUAL_INT(2, blinkExecutedTimes);
+	TEST_ASSERT_EQUAL_INT(1, flashExecutedTimes);
+	// No answer to the query protocol.
+	TEST_ASSERT_EQUAL_INT(2, burstAnswerTimes);
+	burstAnswerTimes = -1;
+
+	registerExecutionProtocolTable(NULL, 0);
+	registerReportProtocolTable(NULL, NULL, 0);
+}
+
+int doReport();
+
+static long scheduleTime;
+static int reportFramesSent;
+// Samples in each report frame sent, counted from its children.
+static int reportFrameSamples[4];
+
+long getScheduleTime() {
+	return scheduleTime;
+}
+
+void sendReportMock(uint8_t address[], uint8_t data[], int dataSize) {
+	(void)address;
+	ProtocolData pData = {data, dataSize};
+	LanEnvelope envelope;
+	TEST_ASSERT_EQUAL_INT(0, decodeLanEnvelope(&pData, &envelope));
+	TEST_ASSERT_EQUAL_INT(LAN_ENVELOPE_REPORT, envelope.type);
+
+	int samples = 0;
+	ChildViewIterator iterator = viewChildren(&envelope.view);
+	ProtocolView sample;
+	while (viewNextChild(&iterator, &sample))
+		samples++;
+
+	if (reportFramesSent < (int)(sizeof(reportFrameSamples) / sizeof(reportFrameSamples[0])))
+		reportFrameSamples[reportFramesSent] = samples;
+	reportFramesSent++;
+}
+
+void testScheduleReports() {
+	registerTimer(getScheduleTime);
+	registerRadioDataSender(sendReportMock);
+	scheduleTime = 1000;
+	reportFramesSent = 0;
+	long timeLeft;
+	TEST_ASSERT_FALSE(getNextReportDeadline(&timeLeft));
+
+	ProtocolName temperature = {{0xf7, 0x02}, 0x01};
+	ProtocolName humidity = {{0xf7, 0x02}, 0x02};
+	TEST_ASSERT_EQUAL_INT(0, registerBatchedReportProtocol(temperature, acquireTemperature, 60 * 1000, 4));
+	TEST_ASSERT_EQUAL_INT(0, registerBatchedReportProtocol(humidity, acquireTemperature, 30 * 1000, 4));
+	// New reports are due at once.
+	TEST_ASSERT_TRUE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(0, timeLeft);
+
+	// Each report collects samples in its own batch.
+	TEST_ASSERT_EQUAL_INT(0, doReport());
+	ReportState *temperatureState = getReportState(temperature);
+	ReportState *humidityState = getReportState(humidity);
+	TEST_ASSERT_EQUAL_INT(0, reportFramesSent);
+	TEST_ASSERT_EQUAL_INT(1, temperatureState->batchedSamples);
+	TEST_ASSERT_EQUAL_INT(1, humidityState->batchedSamples);
+	TEST_ASSERT_EQUAL_INT(61 * 1000, temperatureState->nextReportTime);
+	TEST_ASSERT_TRUE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(30 * 1000, timeLeft);
+
+	// Nothing is due yet.
+	scheduleTime = 30 * 1000;
+	TEST_ASSERT_EQUAL_INT(0, doReport());
+	TEST_ASSERT_EQUAL_INT(1, humidityState->batchedSamples);
+
+	// Only humidity is.
+	scheduleTime = 31 * 1000;
+	TEST_ASSERT_EQUAL_INT(0, doReport());
+	TEST_ASSERT_EQUAL_INT(0, reportFramesSent);
+	TEST_ASSERT_EQUAL_INT(1, temperatureState->batchedSamples);
+	TEST_ASSERT_EQUAL_INT(2, humidityState->batchedSamples);
+	TEST_ASSERT_TRUE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(30 * 1000, timeLeft);
+
+	// The samples collected so far are sent, not dropped.
+	TEST_ASSERT_TRUE(unregisterReportProtocol(temperature));
+	TEST_ASSERT_NULL(getReportState(temperature));
+	TEST_ASSERT_EQUAL_INT(1, reportFramesSent);
+	TEST_ASSERT_TRUE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(30 * 1000, timeLeft);
+	TEST_ASSERT_TRUE(unregisterReportProtocol(humidity));
+	TEST_ASSERT_FALSE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(2, reportFramesSent);
+
+
+	registerTimer(getTimeImpl);
+}
+
+void testBatchReportSamples() {
+	registerTimer(getScheduleTime);
+	registerRadioDataSender(sendReportMock);
+	scheduleTime = 1000;
+	reportFramesSent = 0;
+
+	ProtocolName temperature = {{0xf7, 0x02}, 0x01};
+	TEST_ASSERT_EQUAL_INT(0, registerBatchedReportProtocol(temperature, acquireTemperature, 10 * 1000, 3));
+	ReportState *temperatureState = getReportState(temperature);
+
+	for (int i = 0; i < 3; i++) {
+		TEST_ASSERT_EQUAL_INT(0, doReport());
+		scheduleTime += 10 * 1000;
+		if (i < 2) {
+			TEST_ASSERT_EQUAL_INT(0, reportFramesSent);
+			TEST_ASSERT_EQUAL_INT(i + 1, temperatureState->batchedSamples);
+		}
+	}
+
+	// One frame for the whole batch.
+	TEST_ASSERT_EQUAL_INT(1, reportFramesSent);
+	TEST_ASSERT_EQUAL_INT(3, reportFrameSamples[0]);
+	TEST_ASSERT_EQUAL_INT(0, temperatureState->batchedSamples);
+
+	TEST_ASSERT_TRUE(unregisterReportProtocol(temperature));
+	TEST_ASSERT_EQUAL_INT(1, reportFramesSent);
+
+	registerTimer(getTimeImpl);
+}
+
+int8_t acquireLargeSample(Protocol *protocol) {
+	uint8_t bytes[MAX_SIZE_ATTRIBUTE_DATA];
+	memset(bytes, 0x41, sizeof(bytes));
+	return addBytesAttribute(protocol, 0x01, bytes, sizeof(bytes));
+}
+
+void testSplitFullReportFrame() {
+	registerTimer(getScheduleTime);
+	registerRadioDataSender(sendReportMock);
+	scheduleTime = 1000;
+	reportFramesSent = 0;
+
+	ProtocolName samples = {{0xf7, 0x02}, 0x04};
+	TEST_ASSERT_EQUAL_INT(0, registerBatchedReportProtocol(samples, acquireLargeSample, 10 * 1000, 4));
+	ReportState *samplesState = getReportState(samples);
+
+	// Two large samples fill a frame, so the third one begins another frame.
+	TEST_ASSERT_EQUAL_INT(0, doReport());
+	scheduleTime += 10 * 1000;
+	TEST_ASSERT_EQUAL_INT(0, doReport());
+	TEST_ASSERT_EQUAL_INT(0, reportFramesSent);
+	scheduleTime += 10 * 1000;
+	TEST_ASSERT_EQUAL_INT(0, doReport());
+	TEST_ASSERT_EQUAL_INT(1, reportFramesSent);
+	TEST_ASSERT_EQUAL_INT(2, reportFrameSamples[0]);
+	TEST_ASSERT_EQUAL_INT(1, samplesState->batchedSamples);
+
+	TEST_ASSERT_TRUE(unregisterReportProtocol(samples));
+	TEST_ASSERT_EQUAL_INT(2, reportFramesSent);
+	TEST_ASSERT_EQUAL_INT(1, reportFrameSamples[1]);
+
+	registerTimer(getTimeImpl);
+}
+
+int8_t acquireNothing(Protocol *protocol) {
+	addIntAttribute(protocol, 0x01, 0);
+	return -1;
+}
+
+void testFailingReportDoesntHoldUpOthers() {
+	registerTimer(getScheduleTime);
+	registerRadioDataSender(sendReportMock);
+	scheduleTime = 1000;
+	reportFramesSent = 0;
+	long liveBytes = getAllocationStatistics()->liveBytes;
+
+	ProtocolName broken = {{0xf7, 0x02}, 0x03};
+	ProtocolName temperature = {{0xf7, 0x02}, 0x01};
+	TEST_ASSERT_EQUAL_INT(0, registerBatchedReportProtocol(broken, acquireNothing, 10 * 1000, 4));
+	TEST_ASSERT_EQUAL_INT(0, registerBatchedReportProtocol(temperature, acquireTemperature, 30 * 1000, 4));
+	ReportState *brokenState = getReportState(broken);
+	ReportState *temperatureState = getReportState(temperature);
+
+	TEST_ASSERT_EQUAL_INT(THING_ERROR_AQUIRE_DATA, doReport());
+	TEST_ASSERT_EQUAL_INT(1, temperatureState->batchedSamples);
+	TEST_ASSERT_EQUAL_INT(0, brokenState->batchedSamples);
+	TEST_ASSERT_EQUAL_INT(11 * 1000, brokenState->nextReportTime);
+	long timeLeft;
+	TEST_ASSERT_TRUE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(10 * 1000, timeLeft);
+
+	// The broken one is tried again when it's due, not on every call.
+	scheduleTime = 5 * 1000;
+	TEST_ASSERT_EQUAL_INT(0, doReport());
+	scheduleTime = 31 * 1000;
+	TEST_ASSERT_EQUAL_INT(THING_ERROR_AQUIRE_DATA, doReport());
+	TEST_ASSERT_EQUAL_INT(2, temperatureState->batchedSamples);
+	TEST_ASSERT_EQUAL_INT(41 * 1000, brokenState->nextReportTime);
+	TEST_ASSERT_EQUAL_INT(0, reportFramesSent);
+
+	TEST_ASSERT_TRUE(unregisterReportProtocol(broken));
+	TEST_ASSERT_EQUAL_INT(0, reportFramesSent);
+	TEST_ASSERT_TRUE(unregisterReportProtocol(temperature));
+	TEST_ASSERT_EQUAL_INT(1, reportFramesSent);
+	// Neither the data which failed nor the batch is kept.
+	TEST_ASSERT_EQUAL_INT(liveBytes, getAllocationStatistics()->liveBytes);
+
+	registerTimer(getTimeImpl);
+}
+
+#ifdef MUD_FRAGMENTATION
+static FragmentAck sentFragmentAck;
+static int fragmentAcksSent;
+static uint8_t fragmentedData[MAX_SIZE_FRAGMENTED_DATA];
+static int fragmentedDataSize;
+
+void sendFragmentAckMock(uint8_t address[], uint8_t data[], int dataSize) {
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(gatewayUplinkAddress, address, 3);
+
+	ProtocolData pData = {data, dataSize};
+	TEST_ASSERT_TRUE(isFragmentAck(&pData));
+	TEST_ASSERT_EQUAL_INT(0, parseFragmentAck(&pData, &sentFragmentAck));
+
+	fragmentAcksSent++;
+}
+
+void processFragmentedDataImpl(TinyId tinyId, const uint8_t data[], int dataSize) {
+	memcpy(fragmentedData, data, dataSize);
+	fragmentedDataSize = dataSize;
+}
+
+void testReceiveFragments() {
+	TEST_ASSERT_EQUAL(0, toBeAThing());
+	registerRadioDataSender(sendFragmentAckMock);
+	registerFragmentedDataProcessor(processFragmentedDataImpl);
+	fragmentAcksSent = 0;
+	fragmentedDataSize = 0;
+
+	uint8_t data[SIZE_FRAGMENT_PAYLOAD * 2 + 5];
+	for (int i = 0; i < (int)sizeof(data); i++)
+		data[i] = i;
+
+	TinyId tinyId;
+	if(makeTinyId(0, REQUEST, 14 * (60 * 60 * 1000), tinyId) != 0)
+		TEST_FAIL_MESSAGE("Failed to create things tiny ID.");
+
+	FragmentSender sender;
+	TEST_ASSERT_EQUAL_INT(0, beginFragmentSending(&sender, tinyId, data, sizeof(data)));
+	TEST_ASSERT_EQUAL_INT(3, sender.total);
+
+	// Only the last fragment asks for an ack, and the data is passed on once it's complete.
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	for (int i = 0; i < sender.total; i++) {
+		int frameSize = encodeFragment(&sender, i, buff, sizeof(buff), 0);
+		TEST_ASSERT_TRUE(frameSize > 0);
+		TEST_ASSERT_EQUAL_INT(0, processReceivedData(buff, frameSize));
+		TEST_ASSERT_EQUAL_INT(i == sender.total - 1 ? 1 : 0, fragmentAcksSent);
+	}
+
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(tinyId, sentFragmentAck.tinyId, SIZE_THINGS_TINY_ID);
+	TEST_ASSERT_EQUAL_INT(3, sentFragmentAck.total);
+	TEST_ASSERT_EQUAL_HEX32(0x07, sentFragmentAck.receivedFragments);
+	TEST_ASSERT_EQUAL_INT(0, processFragmentAck(&sender, &sentFragmentAck));
+	TEST_ASSERT_TRUE(isFragmentSendingDone(&sender));
+
+	TEST_ASSERT_EQUAL_INT(sizeof(data), fragmentedDataSize);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(data, fragmentedData, sizeof(data));
+
+	releaseReassembly(tinyId);
+	registerFragmentedDataProcessor(NULL);
+}
+#endif
+
+// Such times don't make a tiny ID, so the report acquires nothing. It's scheduled all the same.
+void testReportDeadlineAcrossClockWrap() {
+	registerTimer(getScheduleTime);
+	scheduleTime = LONG_MAX - 5 * 1000;
+
+	ProtocolName broken = {{0xf7, 0x02}, 0x03};
+	TEST_ASSERT_EQUAL_INT(0, registerReportProtocol(broken, acquireNothing, 10 * 1000));
+	TEST_ASSERT_EQUAL_INT(THING_ERROR_AQUIRE_DATA, doReport());
+	long timeLeft;
+	TEST_ASSERT_TRUE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(10 * 1000, timeLeft);
+
+	// Not due yet, although the time it's due is below the current one.
+	scheduleTime = LONG_MIN;
+	TEST_ASSERT_EQUAL_INT(0, doReport());
+	TEST_ASSERT_TRUE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(5 * 1000 - 1, timeLeft);
+
+	scheduleTime = LONG_MIN + 5 * 1000;
+	TEST_ASSERT_EQUAL_INT(THING_ERROR_AQUIRE_DATA, doReport());
+	TEST_ASSERT_TRUE(getNextReportDeadline(&timeLeft));
+	TEST_ASSERT_EQUAL_INT(10 * 1000, timeLeft);
+
+	TEST_ASSERT_TRUE(unregisterReportProtocol(broken));
+	TEST_ASSERT_FALSE(getNextReportDeadline(&timeLeft));
+
+	registerTimer(getTimeImpl);
+}
+
 int main() {
 	UNITY_BEGIN();
 	
@@ -424,6 +860,16 @@ int main() {
 	RUN_TEST(testLoraDacNotConfigured);
 	RUN_TEST(testLoraDacConfigured);
 	RUN_TEST(testExecuteFlashAction);
+	RUN_TEST(testProcessFramesInOneChunk);
+	RUN_TEST(testProtocolTables);
+	RUN_TEST(testScheduleReports);
+	RUN_TEST(testBatchReportSamples);
+	RUN_TEST(testSplitFullReportFrame);
+	RUN_TEST(testFailingReportDoesntHoldUpOthers);
+	RUN_TEST(testReportDeadlineAcrossClockWrap);
+#ifdef MUD_FRAGMENTATION
+	RUN_TEST(testReceiveFragments);
+#endif
 	
 	return UNITY_END();
 }
@@ -0,0 +1,80 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+#include "allocator.h"
+#include "pool_allocator.h"
+
+#ifdef MUD_NO_HEAP
+
+#define defaultAlloc poolAlloc
+#define defaultFree poolFree
+
+#else
+
+static void *defaultAlloc(size_t size, void *context) {
+	(void)context;
+	return malloc(size);
+}
+
+static void defaultFree(void *p, size_t size, void *context) {
+	(void)size;
+	(void)context;
+	free(p);
+}
+
+#endif
+
+static void *(*alloc)(size_t, void *) = defaultAlloc;
+static void (*dealloc)(void *, size_t, void *) = defaultFree;
+static void *allocatorContext = NULL;
+
+static AllocationStatistics statistics;
+
+void tuxpSetAllocator(void *(*_alloc)(size_t size, void *context),
+			void (*_free)(void *p, size_t size, void *context), void *context) {
+	if (_alloc && _free) {
+		alloc = _alloc;
+		dealloc = _free;
+		allocatorContext = context;
+	} else {
+		alloc = defaultAlloc;
+		dealloc = defaultFree;
+		allocatorContext = NULL;
+	}
+}
+
+void *tuxpAlloc(size_t size, AllocationSite site) {
+	void *p = alloc(size, allocatorContext);
+	if (!p) {
+		statistics.failedAllocations++;
+		return NULL;
+	}
+
+	statistics.allocations[site]++;
+	statistics.liveBytes += size;
+	if (statistics.liveBytes > statistics.peakBytes)
+		statistics.peakBytes = statistics.liveBytes;
+
+	return p;
+}
+
+void tuxpFree(void *p, size_t size) {
+	if (!p)
+		return;
+
+	dealloc(p, size, allocatorContext);
+	statistics.liveBytes -= size;
+}
+
+const AllocationStatistics *getAllocationStatistics() {
+	return &statistics;
+}
+
+void resetAllocationStatistics() {
+	long liveBytes = statistics.liveBytes;
+
+	memset(&statistics, 0, sizeof(AllocationStatistics));
+	statistics.liveBytes = liveBytes;
+	statistics.peakBytes = liveBytes;
+}
@@ -0,0 +1,33 @@
+#ifndef MUD_ALLOCATOR_H
+#define MUD_ALLOCATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+	ALLOCATION_SITE_ATTRIBUTE_VALUE,
+	ALLOCATION_SITE_TEXT,
+	ALLOCATION_SITE_PROTOCOL_DATA,
+	ALLOCATION_SITE_ESCAPED_DATA,
+	ALLOCATION_SITE_REGISTRATION,
+	ALLOCATION_SITE_THING_INFO,
+	ALLOCATION_SITE_CHILD_PROTOCOL,
+	ALLOCATION_SITE_REPORT_BATCH,
+	SIZE_ALLOCATION_SITES
+} AllocationSite;
+
+typedef struct {
+	long liveBytes;
+	long peakBytes;
+	long allocations[SIZE_ALLOCATION_SITES];
+	long failedAllocations;
+} AllocationStatistics;
+
+void tuxpSetAllocator(void *(*alloc)(size_t size, void *context),
+	void (*free)(void *p, size_t size, void *context), void *context);
+void *tuxpAlloc(size_t size, AllocationSite site);
+void tuxpFree(void *p, size_t size);
+const AllocationStatistics *getAllocationStatistics();
+void resetAllocationStatistics();
+
+#endif
@@ -0,0 +1,231 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "tuxp.h"
+#include "batch_decoder.h"
+#include "flag_scanner.h"
+#include "decimal.h"
+#include "header_compression.h"
+
+#define MAX_SIZE_BATCH_FRAME 0xff
+
+typedef enum {
+	FRAME_FOUND,
+	FRAME_INCOMPLETE,
+	NO_FRAME
+} FrameSearch;
+
+static int findEscapedFrameEnd(const uint8_t *buf, int position, int len) {
+	for (position = scanFlagByte(buf, position, len); position < len; position = scanFlagByte(buf, position, len)) {
+		if (buf[position] == FLAG_DOC_BEGINNING_END)
+			return position;
+
+		position += buf[position] == FLAG_ESCAPE ? 2 : 1;
+	}
+
+	return -1;
+}
+
+static FrameSearch findFrame(const uint8_t *buf, int position, int len, int *start, int *end) {
+	for (position = scanFlagByte(buf, position, len); position < len;
+			position = scanFlagByte(buf, position + 1, len)) {
+		if (buf[position] != FLAG_DOC_BEGINNING_END)
+			continue;
+
+		*start = position;
+		if (position + 1 >= len)
+			return FRAME_INCOMPLETE;
+
+		// The end flag of a frame we joined in the middle.
+		if (buf[position + 1] == FLAG_DOC_BEGINNING_END)
+			continue;
+
+		if (buf[position + 1] == FLAG_TLV_FRAME || buf[position + 1] == FLAG_COMPRESSED_FRAME) {
+			if (position + 2 >= len)
+				return FRAME_INCOMPLETE;
+
+			*end = position + SIZE_TLV_FRAME_PREFIX - 1 + buf[position + 2];
+		} else {
+			*end = findEscapedFrameEnd(buf, position + 1, len);
+			if (*end < 0)
+				return FRAME_INCOMPLETE;
+		}
+
+		return *end < len ? FRAME_FOUND : FRAME_INCOMPLETE;
+	}
+
+	return NO_FRAME;
+}
+
+static void addRow(TuxpBatch *out, const uint8_t *buf, int start, int size, const ProtocolView *protocol,
+			int8_t envelopeType, const uint8_t *tinyId, bool ackRequired) {
+	int row = out->framesSize;
+	out->frameOffsets[row] = start;
+	out->frameSizes[row] = size;
+	out->envelopeTypes[row] = envelopeType;
+	if (tinyId)
+		memcpy(out->tinyIds[row], tinyId, SIZE_THINGS_TINY_ID);
+	else
+		memset(out->tinyIds[row], 0, SIZE_THINGS_TINY_ID);
+	out->ackRequired[row] = ackRequired;
+	out->names[row] = packProtocolName(protocol->name);
+	out->firstAttributes[row] = out->attributesSize;
+	out->attributesSizes[row] = protocol->attributesSize;
+	out->textOffsets[row] = protocol->textPosition < 0 ? -1 : start + protocol->textPosition;
+	out->textSizes[row] = protocol->textSize;
+
+	AttributeViewIterator iterator = viewAttributes(protocol);
+	AttributeView attribute;
+	while (viewNextAttribute(&iterator, &attribute)) {
+		int i = out->attributesSize;
+		out->attributeNames[i] = attribute.name;
+		out->attributeTypes[i] = attribute.dataType;
+		out->valueOffsets[i] = attribute.data - buf;
+		out->valueSizes[i] = attribute.dataSize;
+		out->valueEscapes[i] = attribute.escapeNumber;
+		out->attributesSize++;
+	}
+
+	out->framesSize++;
+}
+
+static bool addFrame(TuxpBatch *out, const uint8_t *buf, int start, int size) {
+	// Its rules are held by the peer's compression context, not by the batch.
+	if (isCompressedFrame(buf + start, size)) {
+		ProtocolView compressed;
+		memset(&compressed, 0, sizeof(compressed));
+		compressed.textPosition = -1;
+		addRow(out, buf, start, size, &compressed, BATCH_COMPRESSED_FRAME, NULL, false);
+		return true;
+	}
+
+	ProtocolData pData = {(uint8_t *)buf + start, size};
+	ProtocolView view;
+	if (size > MAX_SIZE_BATCH_FRAME || viewProtocol(&pData, &view) != 0) {
+		out->malformedFrames++;
+		return true;
+	}
+
+	LanEnvelope envelope;
+	int result = decodeLanEnvelopeView(&view, &envelope);
+	if (result == TUXP_ERROR_UNKNOWN_PROTOCOL_NAME) {
+		if (out->attributesSize + view.attributesSize > MAX_SIZE_BATCH_ATTRIBUTES)
+			return false;
+
+		addRow(out, buf, start, size, &view, BATCH_NO_ENVELOPE, NULL, false);
+		return true;
+	}
+
+	if (result != 0) {
+		out->malformedFrames++;
+		return true;
+	}
+
+	// An answer has no inner protocol. Its own attributes are kept.
+	if (envelope.type == LAN_ENVELOPE_ANSWER) {
+		if (out->attributesSize + view.attributesSize > MAX_SIZE_BATCH_ATTRIBUTES)
+			return false;
+
+		addRow(out, buf, start, size, &view, envelope.type, envelope.tinyId, envelope.ackRequired);
+		return true;
+	}
+
+	// A batched report gives a row to each of its inner protocols. The frame goes in whole or not at all.
+	int attributesSize = 0;
+	ChildViewIterator iterator = viewChildren(&envelope.view);
+	ProtocolView inner;
+	while (viewNextChild(&iterator, &inner))
+		attributesSize += inner.attributesSize;
+
+	if (out->framesSize + view.childrenSize > MAX_SIZE_BATCH_FRAMES ||
+			out->attributesSize + attributesSize > MAX_SIZE_BATCH_ATTRIBUTES)
+		return false;
+
+	iterator = viewChildren(&envelope.view);
+	while (viewNextChild(&iterator, &inner))
+		addRow(out, buf, start, size, &inner, envelope.type, envelope.tinyId, envelope.ackRequired);
+
+	return true;
+}
+
+int tuxpDecodeBatch(const uint8_t *buf, size_t len, TuxpBatch *out) {
+	out->framesSize = 0;
+	out->attributesSize = 0;
+	out->malformedFrames = 0;
+	out->consumed = 0;
+
+	int position = 0;
+	int start, end;
+	while (out->framesSize < MAX_SIZE_BATCH_FRAMES) {
+		FrameSearch search = findFrame(buf, position, len, &start, &end);
+		if (search == NO_FRAME) {
+			position = len;
+			break;
+		}
+
+		if (search == FRAME_INCOMPLETE) {
+			position = start;
+			break;
+		}
+
+		if (!addFrame(out, buf, start, end - start + 1)) {
+			position = start;
+			break;
+		}
+
+		position = end + 1;
+	}
+
+	out->consumed = position;
+	return out->framesSize;
+}
+
+int batchFindAttribute(const TuxpBatch *batch, int frame, uint8_t name) {
+	int first = batch->firstAttributes[frame];
+	for (int i = first; i < first + batch->attributesSizes[frame]; i++) {
+		if (batch->attributeNames[i] == name)
+			return i;
+	}
+
+	return -1;
+}
+
+static AttributeView getAttributeView(const TuxpBatch *batch, const uint8_t *buf, int attribute) {
+	AttributeView view;
+	view.name = batch->attributeNames[attribute];
+	view.dataType = batch->attributeTypes[attribute];
+	view.data = buf + batch->valueOffsets[attribute];
+	view.dataSize = batch->valueSizes[attribute];
+	view.escapeNumber = batch->valueEscapes[attribute];
+
+	return view;
+}
+
+int batchCopyValue(const TuxpBatch *batch, const uint8_t *buf, int attribute, uint8_t buff[], int buffSize) {
+	AttributeView view = getAttributeView(batch, buf, attribute);
+	return viewCopyValue(&view, buff, buffSize);
+}
+
+bool batchGetInt(const TuxpBatch *batch, const uint8_t *buf, int attribute, int *value) {
+	AttributeView view = getAttributeView(batch, buf, attribute);
+	if (view.dataType == TYPE_VARINT) {
+		ProtocolAttributeValue nativeValue;
+		if (viewDecodeNativeValue(&view, &nativeValue) != 0)
+			return false;
+
+		*value = nativeValue.iValue;
+		return true;
+	}
+
+	if (view.dataType != TYPE_CHARS)
+		return false;
+
+	char chars[MAX_SIZE_ATTRIBUTE_DATA + 1];
+	int size = viewCopyValue(&view, (uint8_t *)chars, MAX_SIZE_ATTRIBUTE_DATA);
+	if (size < 0)
+		return false;
+	chars[size] = '\0';
+
+	*value = parseDecimalInt(chars);
+	return true;
+}
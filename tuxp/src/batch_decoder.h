@@ -0,0 +1,57 @@
+#ifndef MUD_BATCH_DECODER_H
+#define MUD_BATCH_DECODER_H
+
+#include <stddef.h>
+
+#include "tuxp.h"
+#include "protocol_registry.h"
+
+#ifndef MAX_SIZE_BATCH_FRAMES
+#define MAX_SIZE_BATCH_FRAMES 64
+#endif
+
+#ifndef MAX_SIZE_BATCH_ATTRIBUTES
+#define MAX_SIZE_BATCH_ATTRIBUTES (MAX_SIZE_BATCH_FRAMES * 4)
+#endif
+
+// The envelope type of a frame which isn't a LAN envelope.
+#define BATCH_NO_ENVELOPE -1
+// The envelope type of a compressed frame. It has no name or attributes, restore it with
+// decompressFrame() and decode it again.
+#define BATCH_COMPRESSED_FRAME -2
+
+// Frames and attributes are kept in columns. Offsets point into the decoded buffer, so the
+// buffer must outlive the batch. Values which hold escapes have to be copied out with
+// batchCopyValue(), the others can be used in place. A batched report takes a frame entry
+// for each of its inner protocols, they share the offset, size and TinyId of the frame.
+typedef struct {
+	int framesSize;
+	int frameOffsets[MAX_SIZE_BATCH_FRAMES];
+	uint8_t frameSizes[MAX_SIZE_BATCH_FRAMES];
+	int8_t envelopeTypes[MAX_SIZE_BATCH_FRAMES];
+	TinyId tinyIds[MAX_SIZE_BATCH_FRAMES];
+	bool ackRequired[MAX_SIZE_BATCH_FRAMES];
+	uint32_t names[MAX_SIZE_BATCH_FRAMES];
+	int firstAttributes[MAX_SIZE_BATCH_FRAMES];
+	uint8_t attributesSizes[MAX_SIZE_BATCH_FRAMES];
+	int textOffsets[MAX_SIZE_BATCH_FRAMES];
+	uint8_t textSizes[MAX_SIZE_BATCH_FRAMES];
+
+	int attributesSize;
+	uint8_t attributeNames[MAX_SIZE_BATCH_ATTRIBUTES];
+	uint8_t attributeTypes[MAX_SIZE_BATCH_ATTRIBUTES];
+	int valueOffsets[MAX_SIZE_BATCH_ATTRIBUTES];
+	uint8_t valueSizes[MAX_SIZE_BATCH_ATTRIBUTES];
+	uint8_t valueEscapes[MAX_SIZE_BATCH_ATTRIBUTES];
+
+	int malformedFrames;
+	// Bytes used up. The rest starts with a frame which is incomplete or didn't fit.
+	size_t consumed;
+} TuxpBatch;
+
+int tuxpDecodeBatch(const uint8_t *buf, size_t len, TuxpBatch *out);
+int batchFindAttribute(const TuxpBatch *batch, int frame, uint8_t name);
+int batchCopyValue(const TuxpBatch *batch, const uint8_t *buf, int attribute, uint8_t buff[], int buffSize);
+bool batchGetInt(const TuxpBatch *batch, const uint8_t *buf, int attribute, int *value);
+
+#endif
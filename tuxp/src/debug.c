@@ -1,7 +1,7 @@
 #include <stddef.h>
-#include <stdio.h>
 
 #include "debug.h"
+#include "decimal.h"
 
 #define NO_CAUSE_INFO_FOUND 0
 
@@ -24,17 +24,36 @@ int debugErrorAndReturn(const char funName[], int errorNumber) {
 	return debugErrorDetailAndReturn(funName, errorNumber, NO_CAUSE_INFO_FOUND);
 }
 
+// Appends as much of chars as fits and keeps buff terminated.
+static int appendChars(char buff[], int position, int buffSize, const char chars[]) {
+	for (int i = 0; chars[i] != '\0' && position < buffSize - 1; i++)
+		buff[position++] = chars[i];
+	buff[position] = '\0';
+
+	return position;
+}
+
+static int appendInt(char buff[], int position, int buffSize, int iValue) {
+	char chars[MAX_SIZE_DECIMAL_INT];
+	formatDecimalInt(iValue, chars, sizeof(chars));
+
+	return appendChars(buff, position, buffSize, chars);
+}
+
 int debugErrorDetailAndReturn(const char funName[], int errorNumber, int errorNumberOfCause) {
-	if(!debugOut)
-		return;
+	if(!debugOutput)
+		return errorNumber;
 
 	char buff[128];
-	if (errorNumberOfCause == NO_CAUSE_INFO_FOUND) {
-		sprintf(buff, "Error - Function name: %s. Error number: %d.", funName, errorNumber);
-	} else {
-		sprintf(buff, "Error - Function name: %s. Error number: %d. Error number of cause: %d.",
-			funName, errorNumber, errorNumberOfCause);
+	int position = appendChars(buff, 0, sizeof(buff), "Error - Function name: ");
+	position = appendChars(buff, position, sizeof(buff), funName);
+	position = appendChars(buff, position, sizeof(buff), ". Error number: ");
+	position = appendInt(buff, position, sizeof(buff), errorNumber);
+	if (errorNumberOfCause != NO_CAUSE_INFO_FOUND) {
+		position = appendChars(buff, position, sizeof(buff), ". Error number of cause: ");
+		position = appendInt(buff, position, sizeof(buff), errorNumberOfCause);
 	}
+	appendChars(buff, position, sizeof(buff), ".");
 
 	DEBUG_OUT(buff);
 
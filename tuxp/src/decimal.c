@@ -0,0 +1,187 @@
+#include <math.h>
+
+#include "tuxp.h"
+#include "decimal.h"
+
+// The most significant digits a float can tell apart, with a couple to spare for rounding.
+#define MAX_SIZE_SIGNIFICANT_DIGITS 9
+
+static const uint32_t powersOfTen[] = {
+	1UL, 10UL, 100UL, 1000UL, 10000UL, 100000UL, 1000000UL, 10000000UL, 100000000UL, 1000000000UL
+};
+
+// Writes the digits backwards from the end of digits and returns how many there are.
+static int writeDigits(uint32_t value, int minSize, char digits[], int digitsSize) {
+	int size = 0;
+	do {
+		digits[digitsSize - 1 - size] = '0' + value % 10;
+		value /= 10;
+		size++;
+	} while (value != 0 || size < minSize);
+
+	return size;
+}
+
+static int copyDecimal(bool negative, const char digits[], int size, char buff[], int buffSize,
+			int *position) {
+	if (*position + (negative ? 1 : 0) + size >= buffSize)
+		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+	if (negative)
+		buff[(*position)++] = '-';
+
+	for (int i = 0; i < size; i++)
+		buff[(*position)++] = digits[i];
+	buff[*position] = '\0';
+
+	return 0;
+}
+
+// Returns the length of the chars, as sprintf("%d") would write them.
+int formatDecimalInt(int32_t iValue, char buff[], int buffSize) {
+	char digits[MAX_SIZE_DECIMAL_INT];
+	uint32_t magnitude = iValue < 0 ? 0UL - (uint32_t)iValue : (uint32_t)iValue;
+	int size = writeDigits(magnitude, 1, digits, sizeof(digits));
+
+	int position = 0;
+	int result = copyDecimal(iValue < 0, digits + sizeof(digits) - size, size, buff, buffSize, &position);
+	return result != 0 ? result : position;
+}
+
+// Returns the length of the chars, as sprintf("%.*f") would write them. Values whose
+// integer part doesn't fit in 32 bits aren't sent as chars.
+int formatDecimalFixed(float fValue, int fractionDigits, char buff[], int buffSize) {
+	if (fractionDigits < 0 || fractionDigits > MAX_SIZE_DECIMAL_FRACTION_DIGITS)
+		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+	double magnitude = fValue < 0 ? -(double)fValue : (double)fValue;
+	if (!(magnitude < 4294967295.0))
+		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+	// The scaled fraction of a float is exact in a double, so ties are seen as ties and go to
+	// the even digit, as printf does.
+	uint32_t integer = (uint32_t)magnitude;
+	double scaled = (magnitude - integer) * powersOfTen[fractionDigits];
+	uint32_t fraction = (uint32_t)scaled;
+	double dropped = scaled - fraction;
+	uint32_t lastDigit = fractionDigits > 0 ? fraction : integer;
+	if (dropped > 0.5 || (dropped == 0.5 && (lastDigit & 1) != 0))
+		fraction++;
+
+	if (fraction >= powersOfTen[fractionDigits]) {
+		if (integer == UINT32_MAX)
+			return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+		integer++;
+		fraction -= powersOfTen[fractionDigits];
+	}
+
+	char digits[MAX_SIZE_DECIMAL_INT + 1 + MAX_SIZE_DECIMAL_FRACTION_DIGITS];
+	int size = 0;
+	if (fractionDigits > 0) {
+		size = writeDigits(fraction, fractionDigits, digits, sizeof(digits));
+		digits[sizeof(digits) - 1 - size] = '.';
+		size++;
+	}
+	size += writeDigits(integer, 1, digits, sizeof(digits) - size);
+
+	// Like printf, a negative value which rounds to zero keeps its sign.
+	int position = 0;
+	int result = copyDecimal(signbit(fValue), digits + sizeof(digits) - size, size, buff, buffSize, &position);
+	return result != 0 ? result : position;
+}
+
+static bool isDecimalDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+static int skipSpaces(const char chars[]) {
+	int position = 0;
+	while (chars[position] == ' ' || (chars[position] >= '\t' && chars[position] <= '\r'))
+		position++;
+
+	return position;
+}
+
+// Reads chars as atoi() does. It stops at the first char which isn't a digit.
+int32_t parseDecimalInt(const char chars[]) {
+	int position = skipSpaces(chars);
+	bool negative = chars[position] == '-';
+	if (chars[position] == '-' || chars[position] == '+')
+		position++;
+
+	uint32_t magnitude = 0;
+	for (; isDecimalDigit(chars[position]); position++)
+		magnitude = magnitude * 10 + (chars[position] - '0');
+
+	return (int32_t)(negative ? 0UL - magnitude : magnitude);
+}
+
+// Reads decimal chars as atof() does. Digits past the precision of a float only count
+// towards the exponent.
+float parseDecimalFloat(const char chars[]) {
+	int position = skipSpaces(chars);
+	bool negative = chars[position] == '-';
+	if (chars[position] == '-' || chars[position] == '+')
+		position++;
+
+	uint32_t mantissa = 0;
+	int significantDigits = 0;
+	int exponent = 0;
+	bool anyDigit = false;
+	for (; isDecimalDigit(chars[position]); position++) {
+		anyDigit = true;
+		if (significantDigits < MAX_SIZE_SIGNIFICANT_DIGITS) {
+			mantissa = mantissa * 10 + (chars[position] - '0');
+			if (mantissa != 0)
+				significantDigits++;
+		} else {
+			exponent++;
+		}
+	}
+
+	if (chars[position] == '.') {
+		for (position++; isDecimalDigit(chars[position]); position++) {
+			anyDigit = true;
+			if (significantDigits < MAX_SIZE_SIGNIFICANT_DIGITS) {
+				mantissa = mantissa * 10 + (chars[position] - '0');
+				if (mantissa != 0)
+					significantDigits++;
+				exponent--;
+			}
+		}
+	}
+
+	if (!anyDigit)
+		return 0;
+
+	if (chars[position] == 'e' || chars[position] == 'E') {
+		int exponentPosition = position + 1;
+		bool negativeExponent = chars[exponentPosition] == '-';
+		if (chars[exponentPosition] == '-' || chars[exponentPosition] == '+')
+			exponentPosition++;
+
+		int explicitExponent = 0;
+		for (; isDecimalDigit(chars[exponentPosition]); exponentPosition++) {
+			// Anything past this is zero or infinity anyway.
+			if (explicitExponent < 1000)
+				explicitExponent = explicitExponent * 10 + (chars[exponentPosition] - '0');
+		}
+
+		exponent += negativeExponent ? -explicitExponent : explicitExponent;
+	}
+
+	double value = mantissa;
+	double scale = 1;
+	for (int i = exponent < 0 ? -exponent : exponent; i > 0 && value != 0; i--) {
+		scale *= 10;
+		// Keep the scale finite, so that huge exponents end up at infinity or zero.
+		if (scale > 1e30) {
+			value = exponent < 0 ? value / scale : value * scale;
+			scale = 1;
+		}
+	}
+	value = exponent < 0 ? value / scale : value * scale;
+
+	return (float)(negative ? -value : value);
+}
@@ -0,0 +1,26 @@
+#ifndef MUD_DECIMAL_H
+#define MUD_DECIMAL_H
+
+#include <stdint.h>
+
+// A sign, ten digits and the terminating NUL.
+#define MAX_SIZE_DECIMAL_INT 12
+
+// Fraction digits of floats sent as chars. It used to be whatever dtostrf() and sprintf()
+// wrote, so the defaults keep the frames as they were.
+#ifndef SIZE_DECIMAL_FRACTION_DIGITS
+#ifdef ARDUINO
+#define SIZE_DECIMAL_FRACTION_DIGITS 2
+#else
+#define SIZE_DECIMAL_FRACTION_DIGITS 6
+#endif
+#endif
+
+#define MAX_SIZE_DECIMAL_FRACTION_DIGITS 9
+
+int formatDecimalInt(int32_t iValue, char buff[], int buffSize);
+int formatDecimalFixed(float fValue, int fractionDigits, char buff[], int buffSize);
+int32_t parseDecimalInt(const char chars[]);
+float parseDecimalFloat(const char chars[]);
+
+#endif
@@ -0,0 +1,109 @@
+#include <string.h>
+
+#include "flag_scanner.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+static int scanBytes(const uint8_t data[], int from, int to) {
+	while (from < to && data[from] < MIN_FLAG_BYTE)
+		from++;
+
+	return from;
+}
+
+#if defined(__AVR__)
+
+// Words don't pay off on an 8 bit MCU.
+int scanFlagBytePortable(const uint8_t data[], int from, int to) {
+	return scanBytes(data, from, to);
+}
+
+#else
+
+typedef uint64_t ScanWord;
+#define SCAN_WORD_ONES 0x0101010101010101ULL
+#define SCAN_WORD_HIGHS 0x8080808080808080ULL
+
+// A byte is a flag byte when its complement is less than 6. The subtraction borrows into the
+// high bit of such bytes. Borrows may mark bytes after the first flag byte too, which doesn't
+// matter as the word is scanned byte by byte once it has any.
+static int hasFlagByte(ScanWord word) {
+	ScanWord complement = ~word;
+	return ((complement - SCAN_WORD_ONES * (0x100 - MIN_FLAG_BYTE)) & word & SCAN_WORD_HIGHS) != 0;
+}
+
+int scanFlagBytePortable(const uint8_t data[], int from, int to) {
+	while (to - from >= (int)sizeof(ScanWord)) {
+		ScanWord word;
+		memcpy(&word, data + from, sizeof(word));
+		if (hasFlagByte(word))
+			return scanBytes(data, from, from + sizeof(word));
+
+		from += sizeof(word);
+	}
+
+	return scanBytes(data, from, to);
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+int scanFlagByte(const uint8_t data[], int from, int to) {
+	const __m256i minFlag = _mm256_set1_epi8((char)MIN_FLAG_BYTE);
+	while (to - from >= 32) {
+		__m256i block = _mm256_loadu_si256((const __m256i *)(data + from));
+		uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(block, minFlag), block));
+		if (mask != 0)
+			return from + __builtin_ctz(mask);
+
+		from += 32;
+	}
+
+	return scanFlagBytePortable(data, from, to);
+}
+
+#elif defined(__SSE2__)
+
+int scanFlagByte(const uint8_t data[], int from, int to) {
+	const __m128i minFlag = _mm_set1_epi8((char)MIN_FLAG_BYTE);
+	while (to - from >= 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)(data + from));
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(block, minFlag), block));
+		if (mask != 0)
+			return from + __builtin_ctz(mask);
+
+		from += 16;
+	}
+
+	return scanFlagBytePortable(data, from, to);
+}
+
+#elif defined(__ARM_NEON)
+
+int scanFlagByte(const uint8_t data[], int from, int to) {
+	const uint8x16_t minFlag = vdupq_n_u8(MIN_FLAG_BYTE);
+	while (to - from >= 16) {
+		uint64x2_t mask = vreinterpretq_u64_u8(vcgeq_u8(vld1q_u8(data + from), minFlag));
+		if ((vgetq_lane_u64(mask, 0) | vgetq_lane_u64(mask, 1)) != 0)
+			return scanBytes(data, from, from + 16);
+
+		from += 16;
+	}
+
+	return scanFlagBytePortable(data, from, to);
+}
+
+#else
+
+int scanFlagByte(const uint8_t data[], int from, int to) {
+	return scanFlagBytePortable(data, from, to);
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef MUD_FLAG_SCANNER_H
+#define MUD_FLAG_SCANNER_H
+
+#include <stdint.h>
+
+// All flag bytes are 0xfa or above, escaped bytes too.
+#define MIN_FLAG_BYTE 0xfa
+
+// Returns the position of the first flag byte in [from, to), or to if there's none.
+int scanFlagByte(const uint8_t data[], int from, int to);
+
+// The word at a time fallback, always built so that it can be checked against the vector kernels.
+int scanFlagBytePortable(const uint8_t data[], int from, int to);
+
+#endif
@@ -0,0 +1,261 @@
+#include <string.h>
+
+#include "tuxp.h"
+#include "fragmentation.h"
+
+#define SIZE_RECEIVED_FRAGMENTS_MASK 4
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX_SIZE_REASSEMBLY_FRAGMENTS \
+	MIN(MAX_SIZE_FRAGMENTS, (MAX_SIZE_FRAGMENTED_DATA + SIZE_FRAGMENT_PAYLOAD - 1) / SIZE_FRAGMENT_PAYLOAD)
+
+typedef struct {
+	bool used;
+	TinyId tinyId;
+	uint8_t total;
+	uint32_t receivedFragments;
+	int dataSize;
+	unsigned long lastReceived;
+	uint8_t data[MAX_SIZE_FRAGMENTED_DATA];
+} ReassemblySlot;
+
+static ReassemblySlot reassemblySlots[SIZE_REASSEMBLY_SLOTS];
+static unsigned long receivedFragmentsCount = 0;
+
+static uint32_t getAllFragmentsMask(uint8_t total) {
+	return total >= MAX_SIZE_FRAGMENTS ? 0xffffffff : ((uint32_t)1 << total) - 1;
+}
+
+static bool isSameTinyId(const TinyId tinyId1, const TinyId tinyId2) {
+	return memcmp(tinyId1, tinyId2, SIZE_THINGS_TINY_ID) == 0;
+}
+
+int beginFragmentSending(FragmentSender *sender, TinyId tinyId, const uint8_t data[], int dataSize) {
+	if (dataSize <= 0)
+		return TUXP_ERROR_FRAGMENT_MISMATCH;
+
+	// Nothing larger can be reassembled on the other side.
+	if (dataSize > MAX_SIZE_FRAGMENTS * SIZE_FRAGMENT_PAYLOAD || dataSize > MAX_SIZE_FRAGMENTED_DATA)
+		return TUXP_ERROR_FRAGMENTED_DATA_TOO_LARGE;
+
+	memcpy(sender->tinyId, tinyId, SIZE_THINGS_TINY_ID);
+	sender->data = data;
+	sender->dataSize = dataSize;
+	sender->total = (dataSize + SIZE_FRAGMENT_PAYLOAD - 1) / SIZE_FRAGMENT_PAYLOAD;
+	sender->ackedFragments = 0;
+
+	return 0;
+}
+
+// The last fragment of a round asks for an ack. The answer tells which ones have to be sent again.
+int encodeFragment(FragmentSender *sender, uint8_t sequence, uint8_t buff[], int buffSize, int headroom) {
+	if (sequence >= sender->total)
+		return TUXP_ERROR_FRAGMENT_MISMATCH;
+
+	int offset = sequence * SIZE_FRAGMENT_PAYLOAD;
+	int size = MIN(SIZE_FRAGMENT_PAYLOAD, sender->dataSize - offset);
+
+	ProtocolWriter writer;
+	writerBeginFormatAt(&writer, getProtocolFormat(), NAME_TUXP_PROTOCOL_FRAGMENT, buff, buffSize, headroom);
+	writerPutBytes(&writer, NAME_ATTRIBUTE_TINY_ID_TUXP_PROTOCOL_FRAGMENT, sender->tinyId, SIZE_THINGS_TINY_ID);
+	if (getNextMissingFragment(sender, sequence + 1) < 0)
+		writerPutRbs(&writer, NAME_ATTRIBUTE_ACK_REQUIRED_TUXP_PROTOCOL_FRAGMENT, 0x02);
+	writerPutByte(&writer, NAME_ATTRIBUTE_SEQUENCE_TUXP_PROTOCOL_FRAGMENT, sequence);
+	writerPutByte(&writer, NAME_ATTRIBUTE_TOTAL_TUXP_PROTOCOL_FRAGMENT, sender->total);
+	writerPutBytes(&writer, NAME_ATTRIBUTE_DATA_TUXP_PROTOCOL_FRAGMENT, sender->data + offset, size);
+
+	int frameSize = writerEnd(&writer);
+	if (frameSize - headroom > MAX_SIZE_PROTOCOL_DATA)
+		return TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE;
+
+	return frameSize;
+}
+
+int getNextMissingFragment(FragmentSender *sender, int from) {
+	for (int i = from; i < sender->total; i++) {
+		if ((sender->ackedFragments & ((uint32_t)1 << i)) == 0)
+			return i;
+	}
+
+	return -1;
+}
+
+int processFragmentAck(FragmentSender *sender, const FragmentAck *ack) {
+	if (!isSameTinyId(sender->tinyId, ack->tinyId) || sender->total != ack->total)
+		return TUXP_ERROR_FRAGMENT_MISMATCH;
+
+	sender->ackedFragments |= ack->receivedFragments & getAllFragmentsMask(sender->total);
+	return 0;
+}
+
+bool isFragmentSendingDone(FragmentSender *sender) {
+	return sender->ackedFragments == getAllFragmentsMask(sender->total);
+}
+
+bool isFragment(ProtocolData *pData) {
+	return isProtocol(pData, NAME_TUXP_PROTOCOL_FRAGMENT);
+}
+
+bool isFragmentAck(ProtocolData *pData) {
+	return isProtocol(pData, NAME_TUXP_PROTOCOL_FRAGMENT_ACK);
+}
+
+static ReassemblySlot *findReassemblySlot(const TinyId tinyId) {
+	for (int i = 0; i < SIZE_REASSEMBLY_SLOTS; i++) {
+		if (reassemblySlots[i].used && isSameTinyId(reassemblySlots[i].tinyId, tinyId))
+			return reassemblySlots + i;
+	}
+
+	return NULL;
+}
+
+static bool isReassembled(const ReassemblySlot *slot) {
+	return slot->receivedFragments == getAllFragmentsMask(slot->total);
+}
+
+// Prefers a free slot, then one that's already reassembled. When all of them are still
+// waiting for fragments, the one which has been quiet for the longest time is given up.
+static ReassemblySlot *takeReassemblySlot() {
+	ReassemblySlot *reassembled = NULL;
+	ReassemblySlot *quietest = NULL;
+	for (int i = 0; i < SIZE_REASSEMBLY_SLOTS; i++) {
+		ReassemblySlot *slot = reassemblySlots + i;
+		if (!slot->used)
+			return slot;
+
+		if (isReassembled(slot)) {
+			if (!reassembled || slot->lastReceived < reassembled->lastReceived)
+				reassembled = slot;
+		} else if (!quietest || slot->lastReceived < quietest->lastReceived) {
+			quietest = slot;
+		}
+	}
+
+	return reassembled ? reassembled : quietest;
+}
+
+// Returns FRAGMENTS_REASSEMBLED only for the fragment which completes the data. Fragments
+// repeated after that are acked again, so a lost ack doesn't leave the sender waiting.
+int receiveFragment(ProtocolData *pData, FragmentAck *ack, bool *ackRequired) {
+	ProtocolView view;
+	if (!isFragment(pData) || viewProtocol(pData, &view) != 0)
+		return TUXP_ERROR_NOT_VALID_PROTOCOL;
+
+	uint8_t tinyIdBuff[SIZE_THINGS_TINY_ID];
+	const uint8_t *tinyId;
+	if (viewGetBytes(&view, NAME_ATTRIBUTE_TINY_ID_TUXP_PROTOCOL_FRAGMENT, tinyIdBuff,
+			SIZE_THINGS_TINY_ID, &tinyId) != SIZE_THINGS_TINY_ID)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	uint8_t sequence;
+	uint8_t total;
+	if (!viewGetByte(&view, NAME_ATTRIBUTE_SEQUENCE_TUXP_PROTOCOL_FRAGMENT, &sequence) ||
+			!viewGetByte(&view, NAME_ATTRIBUTE_TOTAL_TUXP_PROTOCOL_FRAGMENT, &total) ||
+			total == 0 || sequence >= total)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	if (total > MAX_SIZE_REASSEMBLY_FRAGMENTS)
+		return TUXP_ERROR_FRAGMENTED_DATA_TOO_LARGE;
+
+	uint8_t dataBuff[SIZE_FRAGMENT_PAYLOAD];
+	const uint8_t *data;
+	int size = viewGetBytes(&view, NAME_ATTRIBUTE_DATA_TUXP_PROTOCOL_FRAGMENT, dataBuff,
+		SIZE_FRAGMENT_PAYLOAD, &data);
+	if (size <= 0 || (sequence < total - 1 && size != SIZE_FRAGMENT_PAYLOAD))
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	int offset = sequence * SIZE_FRAGMENT_PAYLOAD;
+	if (offset + size > MAX_SIZE_FRAGMENTED_DATA)
+		return TUXP_ERROR_FRAGMENTED_DATA_TOO_LARGE;
+
+	ReassemblySlot *slot = findReassemblySlot(tinyId);
+	if (slot && slot->total != total)
+		return TUXP_ERROR_FRAGMENT_MISMATCH;
+
+	if (!slot) {
+		slot = takeReassemblySlot();
+		slot->used = true;
+		memcpy(slot->tinyId, tinyId, SIZE_THINGS_TINY_ID);
+		slot->total = total;
+		slot->receivedFragments = 0;
+		slot->dataSize = 0;
+	}
+	slot->lastReceived = ++receivedFragmentsCount;
+
+	bool wasReassembled = isReassembled(slot);
+	memcpy(slot->data + offset, data, size);
+	slot->receivedFragments |= (uint32_t)1 << sequence;
+	if (sequence == total - 1)
+		slot->dataSize = offset + size;
+
+	memcpy(ack->tinyId, tinyId, SIZE_THINGS_TINY_ID);
+	ack->total = total;
+	ack->receivedFragments = slot->receivedFragments;
+
+	AttributeView ackRequiredAttribute;
+	*ackRequired = isReassembled(slot) ||
+		viewGetAttribute(&view, NAME_ATTRIBUTE_ACK_REQUIRED_TUXP_PROTOCOL_FRAGMENT, &ackRequiredAttribute);
+
+	return !wasReassembled && isReassembled(slot) ? FRAGMENTS_REASSEMBLED : FRAGMENT_ACCEPTED;
+}
+
+const uint8_t *getReassembledData(const TinyId tinyId, int *dataSize) {
+	ReassemblySlot *slot = findReassemblySlot(tinyId);
+	if (!slot || !isReassembled(slot))
+		return NULL;
+
+	*dataSize = slot->dataSize;
+	return slot->data;
+}
+
+void releaseReassembly(const TinyId tinyId) {
+	ReassemblySlot *slot = findReassemblySlot(tinyId);
+	if (slot)
+		slot->used = false;
+}
+
+void resetReassembly() {
+	for (int i = 0; i < SIZE_REASSEMBLY_SLOTS; i++)
+		reassemblySlots[i].used = false;
+}
+
+int encodeFragmentAck(const FragmentAck *ack, uint8_t buff[], int buffSize, int headroom) {
+	uint8_t received[SIZE_RECEIVED_FRAGMENTS_MASK];
+	for (int i = 0; i < SIZE_RECEIVED_FRAGMENTS_MASK; i++)
+		received[i] = (ack->receivedFragments >> (8 * i)) & 0xff;
+
+	ProtocolWriter writer;
+	writerBeginFormatAt(&writer, getProtocolFormat(), NAME_TUXP_PROTOCOL_FRAGMENT_ACK, buff, buffSize, headroom);
+	writerPutBytes(&writer, NAME_ATTRIBUTE_TINY_ID_TUXP_PROTOCOL_FRAGMENT_ACK, ack->tinyId, SIZE_THINGS_TINY_ID);
+	writerPutByte(&writer, NAME_ATTRIBUTE_TOTAL_TUXP_PROTOCOL_FRAGMENT_ACK, ack->total);
+	writerPutBytes(&writer, NAME_ATTRIBUTE_RECEIVED_TUXP_PROTOCOL_FRAGMENT_ACK, received,
+		SIZE_RECEIVED_FRAGMENTS_MASK);
+
+	return writerEnd(&writer);
+}
+
+int parseFragmentAck(ProtocolData *pData, FragmentAck *ack) {
+	ProtocolView view;
+	if (!isFragmentAck(pData) || viewProtocol(pData, &view) != 0)
+		return TUXP_ERROR_NOT_VALID_PROTOCOL;
+
+	uint8_t tinyIdBuff[SIZE_THINGS_TINY_ID];
+	const uint8_t *tinyId;
+	if (viewGetBytes(&view, NAME_ATTRIBUTE_TINY_ID_TUXP_PROTOCOL_FRAGMENT_ACK, tinyIdBuff,
+			SIZE_THINGS_TINY_ID, &tinyId) != SIZE_THINGS_TINY_ID)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	uint8_t receivedBuff[SIZE_RECEIVED_FRAGMENTS_MASK];
+	const uint8_t *received;
+	if (!viewGetByte(&view, NAME_ATTRIBUTE_TOTAL_TUXP_PROTOCOL_FRAGMENT_ACK, &ack->total) ||
+			viewGetBytes(&view, NAME_ATTRIBUTE_RECEIVED_TUXP_PROTOCOL_FRAGMENT_ACK, receivedBuff,
+				SIZE_RECEIVED_FRAGMENTS_MASK, &received) != SIZE_RECEIVED_FRAGMENTS_MASK)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	memcpy(ack->tinyId, tinyId, SIZE_THINGS_TINY_ID);
+	ack->receivedFragments = 0;
+	for (int i = 0; i < SIZE_RECEIVED_FRAGMENTS_MASK; i++)
+		ack->receivedFragments |= (uint32_t)received[i] << (8 * i);
+
+	return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef MUD_FRAGMENTATION_H
+#define MUD_FRAGMENTATION_H
+
+#include "tuxp.h"
+
+// Every fragment but the last one carries exactly this many bytes.
+#ifndef SIZE_FRAGMENT_PAYLOAD
+#define SIZE_FRAGMENT_PAYLOAD MAX_SIZE_ATTRIBUTE_DATA
+#endif
+
+// Received fragments are acknowledged in a 32 bit mask.
+#define MAX_SIZE_FRAGMENTS 32
+
+#ifndef MAX_SIZE_FRAGMENTED_DATA
+#define MAX_SIZE_FRAGMENTED_DATA 256
+#endif
+
+#ifndef SIZE_REASSEMBLY_SLOTS
+#define SIZE_REASSEMBLY_SLOTS 2
+#endif
+
+#define FRAGMENT_ACCEPTED 0
+#define FRAGMENTS_REASSEMBLED 1
+
+static const ProtocolName NAME_TUXP_PROTOCOL_FRAGMENT = {{0xf8, 0x0b}, 0x05};
+#define NAME_ATTRIBUTE_ACK_REQUIRED_TUXP_PROTOCOL_FRAGMENT 0x01
+#define NAME_ATTRIBUTE_SEQUENCE_TUXP_PROTOCOL_FRAGMENT 0x02
+#define NAME_ATTRIBUTE_TOTAL_TUXP_PROTOCOL_FRAGMENT 0x03
+#define NAME_ATTRIBUTE_DATA_TUXP_PROTOCOL_FRAGMENT 0x04
+#define NAME_ATTRIBUTE_TINY_ID_TUXP_PROTOCOL_FRAGMENT 0x06
+
+static const ProtocolName NAME_TUXP_PROTOCOL_FRAGMENT_ACK = {{0xf8, 0x0b}, 0x07};
+#define NAME_ATTRIBUTE_TOTAL_TUXP_PROTOCOL_FRAGMENT_ACK 0x03
+#define NAME_ATTRIBUTE_RECEIVED_TUXP_PROTOCOL_FRAGMENT_ACK 0x05
+#define NAME_ATTRIBUTE_TINY_ID_TUXP_PROTOCOL_FRAGMENT_ACK 0x06
+
+// The data is borrowed, it must outlive the sending.
+typedef struct {
+	TinyId tinyId;
+	const uint8_t *data;
+	int dataSize;
+	uint8_t total;
+	uint32_t ackedFragments;
+} FragmentSender;
+
+typedef struct {
+	TinyId tinyId;
+	uint8_t total;
+	uint32_t receivedFragments;
+} FragmentAck;
+
+int beginFragmentSending(FragmentSender *sender, TinyId tinyId, const uint8_t data[], int dataSize);
+int encodeFragment(FragmentSender *sender, uint8_t sequence, uint8_t buff[], int buffSize, int headroom);
+int getNextMissingFragment(FragmentSender *sender, int from);
+int processFragmentAck(FragmentSender *sender, const FragmentAck *ack);
+bool isFragmentSendingDone(FragmentSender *sender);
+
+bool isFragment(ProtocolData *pData);
+bool isFragmentAck(ProtocolData *pData);
+int receiveFragment(ProtocolData *pData, FragmentAck *ack, bool *ackRequired);
+const uint8_t *getReassembledData(const TinyId tinyId, int *dataSize);
+void releaseReassembly(const TinyId tinyId);
+void resetReassembly();
+int encodeFragmentAck(const FragmentAck *ack, uint8_t buff[], int buffSize, int headroom);
+int parseFragmentAck(ProtocolData *pData, FragmentAck *ack);
+
+#endif
@@ -0,0 +1,151 @@
+#include <string.h>
+
+#include "tuxp.h"
+#include "frame_reassembler.h"
+#include "flag_scanner.h"
+
+void resetFrameReassembler(FrameReassembler *reassembler) {
+	reassembler->state = REASSEMBLER_HUNTING;
+	reassembler->escaped = false;
+	reassembler->remaining = 0;
+	reassembler->frameSize = 0;
+}
+
+bool isReassemblingFrame(const FrameReassembler *reassembler) {
+	return reassembler->state != REASSEMBLER_HUNTING;
+}
+
+static void startFrame(FrameReassembler *reassembler) {
+	reassembler->state = REASSEMBLER_STARTED;
+	reassembler->escaped = false;
+	reassembler->frame[0] = FLAG_DOC_BEGINNING_END;
+	reassembler->frameSize = 1;
+}
+
+static int dropFrame(FrameReassembler *reassembler) {
+	reassembler->state = REASSEMBLER_HUNTING;
+	reassembler->escaped = false;
+	reassembler->frameSize = 0;
+
+	return TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE;
+}
+
+static int endFrame(FrameReassembler *reassembler) {
+	reassembler->state = REASSEMBLER_HUNTING;
+	return reassembler->frameSize;
+}
+
+static void hunt(FrameReassembler *reassembler, const uint8_t data[], int size, int *position) {
+	if (reassembler->escaped) {
+		reassembler->escaped = false;
+		(*position)++;
+		return;
+	}
+
+	*position = scanFlagByte(data, *position, size);
+	if (*position == size)
+		return;
+
+	uint8_t b = data[(*position)++];
+	if (b == FLAG_ESCAPE)
+		reassembler->escaped = true;
+	else if (b == FLAG_DOC_BEGINNING_END)
+		startFrame(reassembler);
+}
+
+static int takeEscapedBody(FrameReassembler *reassembler, const uint8_t data[], int size, int *position) {
+	if (reassembler->escaped) {
+		if (reassembler->frameSize + 1 >= MAX_SIZE_PROTOCOL_DATA)
+			return dropFrame(reassembler);
+
+		reassembler->frame[reassembler->frameSize++] = data[(*position)++];
+		reassembler->escaped = false;
+		return 0;
+	}
+
+	int flagPosition = scanFlagByte(data, *position, size);
+	int runSize = flagPosition - *position;
+	// Room for the run, and for the flag byte after it too.
+	if (reassembler->frameSize + runSize + (flagPosition < size ? 1 : 0) > MAX_SIZE_PROTOCOL_DATA) {
+		*position = flagPosition;
+		return dropFrame(reassembler);
+	}
+
+	memcpy(reassembler->frame + reassembler->frameSize, data + *position, runSize);
+	reassembler->frameSize += runSize;
+	*position = flagPosition;
+	if (flagPosition == size)
+		return 0;
+
+	uint8_t b = data[(*position)++];
+	reassembler->frame[reassembler->frameSize++] = b;
+	if (b == FLAG_ESCAPE) {
+		reassembler->escaped = true;
+	} else if (b == FLAG_DOC_BEGINNING_END) {
+		// Too short to be a frame, the flag is the end of one we joined in the middle.
+		if (reassembler->frameSize < MIN_SIZE_ESCAPED_FRAME) {
+			startFrame(reassembler);
+			return 0;
+		}
+
+		return endFrame(reassembler);
+	}
+
+	return 0;
+}
+
+int reassembleFrame(FrameReassembler *reassembler, const uint8_t data[], int size, int *position) {
+	while (*position < size) {
+		uint8_t b;
+		int copySize;
+		int result;
+
+		switch (reassembler->state) {
+		case REASSEMBLER_HUNTING:
+			hunt(reassembler, data, size, position);
+			break;
+		case REASSEMBLER_STARTED:
+			b = data[(*position)++];
+			// The end flag of a frame we joined in the middle, this one may begin the next.
+			if (b == FLAG_DOC_BEGINNING_END)
+				break;
+
+			reassembler->frame[reassembler->frameSize++] = b;
+			if (b == FLAG_TLV_FRAME || b == FLAG_COMPRESSED_FRAME) {
+				reassembler->state = REASSEMBLER_LENGTH;
+			} else {
+				reassembler->state = REASSEMBLER_ESCAPED_BODY;
+				reassembler->escaped = b == FLAG_ESCAPE;
+			}
+			break;
+		case REASSEMBLER_ESCAPED_BODY:
+			result = takeEscapedBody(reassembler, data, size, position);
+			if (result != 0)
+				return result;
+			break;
+		case REASSEMBLER_LENGTH:
+			// A TLV or compressed frame tells its length, its values may hold any byte.
+			b = data[(*position)++];
+			if (SIZE_TLV_FRAME_PREFIX + b > MAX_SIZE_PROTOCOL_DATA)
+				return dropFrame(reassembler);
+
+			reassembler->frame[reassembler->frameSize++] = b;
+			reassembler->remaining = b;
+			reassembler->state = REASSEMBLER_LENGTH_BODY;
+			if (reassembler->remaining == 0)
+				return endFrame(reassembler);
+			break;
+		case REASSEMBLER_LENGTH_BODY:
+			copySize = size - *position < reassembler->remaining ? size - *position : reassembler->remaining;
+			memcpy(reassembler->frame + reassembler->frameSize, data + *position, copySize);
+			reassembler->frameSize += copySize;
+			reassembler->remaining -= copySize;
+			*position += copySize;
+			if (reassembler->remaining == 0)
+				return endFrame(reassembler);
+			break;
+		}
+	}
+
+	return 0;
+}
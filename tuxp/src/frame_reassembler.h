@@ -0,0 +1,38 @@
+#ifndef MUD_FRAME_REASSEMBLER_H
+#define MUD_FRAME_REASSEMBLER_H
+
+#include "tuxp.h"
+
+// Flag, name and end flag of the shortest escaped frame, a bare protocol.
+#define MIN_SIZE_ESCAPED_FRAME 5
+
+typedef enum {
+	REASSEMBLER_HUNTING,
+	REASSEMBLER_STARTED,
+	REASSEMBLER_ESCAPED_BODY,
+	REASSEMBLER_LENGTH,
+	REASSEMBLER_LENGTH_BODY
+} ReassemblerState;
+
+// Cuts frames out of a byte stream as the bytes come. Chunks may end anywhere and hold any
+// number of frames, the state is kept between them so every byte is looked at once.
+typedef struct {
+	ReassemblerState state;
+	bool escaped;
+	int remaining;
+	int frameSize;
+	uint8_t frame[MAX_SIZE_PROTOCOL_DATA];
+} FrameReassembler;
+
+void resetFrameReassembler(FrameReassembler *reassembler);
+
+// Takes bytes from data[*position] on until a frame is complete or the data runs out, and
+// moves *position past them. Returns the size of the frame, which stays in frame until the
+// next call, or 0 if more data is needed. A frame which doesn't fit is dropped with
+// TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, the bytes after it can still be reassembled.
+int reassembleFrame(FrameReassembler *reassembler, const uint8_t data[], int size, int *position);
+
+// Whether bytes of a frame are held, waiting for the rest of it.
+bool isReassemblingFrame(const FrameReassembler *reassembler);
+
+#endif
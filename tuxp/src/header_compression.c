@@ -0,0 +1,223 @@
+#include <string.h>
+
+#include "tuxp.h"
+#include "header_compression.h"
+
+// The beginning flag, the compressed frame flag, the length of the frame and the rule ID.
+#define SIZE_COMPRESSED_FRAME_PREFIX 4
+
+#define POSITION_ESCAPED_TINY_ID 8
+#define POSITION_TLV_TINY_ID (SIZE_TLV_FRAME_PREFIX + 8)
+
+#define FLAG_ACK_REQUIRED_COMPRESSION_RULE 0x80
+
+void initCompressionContext(CompressionContext *context, ProtocolFormat format) {
+	context->format = format;
+	context->rulesSize = 0;
+}
+
+static bool isValidRule(LanEnvelopeType envelopeType) {
+	return envelopeType == LAN_ENVELOPE_EXECUTION ||
+		envelopeType == LAN_ENVELOPE_NOTIFICATION ||
+		envelopeType == LAN_ENVELOPE_REPORT;
+}
+
+// Returns the rule ID.
+int addCompressionRule(CompressionContext *context, LanEnvelopeType envelopeType, bool ackRequired,
+			ProtocolName name) {
+	if (!isValidRule(envelopeType))
+		return TUXP_ERROR_NOT_VALID_PROTOCOL;
+
+	if (context->rulesSize >= MAX_SIZE_COMPRESSION_RULES)
+		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+	CompressionRule *rule = context->rules + context->rulesSize;
+	rule->envelopeType = envelopeType;
+	rule->ackRequired = ackRequired;
+	rule->name = name;
+
+	return context->rulesSize++;
+}
+
+// Rules are sent by the DAC service as a bytes attribute of the allocation.
+int encodeCompressionRules(const CompressionContext *context, uint8_t buff[], int buffSize) {
+	if (context->rulesSize * SIZE_COMPRESSION_RULE > buffSize)
+		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+	for (int i = 0; i < context->rulesSize; i++) {
+		const CompressionRule *rule = context->rules + i;
+		uint8_t *encoded = buff + i * SIZE_COMPRESSION_RULE;
+		encoded[0] = rule->envelopeType | (rule->ackRequired ? FLAG_ACK_REQUIRED_COMPRESSION_RULE : 0);
+		encoded[1] = rule->name.ns[0];
+		encoded[2] = rule->name.ns[1];
+		encoded[3] = rule->name.localName;
+	}
+
+	return context->rulesSize * SIZE_COMPRESSION_RULE;
+}
+
+int decodeCompressionRules(CompressionContext *context, const uint8_t data[], int size) {
+	if (size % SIZE_COMPRESSION_RULE != 0 || size / SIZE_COMPRESSION_RULE > MAX_SIZE_COMPRESSION_RULES)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	context->rulesSize = 0;
+	for (int i = 0; i < size; i += SIZE_COMPRESSION_RULE) {
+		ProtocolName name = {{data[i + 1], data[i + 2]}, data[i + 3]};
+		int result = addCompressionRule(context, data[i] & ~FLAG_ACK_REQUIRED_COMPRESSION_RULE,
+			(data[i] & FLAG_ACK_REQUIRED_COMPRESSION_RULE) != 0, name);
+		if (result < 0) {
+			context->rulesSize = 0;
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+		}
+	}
+
+	return 0;
+}
+
+bool isCompressedFrame(const uint8_t data[], int size) {
+	return size >= 2 && data[0] == FLAG_DOC_BEGINNING_END && data[1] == FLAG_COMPRESSED_FRAME;
+}
+
+static int findRule(const CompressionContext *context, const LanEnvelope *envelope) {
+	for (int i = 0; i < context->rulesSize; i++) {
+		const CompressionRule *rule = context->rules + i;
+		if (rule->envelopeType == envelope->type && rule->ackRequired == envelope->ackRequired &&
+				rule->name.ns[0] == envelope->inner.name.ns[0] &&
+				rule->name.ns[1] == envelope->inner.name.ns[1] &&
+				rule->name.localName == envelope->inner.name.localName)
+			return i;
+	}
+
+	return -1;
+}
+
+// The prefix is the envelope of the rule up to the name of its inner protocol. Everything in
+// it but the TinyId and, in TLV, the lengths is implied by the rule.
+static int encodePrefix(const CompressionContext *context, int ruleId, TinyId tinyId,
+			uint8_t buff[], int buffSize) {
+	const CompressionRule *rule = context->rules + ruleId;
+	Protocol bare = createProtocol(rule->name);
+	int size = encodeLanEnvelopeIn(context->format, rule->envelopeType, tinyId, rule->ackRequired, &bare,
+		buff, buffSize, 0);
+	if (size < 0)
+		return size;
+
+	// Drop the end flag of a bare protocol, or the attributes size and flags of a TLV one.
+	return size - (context->format == PROTOCOL_FORMAT_TLV ? 2 : 1);
+}
+
+static bool isSamePrefix(ProtocolFormat format, const uint8_t data[], const uint8_t prefix[], int prefixSize) {
+	for (int i = 0; i < prefixSize; i++) {
+		if (format == PROTOCOL_FORMAT_TLV && (i == SIZE_TLV_FRAME_PREFIX - 1 || i == prefixSize - 4))
+			continue;
+
+		if (data[i] != prefix[i])
+			return false;
+	}
+
+	return true;
+}
+
+static int escapedTinyIdSize(const uint8_t data[], int size) {
+	int position = 0;
+	for (int i = 0; i < SIZE_THINGS_TINY_ID; i++) {
+		if (position >= size)
+			return -1;
+
+		position += data[position] == FLAG_ESCAPE ? 2 : 1;
+	}
+
+	return position <= size ? position : -1;
+}
+
+// Compresses in place. A frame which matches no rule is left as it is.
+int compressFrame(const CompressionContext *context, uint8_t data[], int size) {
+	if (context->rulesSize == 0 || isCompressedFrame(data, size))
+		return size;
+
+	ProtocolData pData = {data, size};
+	ProtocolView view;
+	LanEnvelope envelope;
+	if (viewProtocol(&pData, &view) != 0 || view.format != context->format ||
+			decodeLanEnvelopeView(&view, &envelope) != 0 || envelope.type == LAN_ENVELOPE_ANSWER ||
+			envelope.view.childrenSize != 1)
+		return size;
+
+	int ruleId = findRule(context, &envelope);
+	if (ruleId < 0)
+		return size;
+
+	uint8_t prefix[MAX_SIZE_PROTOCOL_DATA];
+	int prefixSize = encodePrefix(context, ruleId, envelope.tinyId, prefix, sizeof(prefix));
+	if (prefixSize < 0 || prefixSize > size || !isSamePrefix(context->format, data, prefix, prefixSize))
+		return size;
+
+	int tinyIdPosition;
+	int tinyIdSize;
+	if (context->format == PROTOCOL_FORMAT_TLV) {
+		tinyIdPosition = POSITION_TLV_TINY_ID;
+		tinyIdSize = SIZE_THINGS_TINY_ID;
+	} else {
+		tinyIdPosition = POSITION_ESCAPED_TINY_ID;
+		tinyIdSize = escapedTinyIdSize(prefix + tinyIdPosition, prefixSize - tinyIdPosition);
+	}
+
+	int headerSize = SIZE_COMPRESSED_FRAME_PREFIX + tinyIdSize;
+	int residueSize = size - prefixSize;
+	memmove(data + headerSize, data + prefixSize, residueSize);
+
+	data[0] = FLAG_DOC_BEGINNING_END;
+	data[1] = FLAG_COMPRESSED_FRAME;
+	data[2] = headerSize + residueSize - (SIZE_TLV_FRAME_PREFIX);
+	data[3] = ruleId;
+	memcpy(data + SIZE_COMPRESSED_FRAME_PREFIX, prefix + tinyIdPosition, tinyIdSize);
+
+	return headerSize + residueSize;
+}
+
+// Restores the frame as it was before it was compressed.
+int decompressFrame(const CompressionContext *context, const uint8_t data[], int size,
+			uint8_t buff[], int buffSize) {
+	if (!isCompressedFrame(data, size) || size < SIZE_COMPRESSED_FRAME_PREFIX ||
+			data[2] != size - SIZE_TLV_FRAME_PREFIX)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	int ruleId = data[3];
+	if (ruleId >= context->rulesSize)
+		return TUXP_ERROR_UNKNOWN_COMPRESSION_RULE;
+
+	const uint8_t *tinyIdData = data + SIZE_COMPRESSED_FRAME_PREFIX;
+	int tinyIdSize;
+	TinyId tinyId;
+	if (context->format == PROTOCOL_FORMAT_TLV) {
+		tinyIdSize = SIZE_THINGS_TINY_ID;
+		if (size - SIZE_COMPRESSED_FRAME_PREFIX < tinyIdSize)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		memcpy(tinyId, tinyIdData, SIZE_THINGS_TINY_ID);
+	} else {
+		tinyIdSize = escapedTinyIdSize(tinyIdData, size - SIZE_COMPRESSED_FRAME_PREFIX);
+		if (tinyIdSize < 0 || viewUnescape(tinyIdData, tinyIdSize, tinyId, SIZE_THINGS_TINY_ID) !=
+				SIZE_THINGS_TINY_ID)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+	}
+
+	int residueSize = size - SIZE_COMPRESSED_FRAME_PREFIX - tinyIdSize;
+	if (residueSize < (context->format == PROTOCOL_FORMAT_TLV ? 2 : 1))
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	int prefixSize = encodePrefix(context, ruleId, tinyId, buff, buffSize);
+	if (prefixSize < 0)
+		return prefixSize;
+
+	if (prefixSize + residueSize > buffSize)
+		return TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE;
+
+	memcpy(buff + prefixSize, tinyIdData + tinyIdSize, residueSize);
+	if (context->format == PROTOCOL_FORMAT_TLV) {
+		buff[SIZE_TLV_FRAME_PREFIX - 1] = prefixSize + residueSize - SIZE_TLV_FRAME_PREFIX;
+		buff[prefixSize - 4] = residueSize + 3;
+	}
+
+	return prefixSize + residueSize;
+}
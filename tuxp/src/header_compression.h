@@ -0,0 +1,35 @@
+#ifndef MUD_HEADER_COMPRESSION_H
+#define MUD_HEADER_COMPRESSION_H
+
+#include "tuxp.h"
+
+#define SIZE_COMPRESSION_RULE 4
+#define MAX_SIZE_COMPRESSION_RULES (MAX_SIZE_ATTRIBUTE_DATA / SIZE_COMPRESSION_RULE)
+
+// A rule stands for a LAN envelope with a single inner protocol. Both ends hold the same
+// rules, so a frame which matches one is sent as the rule ID, the TinyId and the rest of
+// the inner protocol.
+typedef struct {
+	LanEnvelopeType envelopeType;
+	bool ackRequired;
+	ProtocolName name;
+} CompressionRule;
+
+typedef struct {
+	ProtocolFormat format;
+	uint8_t rulesSize;
+	CompressionRule rules[MAX_SIZE_COMPRESSION_RULES];
+} CompressionContext;
+
+void initCompressionContext(CompressionContext *context, ProtocolFormat format);
+int addCompressionRule(CompressionContext *context, LanEnvelopeType envelopeType, bool ackRequired,
+	ProtocolName name);
+int encodeCompressionRules(const CompressionContext *context, uint8_t buff[], int buffSize);
+int decodeCompressionRules(CompressionContext *context, const uint8_t data[], int size);
+
+bool isCompressedFrame(const uint8_t data[], int size);
+int compressFrame(const CompressionContext *context, uint8_t data[], int size);
+int decompressFrame(const CompressionContext *context, const uint8_t data[], int size,
+	uint8_t buff[], int buffSize);
+
+#endif
@@ -0,0 +1,208 @@
+#include <string.h>
+
+#include "tuxp.h"
+#include "native_values.h"
+
+bool isNativeType(DataType dataType) {
+	return dataType == TYPE_VARINT ||
+		dataType == TYPE_FLOAT16 ||
+		dataType == TYPE_FLOAT32 ||
+		dataType == TYPE_BOOLS;
+}
+
+uint8_t getNativeTypeTag(DataType dataType) {
+	if (dataType == TYPE_VARINT) {
+		return TAG_VARINT_TYPE;
+	} else if (dataType == TYPE_FLOAT16) {
+		return TAG_FLOAT16_TYPE;
+	} else if (dataType == TYPE_FLOAT32) {
+		return TAG_FLOAT32_TYPE;
+	} else if (dataType == TYPE_INT_SERIES) {
+		return TAG_INT_SERIES_TYPE;
+	} else if (dataType == TYPE_FLOAT_SERIES) {
+		return TAG_FLOAT_SERIES_TYPE;
+	} else { // dataType == TYPE_BOOLS
+		return TAG_BOOLS_TYPE;
+	}
+}
+
+bool getNativeType(uint8_t tag, DataType *dataType) {
+	if (tag == TAG_VARINT_TYPE) {
+		*dataType = TYPE_VARINT;
+	} else if (tag == TAG_FLOAT16_TYPE) {
+		*dataType = TYPE_FLOAT16;
+	} else if (tag == TAG_FLOAT32_TYPE) {
+		*dataType = TYPE_FLOAT32;
+	} else if (tag == TAG_BOOLS_TYPE) {
+		*dataType = TYPE_BOOLS;
+	} else if (tag == TAG_INT_SERIES_TYPE) {
+		*dataType = TYPE_INT_SERIES;
+	} else if (tag == TAG_FLOAT_SERIES_TYPE) {
+		*dataType = TYPE_FLOAT_SERIES;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+// Zigzag keeps small negative numbers small, 7 bits a byte with the high bit as continuation.
+int encodeVarint(int32_t value, uint8_t buff[]) {
+	uint32_t zigzag = ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+
+	int size = 0;
+	while (zigzag >= 0x80) {
+		buff[size] = (uint8_t)(zigzag | 0x80);
+		zigzag >>= 7;
+		size++;
+	}
+	buff[size] = (uint8_t)zigzag;
+
+	return size + 1;
+}
+
+int decodeVarint(const uint8_t data[], int size, int32_t *value) {
+	uint32_t zigzag = 0;
+	for (int i = 0; i < size && i < MAX_SIZE_VARINT; i++) {
+		zigzag |= (uint32_t)(data[i] & 0x7f) << (7 * i);
+		if ((data[i] & 0x80) == 0) {
+			*value = (int32_t)((zigzag >> 1) ^ (~(zigzag & 1) + 1));
+			return i + 1;
+		}
+	}
+
+	return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+}
+
+static uint32_t floatToBits(float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	return bits;
+}
+
+static float bitsToFloat(uint32_t bits) {
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+
+	return value;
+}
+
+// Rounds to the nearest, and a tie to the even one as IEEE 754 does.
+static bool isRoundedUp(uint32_t dropped, uint32_t halfway, uint16_t kept) {
+	return dropped > halfway || (dropped == halfway && (kept & 1));
+}
+
+uint16_t encodeFloat16(float value) {
+	uint32_t bits = floatToBits(value);
+	uint16_t sign = (bits >> 16) & 0x8000;
+	int16_t floatExponent = (bits >> 23) & 0xff;
+	uint32_t mantissa = bits & 0x7fffff;
+
+	// Infinity or NaN.
+	if (floatExponent == 0xff)
+		return sign | 0x7c00 | (mantissa != 0 ? 0x0200 : 0);
+
+	int16_t exponent = floatExponent - 127 + 15;
+	if (exponent >= 0x1f)
+		return sign | 0x7c00;
+
+	// Subnormal or too small to be represented.
+	if (exponent <= 0) {
+		if (exponent < -10)
+			return sign;
+
+		mantissa |= 0x800000;
+		int shift = 14 - exponent;
+		uint16_t half = mantissa >> shift;
+		if (isRoundedUp(mantissa & ((1UL << shift) - 1), 1UL << (shift - 1), half))
+			half++;
+
+		return sign | half;
+	}
+
+	// A carry out of the mantissa while rounding rightly bumps the exponent.
+	uint16_t half = sign | (exponent << 10) | (mantissa >> 13);
+	if (isRoundedUp(mantissa & 0x1fff, 0x1000, half))
+		half++;
+
+	return half;
+}
+
+float decodeFloat16(uint16_t half) {
+	uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1f;
+	uint32_t mantissa = half & 0x3ff;
+
+	if (exponent == 0x1f)
+		return bitsToFloat(sign | 0x7f800000 | (mantissa << 13));
+
+	if (exponent != 0)
+		return bitsToFloat(sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+
+	if (mantissa == 0)
+		return bitsToFloat(sign);
+
+	// Normalize a subnormal.
+	exponent = 127 - 15 + 1;
+	while ((mantissa & 0x400) == 0) {
+		mantissa <<= 1;
+		exponent--;
+	}
+
+	return bitsToFloat(sign | (exponent << 23) | ((mantissa & 0x3ff) << 13));
+}
+
+// Multi-byte values are little endian.
+int encodeNativeValue(DataType dataType, ProtocolAttributeValue value, uint8_t buff[]) {
+	if (dataType == TYPE_VARINT) {
+		return encodeVarint(value.iValue, buff);
+	} else if (dataType == TYPE_FLOAT16) {
+		uint16_t half = encodeFloat16(value.fValue);
+		buff[0] = half & 0xff;
+		buff[1] = half >> 8;
+
+		return 2;
+	} else if (dataType == TYPE_FLOAT32) {
+		uint32_t bits = floatToBits(value.fValue);
+		for (int i = 0; i < 4; i++)
+			buff[i] = (bits >> (8 * i)) & 0xff;
+
+		return 4;
+	} else { // dataType == TYPE_BOOLS
+		buff[0] = value.boolsValue;
+		return 1;
+	}
+}
+
+int decodeNativeValue(DataType dataType, const uint8_t data[], int size, ProtocolAttributeValue *value) {
+	if (dataType == TYPE_VARINT) {
+		int32_t iValue;
+		if (decodeVarint(data, size, &iValue) != size)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		value->iValue = iValue;
+	} else if (dataType == TYPE_FLOAT16) {
+		if (size != 2)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		value->fValue = decodeFloat16(data[0] | ((uint16_t)data[1] << 8));
+	} else if (dataType == TYPE_FLOAT32) {
+		if (size != 4)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		uint32_t bits = 0;
+		for (int i = 0; i < 4; i++)
+			bits |= (uint32_t)data[i] << (8 * i);
+		value->fValue = bitsToFloat(bits);
+	} else if (dataType == TYPE_BOOLS) {
+		if (size != 1)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		value->boolsValue = data[0];
+	} else {
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+	}
+
+	return 0;
+}
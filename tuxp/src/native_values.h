@@ -0,0 +1,32 @@
+#ifndef MUD_NATIVE_VALUES_H
+#define MUD_NATIVE_VALUES_H
+
+#include "protocols.h"
+
+// A native value starts with an escape flag followed by a type tag. Escape flags are
+// only ever followed by flag bytes, so the tag can't be taken as an escaped byte.
+#define TAG_VARINT_TYPE 0x01
+#define TAG_FLOAT16_TYPE 0x02
+#define TAG_FLOAT32_TYPE 0x03
+#define TAG_BOOLS_TYPE 0x04
+// Series are tagged the same way, but they are variable in size and kept as bytes.
+#define TAG_INT_SERIES_TYPE 0x05
+#define TAG_FLOAT_SERIES_TYPE 0x06
+
+#define MAX_SIZE_VARINT 5
+#define MAX_SIZE_NATIVE_VALUE MAX_SIZE_VARINT
+#define MAX_SIZE_BOOLS 8
+
+bool isNativeType(DataType dataType);
+uint8_t getNativeTypeTag(DataType dataType);
+bool getNativeType(uint8_t tag, DataType *dataType);
+
+int encodeVarint(int32_t value, uint8_t buff[]);
+int decodeVarint(const uint8_t data[], int size, int32_t *value);
+uint16_t encodeFloat16(float value);
+float decodeFloat16(uint16_t half);
+
+int encodeNativeValue(DataType dataType, ProtocolAttributeValue value, uint8_t buff[]);
+int decodeNativeValue(DataType dataType, const uint8_t data[], int size, ProtocolAttributeValue *value);
+
+#endif
@@ -0,0 +1,139 @@
+#include <stdint.h>
+
+#include "tuxp.h"
+#include "allocator.h"
+#include "pool_allocator.h"
+
+typedef union PoolBlock {
+	union PoolBlock *next;
+	void *pointer;
+	long lValue;
+	double dValue;
+} PoolBlock;
+
+#define POOL_BLOCK_UNITS(size) (((size) + sizeof(PoolBlock) - 1) / sizeof(PoolBlock))
+
+#define SIZE_POOL_VALUE_BLOCK (MAX_SIZE_ATTRIBUTE_DATA + 1)
+#define SIZE_POOL_TEXT_BLOCK (MAX_SIZE_TEXT_DATA + 1)
+#define SIZE_POOL_FRAME_BLOCK MAX_SIZE_PROTOCOL_DATA
+#define SIZE_POOL_PROTOCOL_BLOCK sizeof(Protocol)
+
+typedef struct {
+	PoolBlock *storage;
+	int blockSize;
+	int blockUnits;
+	int blocks;
+	PoolBlock *freeList;
+	int freeBlocks;
+} Pool;
+
+#if SIZE_POOL_VALUE_BLOCKS > 0
+static PoolBlock valueStorage[SIZE_POOL_VALUE_BLOCKS * POOL_BLOCK_UNITS(SIZE_POOL_VALUE_BLOCK)];
+#define POOL_VALUE_STORAGE valueStorage
+#else
+#define POOL_VALUE_STORAGE NULL
+#endif
+
+#if SIZE_POOL_TEXT_BLOCKS > 0
+static PoolBlock textStorage[SIZE_POOL_TEXT_BLOCKS * POOL_BLOCK_UNITS(SIZE_POOL_TEXT_BLOCK)];
+#define POOL_TEXT_STORAGE textStorage
+#else
+#define POOL_TEXT_STORAGE NULL
+#endif
+
+#if SIZE_POOL_FRAME_BLOCKS > 0
+static PoolBlock frameStorage[SIZE_POOL_FRAME_BLOCKS * POOL_BLOCK_UNITS(SIZE_POOL_FRAME_BLOCK)];
+#define POOL_FRAME_STORAGE frameStorage
+#else
+#define POOL_FRAME_STORAGE NULL
+#endif
+
+#if SIZE_POOL_PROTOCOL_BLOCKS > 0
+static PoolBlock protocolStorage[SIZE_POOL_PROTOCOL_BLOCKS * POOL_BLOCK_UNITS(SIZE_POOL_PROTOCOL_BLOCK)];
+#define POOL_PROTOCOL_STORAGE protocolStorage
+#else
+#define POOL_PROTOCOL_STORAGE NULL
+#endif
+
+static Pool pools[SIZE_POOL_CLASSES] = {
+	{POOL_VALUE_STORAGE, SIZE_POOL_VALUE_BLOCK, POOL_BLOCK_UNITS(SIZE_POOL_VALUE_BLOCK), SIZE_POOL_VALUE_BLOCKS, NULL, 0},
+	{POOL_TEXT_STORAGE, SIZE_POOL_TEXT_BLOCK, POOL_BLOCK_UNITS(SIZE_POOL_TEXT_BLOCK), SIZE_POOL_TEXT_BLOCKS, NULL, 0},
+	{POOL_FRAME_STORAGE, SIZE_POOL_FRAME_BLOCK, POOL_BLOCK_UNITS(SIZE_POOL_FRAME_BLOCK), SIZE_POOL_FRAME_BLOCKS, NULL, 0},
+	{POOL_PROTOCOL_STORAGE, SIZE_POOL_PROTOCOL_BLOCK, POOL_BLOCK_UNITS(SIZE_POOL_PROTOCOL_BLOCK), SIZE_POOL_PROTOCOL_BLOCKS, NULL, 0}
+};
+
+static bool poolInitialized = false;
+
+void initPoolAllocator() {
+	for (int i = 0; i < SIZE_POOL_CLASSES; i++) {
+		Pool *pool = pools + i;
+		pool->freeList = NULL;
+		for (int j = pool->blocks - 1; j >= 0; j--) {
+			PoolBlock *block = pool->storage + j * pool->blockUnits;
+			block->next = pool->freeList;
+			pool->freeList = block;
+		}
+		pool->freeBlocks = pool->blocks;
+	}
+
+	poolInitialized = true;
+}
+
+void usePoolAllocator() {
+	if (!poolInitialized)
+		initPoolAllocator();
+
+	tuxpSetAllocator(poolAlloc, poolFree, NULL);
+}
+
+void *poolAlloc(size_t size, void *context) {
+	(void)context;
+	if (!poolInitialized)
+		initPoolAllocator();
+
+	// Spill over into a larger class when the best fitting one is exhausted.
+	for (int i = 0; i < SIZE_POOL_CLASSES; i++) {
+		Pool *pool = pools + i;
+		if (size > (size_t)pool->blockSize || !pool->freeList)
+			continue;
+
+		PoolBlock *block = pool->freeList;
+		pool->freeList = block->next;
+		pool->freeBlocks--;
+
+		return block;
+	}
+
+	return NULL;
+}
+
+static Pool *findOwnerPool(void *p) {
+	for (int i = 0; i < SIZE_POOL_CLASSES; i++) {
+		Pool *pool = pools + i;
+		PoolBlock *block = p;
+		if (pool->blocks > 0 && block >= pool->storage && block < pool->storage + pool->blocks * pool->blockUnits)
+			return pool;
+	}
+
+	return NULL;
+}
+
+void poolFree(void *p, size_t size, void *context) {
+	(void)size;
+	(void)context;
+	Pool *pool = findOwnerPool(p);
+	if (!pool)
+		return;
+
+	PoolBlock *block = p;
+	block->next = pool->freeList;
+	pool->freeList = block;
+	pool->freeBlocks++;
+}
+
+int getPoolFreeBlocks(PoolClass poolClass) {
+	if (!poolInitialized)
+		initPoolAllocator();
+
+	return pools[poolClass].freeBlocks;
+}
@@ -0,0 +1,37 @@
+#ifndef MUD_POOL_ALLOCATOR_H
+#define MUD_POOL_ALLOCATOR_H
+
+#include <stddef.h>
+
+#ifndef SIZE_POOL_VALUE_BLOCKS
+#define SIZE_POOL_VALUE_BLOCKS 12
+#endif
+
+#ifndef SIZE_POOL_TEXT_BLOCKS
+#define SIZE_POOL_TEXT_BLOCKS 4
+#endif
+
+#ifndef SIZE_POOL_FRAME_BLOCKS
+#define SIZE_POOL_FRAME_BLOCKS 4
+#endif
+
+// Child protocols. A block holds a whole Protocol, so the class is opt-in.
+#ifndef SIZE_POOL_PROTOCOL_BLOCKS
+#define SIZE_POOL_PROTOCOL_BLOCKS 0
+#endif
+
+typedef enum {
+	POOL_CLASS_VALUE,
+	POOL_CLASS_TEXT,
+	POOL_CLASS_FRAME,
+	POOL_CLASS_PROTOCOL,
+	SIZE_POOL_CLASSES
+} PoolClass;
+
+void initPoolAllocator();
+void usePoolAllocator();
+void *poolAlloc(size_t size, void *context);
+void poolFree(void *p, size_t size, void *context);
+int getPoolFreeBlocks(PoolClass poolClass);
+
+#endif
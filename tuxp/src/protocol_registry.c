@@ -0,0 +1,174 @@
+#include <string.h>
+
+#include "tuxp.h"
+#include "protocol_registry.h"
+
+uint32_t packProtocolName(ProtocolName name) {
+	return ((uint32_t)name.ns[0] << 16) | ((uint32_t)name.ns[1] << 8) | name.localName;
+}
+
+ProtocolName unpackProtocolName(uint32_t packed) {
+	ProtocolName name = {{(packed >> 16) & 0xff, (packed >> 8) & 0xff}, packed & 0xff};
+	return name;
+}
+
+void initProtocolRegistry(ProtocolRegistry *registry, uint32_t keys[], void *values[], int capacity) {
+	registry->size = 0;
+	registry->capacity = capacity;
+	registry->keys = keys;
+	registry->values = values;
+}
+
+// The position of the key, or where it would go.
+static int searchKey(const ProtocolRegistry *registry, uint32_t key) {
+	int low = 0;
+	int high = registry->size;
+	while (low < high) {
+		int middle = (low + high) / 2;
+		if (registry->keys[middle] < key)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+
+	return low;
+}
+
+int registryPut(ProtocolRegistry *registry, ProtocolName name, void *value) {
+	uint32_t key = packProtocolName(name);
+	int position = searchKey(registry, key);
+	if (position < registry->size && registry->keys[position] == key) {
+		registry->values[position] = value;
+		return 0;
+	}
+
+	if (registry->size >= registry->capacity)
+		return TUXP_ERROR_OUT_OF_MEMEORY;
+
+	int moved = registry->size - position;
+	memmove(registry->keys + position + 1, registry->keys + position, moved * sizeof(uint32_t));
+	memmove(registry->values + position + 1, registry->values + position, moved * sizeof(void *));
+	registry->keys[position] = key;
+	registry->values[position] = value;
+	registry->size++;
+
+	return 0;
+}
+
+void *registryGet(const ProtocolRegistry *registry, ProtocolName name) {
+	uint32_t key = packProtocolName(name);
+	int position = searchKey(registry, key);
+	if (position < registry->size && registry->keys[position] == key)
+		return registry->values[position];
+
+	return NULL;
+}
+
+void *registryRemove(ProtocolRegistry *registry, ProtocolName name) {
+	uint32_t key = packProtocolName(name);
+	int position = searchKey(registry, key);
+	if (position >= registry->size || registry->keys[position] != key)
+		return NULL;
+
+	void *value = registry->values[position];
+	int moved = registry->size - position - 1;
+	memmove(registry->keys + position, registry->keys + position + 1, moved * sizeof(uint32_t));
+	memmove(registry->values + position, registry->values + position + 1, moved * sizeof(void *));
+	registry->size--;
+
+	return value;
+}
+
+void initProtocolHashRegistry(ProtocolHashRegistry *registry, uint32_t keys[], void *values[], int capacity) {
+	registry->size = 0;
+	registry->capacity = capacity;
+	registry->keys = keys;
+	registry->values = values;
+	for (int i = 0; i < capacity; i++)
+		keys[i] = PROTOCOL_REGISTRY_EMPTY_KEY;
+}
+
+static int hashKey(const ProtocolHashRegistry *registry, uint32_t key) {
+	uint32_t hash = key * 0x9e3779b1;
+	hash ^= hash >> 15;
+
+	return hash & (registry->capacity - 1);
+}
+
+static int probeKey(const ProtocolHashRegistry *registry, uint32_t key) {
+	int slot = hashKey(registry, key);
+	while (registry->keys[slot] != key && registry->keys[slot] != PROTOCOL_REGISTRY_EMPTY_KEY)
+		slot = (slot + 1) & (registry->capacity - 1);
+
+	return slot;
+}
+
+int hashRegistryPut(ProtocolHashRegistry *registry, ProtocolName name, void *value) {
+	uint32_t key = packProtocolName(name);
+	int slot = probeKey(registry, key);
+	if (registry->keys[slot] == key) {
+		registry->values[slot] = value;
+		return 0;
+	}
+
+	if ((registry->size + 1) * 4 > registry->capacity * 3)
+		return TUXP_ERROR_OUT_OF_MEMEORY;
+
+	registry->keys[slot] = key;
+	registry->values[slot] = value;
+	registry->size++;
+
+	return 0;
+}
+
+void *hashRegistryGet(const ProtocolHashRegistry *registry, ProtocolName name) {
+	int slot = probeKey(registry, packProtocolName(name));
+	return registry->keys[slot] == PROTOCOL_REGISTRY_EMPTY_KEY ? NULL : registry->values[slot];
+}
+
+// Keys after the removed one move back into the gap when it's on their probe path, so no
+// tombstones are left to slow down lookups.
+void *hashRegistryRemove(ProtocolHashRegistry *registry, ProtocolName name) {
+	int mask = registry->capacity - 1;
+	int slot = probeKey(registry, packProtocolName(name));
+	if (registry->keys[slot] == PROTOCOL_REGISTRY_EMPTY_KEY)
+		return NULL;
+
+	void *value = registry->values[slot];
+	int gap = slot;
+	for (int next = (gap + 1) & mask; registry->keys[next] != PROTOCOL_REGISTRY_EMPTY_KEY;
+			next = (next + 1) & mask) {
+		int home = hashKey(registry, registry->keys[next]);
+		if (((next - home) & mask) >= ((next - gap) & mask)) {
+			registry->keys[gap] = registry->keys[next];
+			registry->values[gap] = registry->values[next];
+			gap = next;
+		}
+	}
+
+	registry->keys[gap] = PROTOCOL_REGISTRY_EMPTY_KEY;
+	registry->size--;
+
+	return value;
+}
+
+void initProtocolNamespaceTable(ProtocolNamespaceTable *table, uint8_t ns0, uint8_t ns1) {
+	table->ns[0] = ns0;
+	table->ns[1] = ns1;
+	memset(table->values, 0, sizeof(table->values));
+}
+
+bool namespaceTablePut(ProtocolNamespaceTable *table, ProtocolName name, void *value) {
+	if (name.ns[0] != table->ns[0] || name.ns[1] != table->ns[1])
+		return false;
+
+	table->values[name.localName] = value;
+	return true;
+}
+
+void *namespaceTableGet(const ProtocolNamespaceTable *table, ProtocolName name) {
+	if (name.ns[0] != table->ns[0] || name.ns[1] != table->ns[1])
+		return NULL;
+
+	return table->values[name.localName];
+}
@@ -0,0 +1,52 @@
+#ifndef MUD_PROTOCOL_REGISTRY_H
+#define MUD_PROTOCOL_REGISTRY_H
+
+#include "tuxp.h"
+
+// A protocol name packs into the low 24 bits of a key, ns[0] highest, so keys sort as the
+// names do. No name packs into the empty key.
+#define PROTOCOL_REGISTRY_EMPTY_KEY 0xffffffff
+
+uint32_t packProtocolName(ProtocolName name);
+ProtocolName unpackProtocolName(uint32_t packed);
+
+// Sorted keys searched in halves, for the few protocols a thing has. The arrays are the
+// caller's, so they may be static.
+typedef struct {
+	int size;
+	int capacity;
+	uint32_t *keys;
+	void **values;
+} ProtocolRegistry;
+
+void initProtocolRegistry(ProtocolRegistry *registry, uint32_t keys[], void *values[], int capacity);
+int registryPut(ProtocolRegistry *registry, ProtocolName name, void *value);
+void *registryGet(const ProtocolRegistry *registry, ProtocolName name);
+void *registryRemove(ProtocolRegistry *registry, ProtocolName name);
+
+// Open addressing with linear probing, for the many protocols a gateway routes. The
+// capacity must be a power of two, and the table takes no more than 3/4 of it.
+typedef struct {
+	int size;
+	int capacity;
+	uint32_t *keys;
+	void **values;
+} ProtocolHashRegistry;
+
+void initProtocolHashRegistry(ProtocolHashRegistry *registry, uint32_t keys[], void *values[], int capacity);
+int hashRegistryPut(ProtocolHashRegistry *registry, ProtocolName name, void *value);
+void *hashRegistryGet(const ProtocolHashRegistry *registry, ProtocolName name);
+void *hashRegistryRemove(ProtocolHashRegistry *registry, ProtocolName name);
+
+// Every local name of one namespace, indexed directly. It's worth its 256 pointers only
+// where most of the namespace is in use.
+typedef struct {
+	uint8_t ns[2];
+	void *values[256];
+} ProtocolNamespaceTable;
+
+void initProtocolNamespaceTable(ProtocolNamespaceTable *table, uint8_t ns0, uint8_t ns1);
+bool namespaceTablePut(ProtocolNamespaceTable *table, ProtocolName name, void *value);
+void *namespaceTableGet(const ProtocolNamespaceTable *table, ProtocolName name);
+
+#endif
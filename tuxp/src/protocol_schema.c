@@ -0,0 +1,102 @@
+#include <string.h>
+
+#include "tuxp.h"
+#include "protocol_schema.h"
+#include "native_values.h"
+#include "decimal.h"
+
+bool isSchemaProtocol(const ProtocolView *view, ProtocolName name) {
+	return view->name.ns[0] == name.ns[0] &&
+		view->name.ns[1] == name.ns[1] &&
+		view->name.localName == name.localName;
+}
+
+// Floats sent as chars, as addFloatAttribute() sends them.
+int schemaPutFloat(ProtocolWriter *writer, uint8_t name, float fValue) {
+	char charsData[MAX_SIZE_ATTRIBUTE_DATA + 1];
+	if (formatDecimalFixed(fValue, SIZE_DECIMAL_FRACTION_DIGITS, charsData, sizeof(charsData)) < 0) {
+		if (writer->error == 0)
+			writer->error = TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+		return writer->error;
+	}
+
+	return writerPutString(writer, name, charsData);
+}
+
+static int copyChars(const AttributeView *attribute, char chars[MAX_SIZE_ATTRIBUTE_DATA + 1]) {
+	if (attribute->dataType != TYPE_CHARS)
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+
+	int size = viewCopyValue(attribute, (uint8_t *)chars, MAX_SIZE_ATTRIBUTE_DATA);
+	if (size < 0)
+		return size;
+	chars[size] = '\0';
+
+	return 0;
+}
+
+// Numbers are taken either way they may be sent, as getIntAttributeValue() takes them.
+int schemaDecodeInt(const AttributeView *attribute, int32_t *value) {
+	if (attribute->dataType == TYPE_VARINT) {
+		ProtocolAttributeValue nativeValue;
+		int result = viewDecodeNativeValue(attribute, &nativeValue);
+		if (result != 0)
+			return result;
+
+		*value = nativeValue.iValue;
+		return 0;
+	}
+
+	char chars[MAX_SIZE_ATTRIBUTE_DATA + 1];
+	int result = copyChars(attribute, chars);
+	if (result != 0)
+		return result;
+
+	*value = parseDecimalInt(chars);
+	return 0;
+}
+
+int schemaDecodeFloat(const AttributeView *attribute, float *value) {
+	if (isNativeType(attribute->dataType) && attribute->dataType != TYPE_BOOLS) {
+		ProtocolAttributeValue nativeValue;
+		int result = viewDecodeNativeValue(attribute, &nativeValue);
+		if (result != 0)
+			return result;
+
+		*value = attribute->dataType == TYPE_VARINT ? nativeValue.iValue : nativeValue.fValue;
+		return 0;
+	}
+
+	char chars[MAX_SIZE_ATTRIBUTE_DATA + 1];
+	int result = copyChars(attribute, chars);
+	if (result != 0)
+		return result;
+
+	*value = parseDecimalFloat(chars);
+	return 0;
+}
+
+int schemaDecodeByte(const AttributeView *attribute, DataType dataType, uint8_t *value) {
+	if (attribute->dataType != dataType)
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+
+	*value = attribute->escapeNumber == 0 ? attribute->data[0] : attribute->data[1];
+	return 0;
+}
+
+int schemaDecodeString(const AttributeView *attribute, char value[MAX_SIZE_ATTRIBUTE_DATA + 1]) {
+	return copyChars(attribute, value);
+}
+
+int schemaDecodeBytes(const AttributeView *attribute, SchemaBytes *value) {
+	if (attribute->dataType != TYPE_BYTES)
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+
+	int size = viewCopyValue(attribute, value->data, MAX_SIZE_ATTRIBUTE_DATA);
+	if (size < 0)
+		return size;
+
+	value->size = size;
+	return 0;
+}
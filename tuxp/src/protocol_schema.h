@@ -0,0 +1,145 @@
+#ifndef MUD_PROTOCOL_SCHEMA_H
+#define MUD_PROTOCOL_SCHEMA_H
+
+#include <string.h>
+
+#include "tuxp.h"
+#include "native_values.h"
+
+// A schema lists the attributes of a protocol once, each as ATTRIBUTE(field, name, type):
+//
+//	#define WEATHER_SCHEMA(ATTRIBUTE) ATTRIBUTE(temperature, 0x01, FLOAT) ATTRIBUTE(humidity, 0x02, INT)
+//	DEFINE_PROTOCOL_SCHEMA(Weather, NAME_PROTOCOL_WEATHER, WEATHER_SCHEMA)
+//
+// It gives a WeatherProtocol struct with a field for each attribute, encodeWeatherProtocol()
+// and decodeWeatherProtocol(). The encoder writes the fields straight into the frame. The
+// decoder fills them in one pass over a view and marks which ones were present. Like
+// the getters, it takes the first of attributes with the same name.
+// Attributes are encoded as the add*Attribute() functions of the same type encode them.
+// Duplicate names don't compile, nor does a schema whose frame may not fit in
+// MAX_SIZE_PROTOCOL_DATA.
+
+typedef struct {
+	uint8_t size;
+	uint8_t data[MAX_SIZE_ATTRIBUTE_DATA];
+} SchemaBytes;
+
+#define SCHEMA_FIELD_INT(field) int32_t field;
+#define SCHEMA_FIELD_VARINT(field) int32_t field;
+#define SCHEMA_FIELD_FLOAT(field) float field;
+#define SCHEMA_FIELD_FLOAT16(field) float field;
+#define SCHEMA_FIELD_FLOAT32(field) float field;
+#define SCHEMA_FIELD_BYTE(field) uint8_t field;
+#define SCHEMA_FIELD_RBS(field) uint8_t field;
+#define SCHEMA_FIELD_STRING(field) char field[MAX_SIZE_ATTRIBUTE_DATA + 1];
+#define SCHEMA_FIELD_BYTES(field) SchemaBytes field;
+
+#ifdef TUXP_NATIVE_NUMBERS
+#define SCHEMA_PUT_INT(writer, name, value) writerPutVarint(writer, name, value)
+#define SCHEMA_PUT_FLOAT(writer, name, value) writerPutFloat32(writer, name, value)
+#else
+#define SCHEMA_PUT_INT(writer, name, value) writerPutInt(writer, name, value)
+#define SCHEMA_PUT_FLOAT(writer, name, value) schemaPutFloat(writer, name, value)
+#endif
+#define SCHEMA_PUT_VARINT(writer, name, value) writerPutVarint(writer, name, value)
+#define SCHEMA_PUT_FLOAT16(writer, name, value) writerPutFloat16(writer, name, value)
+#define SCHEMA_PUT_FLOAT32(writer, name, value) writerPutFloat32(writer, name, value)
+#define SCHEMA_PUT_BYTE(writer, name, value) writerPutByte(writer, name, value)
+#define SCHEMA_PUT_RBS(writer, name, value) writerPutRbs(writer, name, value)
+#define SCHEMA_PUT_STRING(writer, name, value) writerPutString(writer, name, value)
+#define SCHEMA_PUT_BYTES(writer, name, value) writerPutBytes(writer, name, (value).data, (value).size)
+
+#define SCHEMA_DECODE_INT(attribute, value) schemaDecodeInt(attribute, value)
+#define SCHEMA_DECODE_VARINT(attribute, value) schemaDecodeInt(attribute, value)
+#define SCHEMA_DECODE_FLOAT(attribute, value) schemaDecodeFloat(attribute, value)
+#define SCHEMA_DECODE_FLOAT16(attribute, value) schemaDecodeFloat(attribute, value)
+#define SCHEMA_DECODE_FLOAT32(attribute, value) schemaDecodeFloat(attribute, value)
+#define SCHEMA_DECODE_BYTE(attribute, value) schemaDecodeByte(attribute, TYPE_BYTE, value)
+#define SCHEMA_DECODE_RBS(attribute, value) schemaDecodeByte(attribute, TYPE_RBS, value)
+#define SCHEMA_DECODE_STRING(attribute, value) schemaDecodeString(attribute, *(value))
+#define SCHEMA_DECODE_BYTES(attribute, value) schemaDecodeBytes(attribute, value)
+
+// The most bytes a value of the type takes in either format. Text is taken to be UTF-8,
+// which has no flag bytes. Anything else may be escaped all the way.
+#define SCHEMA_MAX_SIZE_INT 11
+#define SCHEMA_MAX_SIZE_VARINT (1 + 2 * MAX_SIZE_VARINT)
+#define SCHEMA_MAX_SIZE_FLOAT MAX_SIZE_ATTRIBUTE_DATA
+#define SCHEMA_MAX_SIZE_FLOAT16 (1 + 2 * 2)
+#define SCHEMA_MAX_SIZE_FLOAT32 (1 + 2 * 4)
+#define SCHEMA_MAX_SIZE_BYTE (1 + 2)
+#define SCHEMA_MAX_SIZE_RBS 2
+#define SCHEMA_MAX_SIZE_STRING MAX_SIZE_ATTRIBUTE_DATA
+#define SCHEMA_MAX_SIZE_BYTES (2 + 2 * MAX_SIZE_ATTRIBUTE_DATA)
+
+// A TLV frame prefix and protocol header, or an escaped header and end flag.
+#define SCHEMA_MAX_SIZE_FRAME_HEADER 8
+// The name and a splitter, or the name, TLV type and length.
+#define SCHEMA_ATTRIBUTE_MAX_SIZE(field, name, type) + (3 + SCHEMA_MAX_SIZE_##type)
+
+#define SCHEMA_ATTRIBUTE_FIELD(field, name, type) SCHEMA_FIELD_##type(field)
+#define SCHEMA_ATTRIBUTE_PRESENT(field, name, type) bool field;
+#define SCHEMA_ATTRIBUTE_PUT(field, name, type) SCHEMA_PUT_##type(writer, name, protocol->field);
+#define SCHEMA_ATTRIBUTE_DECODE(field, name, type) \
+	case name: \
+		if (protocol->present.field) \
+			break; \
+		\
+		result = SCHEMA_DECODE_##type(&attribute, &protocol->field); \
+		protocol->present.field = true; \
+		break;
+
+#define DEFINE_PROTOCOL_SCHEMA(Name, protocolName, SCHEMA) \
+	typedef struct { \
+		SCHEMA(SCHEMA_ATTRIBUTE_FIELD) \
+		struct { \
+			SCHEMA(SCHEMA_ATTRIBUTE_PRESENT) \
+		} present; \
+	} Name##Protocol; \
+	\
+	typedef char Name##ProtocolFitsInAFrame[ \
+		SCHEMA_MAX_SIZE_FRAME_HEADER SCHEMA(SCHEMA_ATTRIBUTE_MAX_SIZE) <= MAX_SIZE_PROTOCOL_DATA ? 1 : -1]; \
+	\
+	static inline int write##Name##Attributes(ProtocolWriter *writer, const Name##Protocol *protocol) { \
+		SCHEMA(SCHEMA_ATTRIBUTE_PUT) \
+		return writer->error; \
+	} \
+	\
+	static inline int encode##Name##Protocol(const Name##Protocol *protocol, uint8_t buff[], int buffSize, \
+			int headroom) { \
+		ProtocolWriter writer; \
+		writerBeginFormatAt(&writer, getProtocolFormat(), protocolName, buff, buffSize, headroom); \
+		write##Name##Attributes(&writer, protocol); \
+		return writerEnd(&writer); \
+	} \
+	\
+	static inline int decode##Name##Protocol(const ProtocolView *view, Name##Protocol *protocol) { \
+		if (!isSchemaProtocol(view, protocolName)) \
+			return TUXP_ERROR_UNKNOWN_PROTOCOL_NAME; \
+		\
+		memset(&protocol->present, 0, sizeof(protocol->present)); \
+		AttributeViewIterator iterator = viewAttributes(view); \
+		AttributeView attribute; \
+		while (viewNextAttribute(&iterator, &attribute)) { \
+			int result = 0; \
+			switch (attribute.name) { \
+			SCHEMA(SCHEMA_ATTRIBUTE_DECODE) \
+			default: \
+				break; \
+			} \
+			\
+			if (result != 0) \
+				return result; \
+		} \
+		\
+		return 0; \
+	}
+
+bool isSchemaProtocol(const ProtocolView *view, ProtocolName name);
+int schemaPutFloat(ProtocolWriter *writer, uint8_t name, float fValue);
+int schemaDecodeInt(const AttributeView *attribute, int32_t *value);
+int schemaDecodeFloat(const AttributeView *attribute, float *value);
+int schemaDecodeByte(const AttributeView *attribute, DataType dataType, uint8_t *value);
+int schemaDecodeString(const AttributeView *attribute, char value[MAX_SIZE_ATTRIBUTE_DATA + 1]);
+int schemaDecodeBytes(const AttributeView *attribute, SchemaBytes *value);
+
+#endif
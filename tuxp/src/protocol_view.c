@@ -0,0 +1,643 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "debug.h"
+#include "tuxp.h"
+#include "protocol_view.h"
+#include "native_values.h"
+#include "series.h"
+#include "flag_scanner.h"
+#include "decimal.h"
+
+static bool isNativeValueStart(const uint8_t data[], int position, int endPosition) {
+	return data[position] == FLAG_ESCAPE && (position + 1) < endPosition && data[position + 1] < 0xfa;
+}
+
+static int findViewValueEnd(const uint8_t data[], int position, int endPosition, int *escapeNumber) {
+	// Skip the type tag of a native value.
+	if (position <= endPosition && isNativeValueStart(data, position, endPosition))
+		position += 2;
+
+	while (position <= endPosition) {
+		position = scanFlagByte(data, position, endPosition + 1);
+		if (position > endPosition)
+			break;
+
+		uint8_t current = data[position];
+		if (current == FLAG_ESCAPE) {
+			if ((position + 1) >= endPosition)
+				return -1;
+
+			if (data[position + 1] < 0xfa)
+				return -1;
+
+			(*escapeNumber)++;
+			position += 2;
+			continue;
+		}
+
+		if (current == FLAG_UNIT_SPLITTER || current == FLAG_DOC_BEGINNING_END)
+			return position;
+
+		position++;
+	}
+
+	return -1;
+}
+
+static int countEscapes(const uint8_t data[], int size) {
+	int escapeNumber = 0;
+	for (int i = scanFlagByte(data, 0, size); i < size - 1; i = scanFlagByte(data, i + 1, size)) {
+		if (data[i] == FLAG_ESCAPE && data[i + 1] >= 0xfa) {
+			escapeNumber++;
+			i++;
+		}
+	}
+
+	return escapeNumber;
+}
+
+int viewProtocol(ProtocolData *pData, ProtocolView *view) {
+	if (pData->dataSize >= SIZE_TLV_FRAME_PREFIX && pData->data[0] == FLAG_DOC_BEGINNING_END &&
+			pData->data[1] == FLAG_TLV_FRAME) {
+		if (pData->dataSize != SIZE_TLV_FRAME_PREFIX + pData->data[2])
+			return TUXP_ERROR_NOT_VALID_PROTOCOL;
+
+		return viewTlvProtocolBody(pData->data, SIZE_TLV_FRAME_PREFIX, pData->dataSize, view);
+	}
+
+	if (pData->dataSize < 5 || pData->data[0] != FLAG_DOC_BEGINNING_END ||
+			pData->data[pData->dataSize - 1] != FLAG_DOC_BEGINNING_END)
+		return TUXP_ERROR_NOT_VALID_PROTOCOL;
+
+	return viewProtocolBody(pData->data, 1, pData->dataSize - 1, view);
+}
+
+static bool isTerminator(uint8_t b) {
+	return b == FLAG_UNIT_SPLITTER || b == FLAG_DOC_BEGINNING_END;
+}
+
+static void initView(const uint8_t data[], int startPosition, ProtocolFormat format, ProtocolView *view) {
+	view->format = format;
+	view->data = data;
+	view->attributesSize = 0;
+	view->attributesPosition = startPosition + 5;
+	view->childrenSize = 0;
+	view->childPosition = -1;
+	view->textPosition = -1;
+	view->textSize = 0;
+}
+
+// An escaped body finds its own end. The last unit of a protocol, being its last attribute,
+// its text or its last child, ends with a unit splitter when a sibling follows, or with the
+// end flag of the frame. So the end of a protocol is shared by its last child.
+static int viewEscapedBody(const uint8_t data[], int startPosition, int limitPosition, int depth,
+			ProtocolView *view) {
+	initView(data, startPosition, PROTOCOL_FORMAT_ESCAPED, view);
+
+	if (limitPosition - startPosition < 3)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	view->name.ns[0] = data[startPosition];
+	view->name.ns[1] = data[startPosition + 1];
+	view->name.localName = data[startPosition + 2];
+
+	// Is a bare protocol.
+	if (isTerminator(data[startPosition + 3])) {
+		view->dataSize = startPosition + 4;
+		return 0;
+	}
+
+	if (limitPosition - startPosition < 5)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	uint8_t attributesSize = data[startPosition + 3];
+	uint8_t childrenSize = data[startPosition + 4] & 0x7f;
+	bool hasText = ((data[startPosition + 4] & 0x80) == 0x80);
+
+	if (childrenSize > 0 && hasText)
+		return TUXP_ERROR_FEATURE_CHILD_ELEMENT_NOT_IMPLEMENTED;
+
+	if (attributesSize == 0 && childrenSize == 0 && !hasText) {
+		if (!isTerminator(data[startPosition + 5]))
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		view->dataSize = startPosition + 6;
+		return 0;
+	}
+
+	int position = startPosition + 4;
+	for (int i = 0; i < attributesSize; i++) {
+		if (++position >= limitPosition)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		position++;
+		int escapeNumber = 0;
+		int valueEndPosition = findViewValueEnd(data, position, limitPosition, &escapeNumber);
+		if (valueEndPosition <= position)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		if (data[position] == FLAG_BYTE_TYPE &&
+				(escapeNumber > 1 || valueEndPosition - position < 2))
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		if (isNativeValueStart(data, position, limitPosition)) {
+			AttributeView attribute;
+			ProtocolAttributeValue value;
+			if (!getNativeType(data[position + 1], &attribute.dataType))
+				return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+			attribute.data = data + position + 2;
+			attribute.dataSize = valueEndPosition - position - 2;
+			attribute.escapeNumber = escapeNumber;
+			if (isSeriesType(attribute.dataType)) {
+				SeriesDecoder decoder;
+				uint8_t buff[MAX_SIZE_SERIES_DATA];
+				if (viewDecodeSeries(&attribute, buff, sizeof(buff), &decoder) != 0 ||
+						countSeriesValues(decoder.dataType, decoder.data, decoder.size) < 0)
+					return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+			} else if (viewDecodeNativeValue(&attribute, &value) != 0) {
+				return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+			}
+		}
+
+		position = valueEndPosition;
+		if (i < attributesSize - 1 && data[position] != FLAG_UNIT_SPLITTER)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+	}
+	view->attributesSize = attributesSize;
+
+	if (!hasText && childrenSize == 0) {
+		view->dataSize = position + 1;
+		return 0;
+	}
+
+	if (attributesSize != 0 && data[position] != FLAG_UNIT_SPLITTER)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	position++;
+	if (position > limitPosition)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	if (childrenSize > 0) {
+		if (depth >= MAX_DEPTH_CHILDREN)
+			return TUXP_ERROR_TOO_MANY_CHILDREN;
+
+		view->childrenSize = childrenSize;
+		view->childPosition = position;
+		for (int i = 0; i < childrenSize; i++) {
+			ProtocolView child;
+			int result = viewEscapedBody(data, position, limitPosition, depth + 1, &child);
+			if (result != 0)
+				return result;
+
+			position = child.dataSize;
+			if (i < childrenSize - 1 && data[position - 1] != FLAG_UNIT_SPLITTER)
+				return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+		}
+
+		view->dataSize = position;
+		return 0;
+	}
+
+	int escapeNumber = 0;
+	int textEndPosition = findViewValueEnd(data, position, limitPosition, &escapeNumber);
+	if (textEndPosition < 0)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	if (textEndPosition - position - escapeNumber > MAX_SIZE_TEXT_DATA)
+		return TUXP_ERROR_TEXT_DATA_TOO_LARGE;
+
+	view->textPosition = position;
+	view->textSize = textEndPosition - position;
+	view->dataSize = textEndPosition + 1;
+
+	return 0;
+}
+
+int viewProtocolBody(const uint8_t data[], int startPosition, int endPosition, ProtocolView *view) {
+	int result = viewEscapedBody(data, startPosition, endPosition, 0, view);
+	if (result != 0)
+		return result;
+
+	return view->dataSize == endPosition + 1 ? 0 : TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+}
+
+static bool isValidTlvValue(DataType dataType, const uint8_t data[], int size) {
+	if (dataType == TYPE_BYTE || dataType == TYPE_RBS)
+		return size == 1;
+
+	if (dataType == TYPE_BYTES || dataType == TYPE_CHARS)
+		return size <= MAX_SIZE_ATTRIBUTE_DATA;
+
+	if (isSeriesType(dataType))
+		return size <= MAX_SIZE_SERIES_DATA && countSeriesValues(dataType, data, size) >= 0;
+
+	ProtocolAttributeValue value;
+	return isNativeType(dataType) && decodeNativeValue(dataType, data, size, &value) == 0;
+}
+
+static int viewTlvBody(const uint8_t data[], int startPosition, int endPosition, int depth,
+			ProtocolView *view) {
+	initView(data, startPosition, PROTOCOL_FORMAT_TLV, view);
+	view->dataSize = endPosition;
+
+	if (endPosition - startPosition < 5)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	view->name.ns[0] = data[startPosition];
+	view->name.ns[1] = data[startPosition + 1];
+	view->name.localName = data[startPosition + 2];
+
+	uint8_t attributesSize = data[startPosition + 3];
+	uint8_t childrenSize = data[startPosition + 4] & 0x7f;
+	bool hasText = ((data[startPosition + 4] & 0x80) == 0x80);
+
+	if (childrenSize > 0 && hasText)
+		return TUXP_ERROR_FEATURE_CHILD_ELEMENT_NOT_IMPLEMENTED;
+
+	int position = startPosition + 5;
+	for (int i = 0; i < attributesSize; i++) {
+		if (endPosition - position < 3)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		uint8_t size = data[position + 2];
+		if (endPosition - position - 3 < size ||
+				!isValidTlvValue(data[position + 1], data + position + 3, size))
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+		position += 3 + size;
+	}
+	view->attributesSize = attributesSize;
+
+	// Every child is prefixed with its length.
+	if (childrenSize > 0) {
+		if (depth >= MAX_DEPTH_CHILDREN)
+			return TUXP_ERROR_TOO_MANY_CHILDREN;
+
+		view->childrenSize = childrenSize;
+		view->childPosition = position;
+		for (int i = 0; i < childrenSize; i++) {
+			if (endPosition - position < 1 || endPosition - position - 1 < data[position])
+				return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+			ProtocolView child;
+			int result = viewTlvBody(data, position + 1, position + 1 + data[position], depth + 1, &child);
+			if (result != 0)
+				return result;
+
+			position = child.dataSize;
+		}
+
+		return position == endPosition ? 0 : TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+	}
+
+	if (!hasText)
+		return position == endPosition ? 0 : TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	if (endPosition - position > MAX_SIZE_TEXT_DATA)
+		return TUXP_ERROR_TEXT_DATA_TOO_LARGE;
+
+	view->textPosition = position;
+	view->textSize = endPosition - position;
+
+	return 0;
+}
+
+// The end position of a TLV body is the first position after it.
+int viewTlvProtocolBody(const uint8_t data[], int startPosition, int endPosition, ProtocolView *view) {
+	return viewTlvBody(data, startPosition, endPosition, 0, view);
+}
+
+ChildViewIterator viewChildren(const ProtocolView *view) {
+	ChildViewIterator iterator = {view, 0, view->childPosition};
+	return iterator;
+}
+
+bool viewNextChild(ChildViewIterator *iterator, ProtocolView *child) {
+	const ProtocolView *view = iterator->view;
+	if (iterator->index >= view->childrenSize)
+		return false;
+
+	int result;
+	if (view->format == PROTOCOL_FORMAT_TLV) {
+		int position = iterator->position;
+		result = viewTlvBody(view->data, position + 1, position + 1 + view->data[position], 0, child);
+	} else {
+		result = viewEscapedBody(view->data, iterator->position, view->dataSize - 1, 0, child);
+	}
+
+	if (result != 0)
+		return false;
+
+	iterator->position = child->dataSize;
+	iterator->index++;
+
+	return true;
+}
+
+int viewChild(const ProtocolView *view, ProtocolView *child) {
+	ChildViewIterator iterator = viewChildren(view);
+	if (!viewNextChild(&iterator, child))
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	return 0;
+}
+
+static void assembleAttributeView(const uint8_t raw[], int rawSize, int escapeNumber,
+			AttributeView *attribute) {
+	attribute->escapeNumber = escapeNumber;
+
+	if (rawSize >= 2 && raw[0] == FLAG_ESCAPE && raw[1] < 0xfa) {
+		getNativeType(raw[1], &attribute->dataType);
+		attribute->data = raw + 2;
+		attribute->dataSize = rawSize - 2;
+	} else if (raw[0] == FLAG_BYTE_TYPE) {
+		attribute->dataType = TYPE_BYTE;
+		attribute->data = raw + 1;
+		attribute->dataSize = rawSize - 1;
+	} else if (raw[0] == FLAG_BYTES_TYPE) {
+		attribute->dataType = TYPE_BYTES;
+		attribute->data = raw + 1;
+		attribute->dataSize = rawSize - 1;
+	} else if (raw[0] == FLAG_NOREPLACE && rawSize - escapeNumber == 2) {
+		attribute->dataType = TYPE_CHARS;
+		attribute->data = raw + 1;
+		attribute->dataSize = rawSize - 1;
+	} else if (rawSize - escapeNumber == 1) {
+		attribute->dataType = TYPE_RBS;
+		attribute->data = raw;
+		attribute->dataSize = rawSize;
+	} else {
+		attribute->dataType = TYPE_CHARS;
+		attribute->data = raw;
+		attribute->dataSize = rawSize;
+	}
+}
+
+AttributeViewIterator viewAttributes(const ProtocolView *view) {
+	AttributeViewIterator iterator = {view, 0, view->attributesPosition};
+	return iterator;
+}
+
+bool viewNextAttribute(AttributeViewIterator *iterator, AttributeView *attribute) {
+	if (iterator->index >= iterator->view->attributesSize)
+		return false;
+
+	const uint8_t *data = iterator->view->data;
+	int position = iterator->position;
+
+	attribute->name = data[position];
+	position++;
+
+	if (iterator->view->format == PROTOCOL_FORMAT_TLV) {
+		attribute->dataType = data[position];
+		attribute->dataSize = data[position + 1];
+		attribute->data = data + position + 2;
+		attribute->escapeNumber = 0;
+
+		iterator->position = position + 2 + attribute->dataSize;
+		iterator->index++;
+
+		return true;
+	}
+
+	int escapeNumber = 0;
+	int valueEndPosition = findViewValueEnd(data, position, iterator->view->dataSize - 1, &escapeNumber);
+	assembleAttributeView(data + position, valueEndPosition - position, escapeNumber, attribute);
+
+	iterator->position = valueEndPosition + 1;
+	iterator->index++;
+
+	return true;
+}
+
+bool viewGetAttribute(const ProtocolView *view, uint8_t name, AttributeView *attribute) {
+	AttributeViewIterator iterator = viewAttributes(view);
+	while (viewNextAttribute(&iterator, attribute)) {
+		if (attribute->name == name)
+			return true;
+	}
+
+	return false;
+}
+
+// Copies the runs between flag bytes at once. An escape flag in front of a flag byte is
+// dropped and the escaped byte is taken as it is, even if it's an escape flag itself.
+int viewUnescape(const uint8_t data[], int size, uint8_t buff[], int buffSize) {
+	int position = 0;
+	int i = 0;
+	while (i < size) {
+		int flagPosition = scanFlagByte(data, i, size);
+		int runSize = flagPosition - i;
+		if (position + runSize + (flagPosition < size ? 1 : 0) > buffSize)
+			return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+		memcpy(buff + position, data + i, runSize);
+		position += runSize;
+
+		if (flagPosition >= size)
+			break;
+
+		if (data[flagPosition] == FLAG_ESCAPE && flagPosition < (size - 1) && data[flagPosition + 1] >= 0xfa)
+			flagPosition++;
+
+		buff[position] = data[flagPosition];
+		position++;
+		i = flagPosition + 1;
+	}
+
+	return position;
+}
+
+static int borrowOrUnescape(const uint8_t data[], int size, int escapeNumber,
+			uint8_t buff[], int buffSize, const uint8_t **value) {
+	if (escapeNumber == 0) {
+		*value = data;
+		return size;
+	}
+
+	*value = buff;
+	return viewUnescape(data, size, buff, buffSize);
+}
+
+int viewCopyValue(const AttributeView *attribute, uint8_t buff[], int buffSize) {
+	if (attribute->escapeNumber != 0)
+		return viewUnescape(attribute->data, attribute->dataSize, buff, buffSize);
+
+	if (attribute->dataSize > buffSize)
+		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+	memcpy(buff, attribute->data, attribute->dataSize);
+	return attribute->dataSize;
+}
+
+int viewDecodeNativeValue(const AttributeView *attribute, ProtocolAttributeValue *value) {
+	uint8_t buff[MAX_SIZE_NATIVE_VALUE];
+	const uint8_t *raw;
+	int size = borrowOrUnescape(attribute->data, attribute->dataSize, attribute->escapeNumber,
+		buff, MAX_SIZE_NATIVE_VALUE, &raw);
+	if (size < 0)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+
+	return decodeNativeValue(attribute->dataType, raw, size, value);
+}
+
+// The decoder borrows the series from the frame, or from buff when it has to be unescaped.
+int viewDecodeSeries(const AttributeView *attribute, uint8_t buff[], int buffSize, SeriesDecoder *decoder) {
+	if (!isSeriesType(attribute->dataType))
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+
+	const uint8_t *series;
+	int size = borrowOrUnescape(attribute->data, attribute->dataSize, attribute->escapeNumber,
+		buff, buffSize, &series);
+	if (size < 0)
+		return size;
+
+	seriesBeginDecoding(decoder, attribute->dataType, series, size);
+	return 0;
+}
+
+static int viewGetTypedAttribute(const ProtocolView *view, uint8_t name, DataType dataType,
+			AttributeView *attribute) {
+	if (!viewGetAttribute(view, name, attribute))
+		return TUXP_ERROR_NO_SUCH_ATTRIBUTE;
+
+	if (attribute->dataType != dataType)
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+
+	return 0;
+}
+
+int viewGetBytes(const ProtocolView *view, uint8_t name, uint8_t buff[], int buffSize, const uint8_t **bytes) {
+	AttributeView attribute;
+	int result = viewGetTypedAttribute(view, name, TYPE_BYTES, &attribute);
+	if (result != 0)
+		return result;
+
+	return borrowOrUnescape(attribute.data, attribute.dataSize, attribute.escapeNumber,
+		buff, buffSize, bytes);
+}
+
+int viewGetString(const ProtocolView *view, uint8_t name, char buff[], int buffSize, const char **string) {
+	AttributeView attribute;
+	int result = viewGetTypedAttribute(view, name, TYPE_CHARS, &attribute);
+	if (result != 0)
+		return result;
+
+	return borrowOrUnescape(attribute.data, attribute.dataSize, attribute.escapeNumber,
+		(uint8_t *)buff, buffSize, (const uint8_t **)string);
+}
+
+int viewGetSeries(const ProtocolView *view, uint8_t name, uint8_t buff[], int buffSize,
+			SeriesDecoder *decoder) {
+	AttributeView attribute;
+	if (!viewGetAttribute(view, name, &attribute))
+		return TUXP_ERROR_NO_SUCH_ATTRIBUTE;
+
+	return viewDecodeSeries(&attribute, buff, buffSize, decoder);
+}
+
+int viewGetText(const ProtocolView *view, char buff[], int buffSize, const char **text) {
+	if (view->textPosition < 0) {
+		*text = NULL;
+		return 0;
+	}
+
+	const uint8_t *textData = view->data + view->textPosition;
+	int escapeNumber = view->format == PROTOCOL_FORMAT_TLV ? 0 : countEscapes(textData, view->textSize);
+	return borrowOrUnescape(textData, view->textSize, escapeNumber,
+		(uint8_t *)buff, buffSize, (const uint8_t **)text);
+}
+
+static bool viewGetSingleByte(const ProtocolView *view, uint8_t name, DataType dataType, uint8_t *value) {
+	AttributeView attribute;
+	if (viewGetTypedAttribute(view, name, dataType, &attribute) != 0)
+		return false;
+
+	*value = attribute.escapeNumber == 0 ? attribute.data[0] : attribute.data[1];
+	return true;
+}
+
+bool viewGetByte(const ProtocolView *view, uint8_t name, uint8_t *value) {
+	return viewGetSingleByte(view, name, TYPE_BYTE, value);
+}
+
+bool viewGetRbs(const ProtocolView *view, uint8_t name, uint8_t *value) {
+	return viewGetSingleByte(view, name, TYPE_RBS, value);
+}
+
+static bool viewGetNumberChars(const AttributeView *attribute, char chars[]) {
+	if (attribute->dataType != TYPE_CHARS)
+		return false;
+
+	const uint8_t *string;
+	int size = borrowOrUnescape(attribute->data, attribute->dataSize, attribute->escapeNumber,
+		(uint8_t *)chars, MAX_SIZE_ATTRIBUTE_DATA, &string);
+	if (size < 0 || size > MAX_SIZE_ATTRIBUTE_DATA)
+		return false;
+
+	if (string != (const uint8_t *)chars)
+		memcpy(chars, string, size);
+	chars[size] = '\0';
+
+	return true;
+}
+
+bool viewGetInt(const ProtocolView *view, uint8_t name, int *value) {
+	AttributeView attribute;
+	if (!viewGetAttribute(view, name, &attribute))
+		return false;
+
+	if (attribute.dataType == TYPE_VARINT) {
+		ProtocolAttributeValue nativeValue;
+		if (viewDecodeNativeValue(&attribute, &nativeValue) != 0)
+			return false;
+
+		*value = nativeValue.iValue;
+		return true;
+	}
+
+	char chars[MAX_SIZE_ATTRIBUTE_DATA + 1];
+	if (!viewGetNumberChars(&attribute, chars))
+		return false;
+
+	*value = parseDecimalInt(chars);
+	return true;
+}
+
+bool viewGetFloat(const ProtocolView *view, uint8_t name, float *value) {
+	AttributeView attribute;
+	if (!viewGetAttribute(view, name, &attribute))
+		return false;
+
+	if (attribute.dataType == TYPE_VARINT || attribute.dataType == TYPE_FLOAT16 ||
+			attribute.dataType == TYPE_FLOAT32) {
+		ProtocolAttributeValue nativeValue;
+		if (viewDecodeNativeValue(&attribute, &nativeValue) != 0)
+			return false;
+
+		*value = attribute.dataType == TYPE_VARINT ? nativeValue.iValue : nativeValue.fValue;
+		return true;
+	}
+
+	char chars[MAX_SIZE_ATTRIBUTE_DATA + 1];
+	if (!viewGetNumberChars(&attribute, chars))
+		return false;
+
+	*value = parseDecimalFloat(chars);
+	return true;
+}
+
+bool viewGetBool(const ProtocolView *view, uint8_t name, int index, bool *value) {
+	AttributeView attribute;
+	if (viewGetTypedAttribute(view, name, TYPE_BOOLS, &attribute) != 0)
+		return false;
+
+	ProtocolAttributeValue nativeValue;
+	if (index < 0 || index >= MAX_SIZE_BOOLS || viewDecodeNativeValue(&attribute, &nativeValue) != 0)
+		return false;
+
+	*value = (nativeValue.boolsValue >> index) & 1;
+	return true;
+}
@@ -0,0 +1,68 @@
+#ifndef MUD_PROTOCOL_VIEW_H
+#define MUD_PROTOCOL_VIEW_H
+
+#include "protocols.h"
+#include "series.h"
+
+typedef struct {
+	ProtocolName name;
+	ProtocolFormat format;
+	const uint8_t *data;
+	int dataSize;
+	uint8_t attributesSize;
+	int attributesPosition;
+	uint8_t childrenSize;
+	int childPosition;
+	int textPosition;
+	int textSize;
+} ProtocolView;
+
+typedef struct {
+	uint8_t name;
+	DataType dataType;
+	const uint8_t *data;
+	int dataSize;
+	int escapeNumber;
+} AttributeView;
+
+typedef struct {
+	const ProtocolView *view;
+	uint8_t index;
+	int position;
+} AttributeViewIterator;
+
+typedef struct {
+	const ProtocolView *view;
+	uint8_t index;
+	int position;
+} ChildViewIterator;
+
+int viewProtocol(ProtocolData *pData, ProtocolView *view);
+int viewProtocolBody(const uint8_t data[], int startPosition, int endPosition, ProtocolView *view);
+int viewTlvProtocolBody(const uint8_t data[], int startPosition, int endPosition, ProtocolView *view);
+int viewChild(const ProtocolView *view, ProtocolView *child);
+ChildViewIterator viewChildren(const ProtocolView *view);
+bool viewNextChild(ChildViewIterator *iterator, ProtocolView *child);
+
+AttributeViewIterator viewAttributes(const ProtocolView *view);
+bool viewNextAttribute(AttributeViewIterator *iterator, AttributeView *attribute);
+bool viewGetAttribute(const ProtocolView *view, uint8_t name, AttributeView *attribute);
+int viewUnescape(const uint8_t data[], int size, uint8_t buff[], int buffSize);
+int viewCopyValue(const AttributeView *attribute, uint8_t buff[], int buffSize);
+int viewDecodeNativeValue(const AttributeView *attribute, ProtocolAttributeValue *value);
+int viewDecodeSeries(const AttributeView *attribute, uint8_t buff[], int buffSize, SeriesDecoder *decoder);
+
+// Values are borrowed from the frame when they need no unescaping, otherwise they
+// are unescaped into buff. Strings and text aren't NUL terminated, use the returned size.
+int viewGetBytes(const ProtocolView *view, uint8_t name, uint8_t buff[], int buffSize, const uint8_t **bytes);
+int viewGetString(const ProtocolView *view, uint8_t name, char buff[], int buffSize, const char **string);
+int viewGetSeries(const ProtocolView *view, uint8_t name, uint8_t buff[], int buffSize,
+	SeriesDecoder *decoder);
+int viewGetText(const ProtocolView *view, char buff[], int buffSize, const char **text);
+bool viewGetByte(const ProtocolView *view, uint8_t name, uint8_t *value);
+bool viewGetRbs(const ProtocolView *view, uint8_t name, uint8_t *value);
+bool viewGetInt(const ProtocolView *view, uint8_t name, int *value);
+bool viewGetFloat(const ProtocolView *view, uint8_t name, float *value);
+bool viewGetBool(const ProtocolView *view, uint8_t name, int index, bool *value);
+
+#endif
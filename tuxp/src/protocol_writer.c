@@ -0,0 +1,575 @@
+#include <string.h>
+
+#include "debug.h"
+#include "tuxp.h"
+#include "protocol_writer.h"
+#include "native_values.h"
+#include "series.h"
+#include "flag_scanner.h"
+#include "decimal.h"
+
+#define SIZE_PROTOCOL_NAME_HEADER 4
+#define SIZE_PROTOCOL_HEADER 6
+#define SIZE_TLV_ATTRIBUTE_HEADER 3
+
+static bool isFlagByte(uint8_t b) {
+	return b == FLAG_DOC_BEGINNING_END ||
+		b == FLAG_UNIT_SPLITTER ||
+		b == FLAG_ESCAPE ||
+		b == FLAG_BYTES_TYPE ||
+		b == FLAG_BYTE_TYPE;
+}
+
+static bool isEscapedSingleByte(uint8_t b) {
+	return b >= 0xfa;
+}
+
+static int escapedSize(const uint8_t data[], int size) {
+	int escapedSize = size;
+	for (int i = scanFlagByte(data, 0, size); i < size; i = scanFlagByte(data, i + 1, size)) {
+		if (isFlagByte(data[i]))
+			escapedSize++;
+	}
+
+	return escapedSize;
+}
+
+static int escapedValueSize(const uint8_t data[], int size) {
+	int valueSize = escapedSize(data, size);
+
+	// A single byte value must be marked to not be taken as a RBS value.
+	return valueSize == 1 ? 2 : valueSize;
+}
+
+static int singleByteSize(uint8_t b) {
+	return isEscapedSingleByte(b) ? 2 : 1;
+}
+
+static bool writerFails(ProtocolWriter *writer, int error) {
+	writer->error = error;
+	return false;
+}
+
+static bool writerEnsure(ProtocolWriter *writer, int size) {
+	if (writer->position + size > writer->buffSize)
+		return writerFails(writer, TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
+
+	return true;
+}
+
+static bool writerOpenBody(ProtocolWriter *writer) {
+	if (writer->position != writer->headerPosition + SIZE_PROTOCOL_NAME_HEADER)
+		return true;
+
+	if (!writerEnsure(writer, SIZE_PROTOCOL_HEADER - SIZE_PROTOCOL_NAME_HEADER))
+		return false;
+
+	writer->buff[writer->position] = 0x00;
+	writer->buff[writer->position + 1] = 0x00;
+	writer->position += SIZE_PROTOCOL_HEADER - SIZE_PROTOCOL_NAME_HEADER;
+
+	return true;
+}
+
+static bool writerBeginAttribute(ProtocolWriter *writer, uint8_t name, int encodedValueSize) {
+	if (writer->error != 0)
+		return false;
+
+	if (writer->hasText || writer->childrenSize > 0)
+		return writerFails(writer, TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
+
+	if (!writerOpenBody(writer))
+		return false;
+
+	if (writer->attributesSize >= MAX_SIZE_ATTRIBUTES)
+		return writerFails(writer, TUXP_ERROR_TOO_MANY_ATTRIBUTES);
+
+	// TLV attributes need no unit splitter.
+	int splitterSize = writer->format == PROTOCOL_FORMAT_TLV ? 0 : 1;
+	if (!writerEnsure(writer, 1 + encodedValueSize + splitterSize))
+		return false;
+
+	writer->buff[writer->position] = name;
+	writer->position++;
+
+	return true;
+}
+
+static void writerEndAttribute(ProtocolWriter *writer) {
+	if (writer->format == PROTOCOL_FORMAT_ESCAPED) {
+		writer->buff[writer->position] = FLAG_UNIT_SPLITTER;
+		writer->position++;
+	}
+
+	writer->attributesSize++;
+	writer->buff[writer->headerPosition + 4] = writer->attributesSize;
+}
+
+static void writeEscaped(ProtocolWriter *writer, const uint8_t data[], int size) {
+	int i = 0;
+	while (i < size) {
+		int flagPosition = scanFlagByte(data, i, size);
+		memcpy(writer->buff + writer->position, data + i, flagPosition - i);
+		writer->position += flagPosition - i;
+
+		if (flagPosition >= size)
+			break;
+
+		if (isFlagByte(data[flagPosition])) {
+			writer->buff[writer->position] = FLAG_ESCAPE;
+			writer->position++;
+		}
+
+		writer->buff[writer->position] = data[flagPosition];
+		writer->position++;
+		i = flagPosition + 1;
+	}
+}
+
+static void writeEscapedValue(ProtocolWriter *writer, const uint8_t data[], int size) {
+	if (size == 1 && !isFlagByte(data[0])) {
+		writer->buff[writer->position] = FLAG_NOREPLACE;
+		writer->position++;
+	}
+
+	writeEscaped(writer, data, size);
+}
+
+static void writeSingleByte(ProtocolWriter *writer, uint8_t b) {
+	if (isEscapedSingleByte(b)) {
+		writer->buff[writer->position] = FLAG_ESCAPE;
+		writer->position++;
+	}
+
+	writer->buff[writer->position] = b;
+	writer->position++;
+}
+
+static void writerReset(ProtocolWriter *writer, ProtocolFormat format, uint8_t buff[], int buffSize,
+			int headerPosition) {
+	writer->buff = buff;
+	writer->buffSize = buffSize;
+	writer->position = headerPosition;
+	writer->headerPosition = headerPosition;
+	writer->attributesSize = 0;
+	writer->childrenSize = 0;
+	writer->hasText = false;
+	writer->format = format;
+	writer->error = 0;
+}
+
+static void writeName(ProtocolWriter *writer, ProtocolName name) {
+	if (name.ns[0] >= MIN_FLAG_BYTE)
+		writerFails(writer, TUXP_ERROR_RESERVED_PROTOCOL_NAME);
+
+	writer->buff[writer->headerPosition + 1] = name.ns[0];
+	writer->buff[writer->headerPosition + 2] = name.ns[1];
+	writer->buff[writer->headerPosition + 3] = name.localName;
+	writer->position = writer->headerPosition + SIZE_PROTOCOL_NAME_HEADER;
+}
+
+void writerBegin(ProtocolWriter *writer, ProtocolName name, uint8_t buff[], int buffSize) {
+	writerBeginAt(writer, name, buff, buffSize, 0);
+}
+
+void writerBeginAt(ProtocolWriter *writer, ProtocolName name, uint8_t buff[], int buffSize, int position) {
+	writerBeginFormatAt(writer, PROTOCOL_FORMAT_ESCAPED, name, buff, buffSize, position);
+}
+
+// TLV headers always carry the attributes size and flags, so that the body can be walked
+// without looking at the frame length.
+static void writeTlvHeader(ProtocolWriter *writer, ProtocolName name) {
+	writeName(writer, name);
+	writer->buff[writer->headerPosition + 4] = 0x00;
+	writer->buff[writer->headerPosition + 5] = 0x00;
+	writer->position = writer->headerPosition + SIZE_PROTOCOL_HEADER;
+}
+
+void writerBeginFormatAt(ProtocolWriter *writer, ProtocolFormat format, ProtocolName name,
+			uint8_t buff[], int buffSize, int position) {
+	if (format == PROTOCOL_FORMAT_TLV) {
+		// The header follows the beginning flag, the TLV flag and the length of the frame.
+		writerReset(writer, format, buff, buffSize, position + SIZE_TLV_FRAME_PREFIX - 1);
+		if (!writerEnsure(writer, SIZE_PROTOCOL_HEADER))
+			return;
+
+		buff[position] = FLAG_DOC_BEGINNING_END;
+		buff[position + 1] = FLAG_TLV_FRAME;
+		writeTlvHeader(writer, name);
+
+		return;
+	}
+
+	writerReset(writer, format, buff, buffSize, position);
+
+	// Leave room for the end flag of a bare protocol.
+	if (!writerEnsure(writer, SIZE_PROTOCOL_NAME_HEADER + 1))
+		return;
+
+	buff[position] = FLAG_DOC_BEGINNING_END;
+	writeName(writer, name);
+}
+
+// An embedded protocol has no beginning flag. Its header sits right after the unit splitter
+// of the enclosing protocol, and its end flag closes the enclosing protocol too. An embedded
+// TLV protocol is prefixed with its length instead.
+static void writerBeginEmbedded(ProtocolWriter *writer, ProtocolFormat format, ProtocolName name,
+			uint8_t buff[], int buffSize, int position) {
+	if (format == PROTOCOL_FORMAT_TLV) {
+		writerReset(writer, format, buff, buffSize, position);
+		if (writerEnsure(writer, SIZE_PROTOCOL_HEADER))
+			writeTlvHeader(writer, name);
+
+		return;
+	}
+
+	writerReset(writer, format, buff, buffSize, position - 1);
+
+	if (!writerEnsure(writer, SIZE_PROTOCOL_NAME_HEADER + 1))
+		return;
+
+	writeName(writer, name);
+}
+
+static int writerPutTlv(ProtocolWriter *writer, uint8_t name, DataType dataType, const uint8_t raw[], int size) {
+	if (!writerBeginAttribute(writer, name, SIZE_TLV_ATTRIBUTE_HEADER - 1 + size))
+		return writer->error;
+
+	writer->buff[writer->position] = dataType;
+	writer->buff[writer->position + 1] = size;
+	memcpy(writer->buff + writer->position + 2, raw, size);
+	writer->position += SIZE_TLV_ATTRIBUTE_HEADER - 1 + size;
+
+	writerEndAttribute(writer);
+	return 0;
+}
+
+int writerPutByte(ProtocolWriter *writer, uint8_t name, uint8_t bValue) {
+	if (writer->format == PROTOCOL_FORMAT_TLV)
+		return writerPutTlv(writer, name, TYPE_BYTE, &bValue, 1);
+
+	if (!writerBeginAttribute(writer, name, 1 + singleByteSize(bValue)))
+		return writer->error;
+
+	writer->buff[writer->position] = FLAG_BYTE_TYPE;
+	writer->position++;
+	writeSingleByte(writer, bValue);
+
+	writerEndAttribute(writer);
+	return 0;
+}
+
+int writerPutBytes(ProtocolWriter *writer, uint8_t name, const uint8_t bytes[], int size) {
+	if (writer->error == 0 && size > MAX_SIZE_ATTRIBUTE_DATA)
+		writerFails(writer, TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
+
+	if (writer->format == PROTOCOL_FORMAT_TLV)
+		return writerPutTlv(writer, name, TYPE_BYTES, bytes, size);
+
+	if (!writerBeginAttribute(writer, name, 1 + escapedValueSize(bytes, size)))
+		return writer->error;
+
+	writer->buff[writer->position] = FLAG_BYTES_TYPE;
+	writer->position++;
+	writeEscapedValue(writer, bytes, size);
+
+	writerEndAttribute(writer);
+	return 0;
+}
+
+int writerPutString(ProtocolWriter *writer, uint8_t name, const char string[]) {
+	int size = strlen(string);
+	if (writer->error == 0 && size > MAX_SIZE_ATTRIBUTE_DATA)
+		writerFails(writer, TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
+
+	if (writer->format == PROTOCOL_FORMAT_TLV)
+		return writerPutTlv(writer, name, TYPE_CHARS, (const uint8_t *)string, size);
+
+	if (!writerBeginAttribute(writer, name, escapedValueSize((const uint8_t *)string, size)))
+		return writer->error;
+
+	writeEscapedValue(writer, (const uint8_t *)string, size);
+
+	writerEndAttribute(writer);
+	return 0;
+}
+
+int writerPutInt(ProtocolWriter *writer, uint8_t name, int iValue) {
+	char charsData[MAX_SIZE_DECIMAL_INT];
+	formatDecimalInt(iValue, charsData, sizeof(charsData));
+
+	return writerPutString(writer, name, charsData);
+}
+
+int writerPutRbs(ProtocolWriter *writer, uint8_t name, uint8_t rbsValue) {
+	if (writer->format == PROTOCOL_FORMAT_TLV)
+		return writerPutTlv(writer, name, TYPE_RBS, &rbsValue, 1);
+
+	if (!writerBeginAttribute(writer, name, singleByteSize(rbsValue)))
+		return writer->error;
+
+	writeSingleByte(writer, rbsValue);
+
+	writerEndAttribute(writer);
+	return 0;
+}
+
+static int writerPutTagged(ProtocolWriter *writer, uint8_t name, DataType dataType,
+			const uint8_t raw[], int size) {
+	if (writer->format == PROTOCOL_FORMAT_TLV)
+		return writerPutTlv(writer, name, dataType, raw, size);
+
+	if (!writerBeginAttribute(writer, name, 2 + escapedSize(raw, size)))
+		return writer->error;
+
+	writer->buff[writer->position] = FLAG_ESCAPE;
+	writer->buff[writer->position + 1] = getNativeTypeTag(dataType);
+	writer->position += 2;
+	writeEscaped(writer, raw, size);
+
+	writerEndAttribute(writer);
+	return 0;
+}
+
+static int writerPutNative(ProtocolWriter *writer, uint8_t name, DataType dataType,
+			ProtocolAttributeValue value) {
+	uint8_t raw[MAX_SIZE_NATIVE_VALUE];
+	int size = encodeNativeValue(dataType, value, raw);
+
+	return writerPutTagged(writer, name, dataType, raw, size);
+}
+
+int writerPutSeries(ProtocolWriter *writer, uint8_t name, DataType dataType, const uint8_t series[], int size) {
+	if (writer->error == 0 && !isSeriesType(dataType))
+		writerFails(writer, TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH);
+
+	if (writer->error == 0 && size > MAX_SIZE_SERIES_DATA)
+		writerFails(writer, TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
+
+	return writerPutTagged(writer, name, dataType, series, size);
+}
+
+int writerPutVarint(ProtocolWriter *writer, uint8_t name, int32_t iValue) {
+	ProtocolAttributeValue value;
+	value.iValue = iValue;
+
+	return writerPutNative(writer, name, TYPE_VARINT, value);
+}
+
+int writerPutFloat16(ProtocolWriter *writer, uint8_t name, float fValue) {
+	ProtocolAttributeValue value;
+	value.fValue = fValue;
+
+	return writerPutNative(writer, name, TYPE_FLOAT16, value);
+}
+
+int writerPutFloat32(ProtocolWriter *writer, uint8_t name, float fValue) {
+	ProtocolAttributeValue value;
+	value.fValue = fValue;
+
+	return writerPutNative(writer, name, TYPE_FLOAT32, value);
+}
+
+int writerPutBools(ProtocolWriter *writer, uint8_t name, uint8_t boolsValue) {
+	ProtocolAttributeValue value;
+	value.boolsValue = boolsValue;
+
+	return writerPutNative(writer, name, TYPE_BOOLS, value);
+}
+
+int writerPutAttribute(ProtocolWriter *writer, ProtocolAttribute *attribute) {
+	if (isNativeType(attribute->dataType))
+		return writerPutNative(writer, attribute->name, attribute->dataType, attribute->value);
+
+	if (isSeriesType(attribute->dataType))
+		return writerPutSeries(writer, attribute->name, attribute->dataType, attribute->value.bsValue + 1,
+			attribute->value.bsValue[0]);
+
+	if (attribute->dataType == TYPE_BYTE) {
+		return writerPutByte(writer, attribute->name, attribute->value.bValue);
+	} else if (attribute->dataType == TYPE_BYTES) {
+		return writerPutBytes(writer, attribute->name, attribute->value.bsValue + 1,
+			attribute->value.bsValue[0]);
+	} else if (attribute->dataType == TYPE_RBS) {
+		return writerPutRbs(writer, attribute->name, attribute->value.rbsValue);
+	} else { // attribute->dataType == TYPE_CHARS
+		return writerPutString(writer, attribute->name, attribute->value.csValue);
+	}
+}
+
+int writerSetText(ProtocolWriter *writer, const char text[]) {
+	if (writer->error != 0)
+		return writer->error;
+
+	if (writer->hasText || writer->childrenSize > 0) {
+		writerFails(writer, TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
+		return writer->error;
+	}
+
+	int size = strlen(text);
+	if (size > MAX_SIZE_TEXT_DATA) {
+		writerFails(writer, TUXP_ERROR_TEXT_DATA_TOO_LARGE);
+		return writer->error;
+	}
+
+	if (!writerOpenBody(writer) || !writerEnsure(writer, encodedTextSizeIn(text, writer->format)))
+		return writer->error;
+
+	if (writer->format == PROTOCOL_FORMAT_TLV) {
+		memcpy(writer->buff + writer->position, text, size);
+		writer->position += size;
+	} else {
+		writeEscaped(writer, (const uint8_t *)text, size);
+	}
+
+	writer->hasText = true;
+	writer->buff[writer->headerPosition + 5] |= 0x80;
+
+	return 0;
+}
+
+int writerPutProtocol(ProtocolWriter *writer, Protocol *protocol) {
+	for (int i = 0; i < protocol->attributesSize; i++)
+		writerPutAttribute(writer, protocol->attributes + i);
+
+	if (protocol->text)
+		writerSetText(writer, protocol->text);
+
+	for (Protocol *child = protocol->children; child; child = child->next)
+		writerPutChild(writer, child);
+
+	return writer->error;
+}
+
+int writerPutChild(ProtocolWriter *writer, Protocol *child) {
+	if (writer->error != 0)
+		return writer->error;
+
+	if (writer->hasText) {
+		writerFails(writer, TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
+		return writer->error;
+	}
+
+	if (writer->childrenSize >= MAX_SIZE_CHILDREN) {
+		writerFails(writer, TUXP_ERROR_TOO_MANY_CHILDREN);
+		return writer->error;
+	}
+
+	if (!writerOpenBody(writer))
+		return writer->error;
+
+	// The end flag of the previous child is turned into a unit splitter.
+	if (writer->format == PROTOCOL_FORMAT_ESCAPED && writer->childrenSize > 0)
+		writer->buff[writer->position - 1] = FLAG_UNIT_SPLITTER;
+
+	ProtocolWriter childWriter;
+	writerBeginEmbedded(&childWriter, writer->format, child->name, writer->buff, writer->buffSize,
+		writer->position);
+	writerPutProtocol(&childWriter, child);
+
+	int result = writerEnd(&childWriter);
+	if (result < 0) {
+		writerFails(writer, result);
+		return writer->error;
+	}
+
+	writer->position = result;
+	writer->childrenSize++;
+	writer->buff[writer->headerPosition + 5] = (writer->buff[writer->headerPosition + 5] & 0x80) |
+		writer->childrenSize;
+
+	return 0;
+}
+
+int writerEnd(ProtocolWriter *writer) {
+	if (writer->error != 0)
+		return writer->error;
+
+	if (writer->format == PROTOCOL_FORMAT_TLV) {
+		if (writer->position - writer->headerPosition - 1 > 0xff) {
+			writerFails(writer, TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
+			return writer->error;
+		}
+
+		writer->buff[writer->headerPosition] = writer->position - writer->headerPosition - 1;
+
+		return writer->position;
+	}
+
+	// The end flag of the child has closed the protocol.
+	if (writer->childrenSize > 0)
+		return writer->position;
+
+	// It's a bare protocol.
+	if (writer->attributesSize == 0 && !writer->hasText) {
+		writer->buff[writer->headerPosition + SIZE_PROTOCOL_NAME_HEADER] = FLAG_DOC_BEGINNING_END;
+		writer->position = writer->headerPosition + SIZE_PROTOCOL_NAME_HEADER + 1;
+
+		return writer->position;
+	}
+
+	if (writer->hasText) {
+		if (!writerEnsure(writer, 1))
+			return writer->error;
+
+		writer->buff[writer->position] = FLAG_DOC_BEGINNING_END;
+		writer->position++;
+	} else {
+		writer->buff[writer->position - 1] = FLAG_DOC_BEGINNING_END;
+	}
+
+	return writer->position;
+}
+
+static int rawValueSize(ProtocolAttribute *attribute) {
+	if (isNativeType(attribute->dataType)) {
+		uint8_t raw[MAX_SIZE_NATIVE_VALUE];
+		return encodeNativeValue(attribute->dataType, attribute->value, raw);
+	} else if (attribute->dataType == TYPE_BYTES || isSeriesType(attribute->dataType)) {
+		return attribute->value.bsValue[0];
+	} else if (attribute->dataType == TYPE_CHARS) {
+		return strlen(attribute->value.csValue);
+	} else { // attribute->dataType == TYPE_BYTE || attribute->dataType == TYPE_RBS
+		return 1;
+	}
+}
+
+int encodedAttributeSizeIn(ProtocolAttribute *attribute, ProtocolFormat format) {
+	if (format == PROTOCOL_FORMAT_TLV)
+		return SIZE_TLV_ATTRIBUTE_HEADER + rawValueSize(attribute);
+
+	return encodedAttributeSize(attribute);
+}
+
+int encodedTextSizeIn(const char text[], ProtocolFormat format) {
+	if (format == PROTOCOL_FORMAT_TLV)
+		return strlen(text);
+
+	return encodedTextSize(text);
+}
+
+int encodedAttributeSize(ProtocolAttribute *attribute) {
+	int valueSize;
+	if (isNativeType(attribute->dataType)) {
+		uint8_t raw[MAX_SIZE_NATIVE_VALUE];
+		int size = encodeNativeValue(attribute->dataType, attribute->value, raw);
+		valueSize = 2 + escapedSize(raw, size);
+	} else if (isSeriesType(attribute->dataType)) {
+		valueSize = 2 + escapedSize(attribute->value.bsValue + 1, attribute->value.bsValue[0]);
+	} else if (attribute->dataType == TYPE_BYTE) {
+		valueSize = 1 + singleByteSize(attribute->value.bValue);
+	} else if (attribute->dataType == TYPE_BYTES) {
+		valueSize = 1 + escapedValueSize(attribute->value.bsValue + 1, attribute->value.bsValue[0]);
+	} else if (attribute->dataType == TYPE_RBS) {
+		valueSize = singleByteSize(attribute->value.rbsValue);
+	} else { // attribute->dataType == TYPE_CHARS
+		valueSize = escapedValueSize((const uint8_t *)attribute->value.csValue,
+			strlen(attribute->value.csValue));
+	}
+
+	return 1 + valueSize + 1;
+}
+
+int encodedTextSize(const char text[]) {
+	return escapedSize((const uint8_t *)text, strlen(text));
+}
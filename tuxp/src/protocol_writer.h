@@ -0,0 +1,43 @@
+#ifndef MUD_PROTOCOL_WRITER_H
+#define MUD_PROTOCOL_WRITER_H
+
+#include "protocols.h"
+
+typedef struct {
+	uint8_t *buff;
+	int buffSize;
+	int position;
+	int headerPosition;
+	uint8_t attributesSize;
+	uint8_t childrenSize;
+	bool hasText;
+	ProtocolFormat format;
+	int error;
+} ProtocolWriter;
+
+void writerBegin(ProtocolWriter *writer, ProtocolName name, uint8_t buff[], int buffSize);
+void writerBeginAt(ProtocolWriter *writer, ProtocolName name, uint8_t buff[], int buffSize, int position);
+void writerBeginFormatAt(ProtocolWriter *writer, ProtocolFormat format, ProtocolName name,
+	uint8_t buff[], int buffSize, int position);
+int writerPutByte(ProtocolWriter *writer, uint8_t name, uint8_t bValue);
+int writerPutBytes(ProtocolWriter *writer, uint8_t name, const uint8_t bytes[], int size);
+int writerPutString(ProtocolWriter *writer, uint8_t name, const char string[]);
+int writerPutInt(ProtocolWriter *writer, uint8_t name, int iValue);
+int writerPutRbs(ProtocolWriter *writer, uint8_t name, uint8_t rbsValue);
+int writerPutVarint(ProtocolWriter *writer, uint8_t name, int32_t iValue);
+int writerPutFloat16(ProtocolWriter *writer, uint8_t name, float fValue);
+int writerPutFloat32(ProtocolWriter *writer, uint8_t name, float fValue);
+int writerPutBools(ProtocolWriter *writer, uint8_t name, uint8_t boolsValue);
+int writerPutSeries(ProtocolWriter *writer, uint8_t name, DataType dataType, const uint8_t series[], int size);
+int writerPutAttribute(ProtocolWriter *writer, ProtocolAttribute *attribute);
+int writerSetText(ProtocolWriter *writer, const char text[]);
+int writerPutProtocol(ProtocolWriter *writer, Protocol *protocol);
+int writerPutChild(ProtocolWriter *writer, Protocol *child);
+int writerEnd(ProtocolWriter *writer);
+
+int encodedAttributeSize(ProtocolAttribute *attribute);
+int encodedTextSize(const char text[]);
+int encodedAttributeSizeIn(ProtocolAttribute *attribute, ProtocolFormat format);
+int encodedTextSizeIn(const char text[], ProtocolFormat format);
+
+#endif
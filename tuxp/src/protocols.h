@@ -7,13 +7,31 @@
 #define DATA_SIZE(data) sizeof(data) / sizeof(uint8_t)
 #define CREATE_PROTOCOL_DATA(data) {data, DATA_SIZE(data)}
 
+#define MAX_SIZE_ATTRIBUTES 8
+#define SIZE_ATTRIBUTE_SLOTS (MAX_SIZE_ATTRIBUTES * 2)
+
 typedef enum {
 	TYPE_BYTE,
 	TYPE_BYTES,
 	TYPE_CHARS,
-	TYPE_RBS
+	TYPE_RBS,
+	TYPE_VARINT,
+	TYPE_FLOAT16,
+	TYPE_FLOAT32,
+	TYPE_BOOLS,
+	TYPE_INT_SERIES,
+	TYPE_FLOAT_SERIES
 } DataType;
 
+// Escaped frames find their boundaries with flag bytes. TLV frames are length prefixed
+// and carry their values as they are.
+typedef enum {
+	PROTOCOL_FORMAT_ESCAPED,
+	PROTOCOL_FORMAT_TLV
+} ProtocolFormat;
+
+// The first namespace byte can't be a flag byte (0xfa to 0xff). An escaped frame writes it raw right
+// after the beginning flag, where 0xfb and 0xfc mark compressed and TLV frames.
 typedef struct {
 	uint8_t ns[2];
 	uint8_t localName;
@@ -24,20 +42,34 @@ typedef union {
 	uint8_t *bsValue;
 	char *csValue;
 	uint8_t rbsValue;
+	int32_t iValue;
+	float fValue;
+	uint8_t boolsValue;
 } ProtocolAttributeValue;
 
-typedef struct ProtocolAttribute {
-	struct ProtocolAttribute *previous;
+// Numbers which arrive as chars are recognised when the attribute is added. They are
+// converted on the first typed read and the result is kept in number.
+#define NUMBER_NONE 0x00
+#define NUMBER_INT 0x01
+#define NUMBER_FLOAT 0x02
+#define NUMBER_CONVERTED 0x80
+
+typedef struct {
 	uint8_t name;
+	uint8_t numberType;
 	DataType dataType;
 	ProtocolAttributeValue value;
-	struct ProtocolAttribute *next;
+	ProtocolAttributeValue number;
 } ProtocolAttribute;
 
-typedef struct {
+typedef struct Protocol {
 	ProtocolName name;
-	ProtocolAttribute *attributes;
+	uint8_t attributesSize;
+	ProtocolAttribute attributes[MAX_SIZE_ATTRIBUTES];
+	uint8_t attributeSlots[SIZE_ATTRIBUTE_SLOTS];
 	char *text;
+	struct Protocol *children;
+	struct Protocol *next;
 } Protocol;
 
 typedef struct {
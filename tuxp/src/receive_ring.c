@@ -0,0 +1,69 @@
+#include <string.h>
+
+#include "receive_ring.h"
+
+#define MASK_RECEIVE_RING (SIZE_RECEIVE_RING - 1)
+
+// The data must be in place before the other side sees the index move.
+#if defined(__GNUC__)
+#define loadIndex(index) __atomic_load_n(&(index), __ATOMIC_ACQUIRE)
+#define storeIndex(index, value) __atomic_store_n(&(index), value, __ATOMIC_RELEASE)
+#else
+#define loadIndex(index) (index)
+#define storeIndex(index, value) ((index) = (value))
+#endif
+
+void initReceiveRing(ReceiveRing *ring) {
+	ring->head = 0;
+	ring->tail = 0;
+	ring->overflows = 0;
+}
+
+bool ringPutByte(ReceiveRing *ring, uint8_t b) {
+	uint8_t head = ring->head;
+	if ((uint8_t)(head - loadIndex(ring->tail)) == SIZE_RECEIVE_RING) {
+		ring->overflows++;
+		return false;
+	}
+
+	ring->data[head & MASK_RECEIVE_RING] = b;
+	storeIndex(ring->head, (uint8_t)(head + 1));
+
+	return true;
+}
+
+int ringPutBytes(ReceiveRing *ring, const uint8_t data[], int size) {
+	uint8_t head = ring->head;
+	int room = SIZE_RECEIVE_RING - (uint8_t)(head - loadIndex(ring->tail));
+	if (size > room) {
+		ring->overflows++;
+		size = room;
+	}
+
+	int position = head & MASK_RECEIVE_RING;
+	int firstPart = SIZE_RECEIVE_RING - position < size ? SIZE_RECEIVE_RING - position : size;
+	memcpy(ring->data + position, data, firstPart);
+	memcpy(ring->data, data + firstPart, size - firstPart);
+	storeIndex(ring->head, (uint8_t)(head + size));
+
+	return size;
+}
+
+int ringAvailable(ReceiveRing *ring) {
+	return (uint8_t)(loadIndex(ring->head) - ring->tail);
+}
+
+int ringTakeBytes(ReceiveRing *ring, uint8_t buff[], int buffSize) {
+	uint8_t tail = ring->tail;
+	int size = (uint8_t)(loadIndex(ring->head) - tail);
+	if (size > buffSize)
+		size = buffSize;
+
+	int position = tail & MASK_RECEIVE_RING;
+	int firstPart = SIZE_RECEIVE_RING - position < size ? SIZE_RECEIVE_RING - position : size;
+	memcpy(buff, ring->data + position, firstPart);
+	memcpy(buff + firstPart, ring->data, size - firstPart);
+	storeIndex(ring->tail, (uint8_t)(tail + size));
+
+	return size;
+}
@@ -0,0 +1,37 @@
+#ifndef MUD_RECEIVE_RING_H
+#define MUD_RECEIVE_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A power of two, so indices wrap with a mask, and no more than 128, so the byte-wide
+// counters stay apart when the ring is full.
+#ifndef SIZE_RECEIVE_RING
+#define SIZE_RECEIVE_RING 128
+#endif
+
+#if (SIZE_RECEIVE_RING & (SIZE_RECEIVE_RING - 1)) != 0 || SIZE_RECEIVE_RING > 128
+#error "SIZE_RECEIVE_RING must be a power of two up to 128."
+#endif
+
+// Bytes go from one producer, such as a UART interrupt or a reader thread, to one consumer
+// without locks. Only the producer writes head and only the consumer writes tail. Both are
+// single bytes, so they are read and written whole on 8 bit MCUs too.
+typedef struct {
+	volatile uint8_t head;
+	volatile uint8_t tail;
+	volatile uint8_t overflows;
+	uint8_t data[SIZE_RECEIVE_RING];
+} ReceiveRing;
+
+void initReceiveRing(ReceiveRing *ring);
+
+// Producer side. Returns false and counts an overflow when the ring is full.
+bool ringPutByte(ReceiveRing *ring, uint8_t b);
+int ringPutBytes(ReceiveRing *ring, const uint8_t data[], int size);
+
+// Consumer side. Takes what is there and never waits.
+int ringAvailable(ReceiveRing *ring);
+int ringTakeBytes(ReceiveRing *ring, uint8_t buff[], int buffSize);
+
+#endif
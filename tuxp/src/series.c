@@ -0,0 +1,159 @@
+#include <string.h>
+
+#include "tuxp.h"
+#include "native_values.h"
+#include "series.h"
+
+bool isSeriesType(DataType dataType) {
+	return dataType == TYPE_INT_SERIES || dataType == TYPE_FLOAT_SERIES;
+}
+
+// Deltas wrap around like unsigned numbers, so any int32 series survives the round trip.
+static int32_t subtract(int32_t minuend, int32_t subtrahend) {
+	return (int32_t)((uint32_t)minuend - (uint32_t)subtrahend);
+}
+
+static int32_t add(int32_t augend, int32_t addend) {
+	return (int32_t)((uint32_t)augend + (uint32_t)addend);
+}
+
+void seriesBeginEncoding(SeriesEncoder *encoder, DataType dataType, uint8_t buff[], int buffSize) {
+	encoder->dataType = dataType;
+	encoder->buff = buff;
+	encoder->buffSize = buffSize;
+	encoder->size = 0;
+	encoder->valuesSize = 0;
+	encoder->last = 0;
+	encoder->lastDelta = 0;
+}
+
+// A value which doesn't fit leaves the encoder untouched.
+int seriesPutInt(SeriesEncoder *encoder, int32_t value) {
+	if (encoder->dataType != TYPE_INT_SERIES)
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+
+	int32_t delta = encoder->valuesSize == 0 ? 0 : subtract(value, encoder->last);
+	int32_t encoded = encoder->valuesSize == 0 ? value : subtract(delta, encoder->lastDelta);
+
+	uint8_t varint[MAX_SIZE_VARINT];
+	int size = encodeVarint(encoded, varint);
+	if (encoder->size + size > encoder->buffSize)
+		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+	memcpy(encoder->buff + encoder->size, varint, size);
+	encoder->size += size;
+	encoder->valuesSize++;
+	encoder->last = value;
+	encoder->lastDelta = delta;
+
+	return 0;
+}
+
+// The control byte holds the number of trailing zero bytes in its high nibble and the
+// number of the meaningful bytes which follow it in its low nibble.
+int seriesPutFloat(SeriesEncoder *encoder, float fValue) {
+	if (encoder->dataType != TYPE_FLOAT_SERIES)
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+
+	uint32_t bits;
+	memcpy(&bits, &fValue, sizeof(bits));
+	uint32_t xored = bits ^ (uint32_t)encoder->last;
+
+	int trailingBytes = 0;
+	int meaningfulBytes = 0;
+	if (xored != 0) {
+		while (((xored >> (8 * trailingBytes)) & 0xff) == 0)
+			trailingBytes++;
+
+		meaningfulBytes = 4 - trailingBytes;
+		while (((xored >> (8 * (trailingBytes + meaningfulBytes - 1))) & 0xff) == 0)
+			meaningfulBytes--;
+	}
+
+	if (encoder->size + 1 + meaningfulBytes > encoder->buffSize)
+		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+	encoder->buff[encoder->size] = (trailingBytes << 4) | meaningfulBytes;
+	for (int i = 0; i < meaningfulBytes; i++)
+		encoder->buff[encoder->size + 1 + i] = (xored >> (8 * (trailingBytes + i))) & 0xff;
+
+	encoder->size += 1 + meaningfulBytes;
+	encoder->valuesSize++;
+	encoder->last = (int32_t)bits;
+
+	return 0;
+}
+
+void seriesBeginDecoding(SeriesDecoder *decoder, DataType dataType, const uint8_t data[], int size) {
+	decoder->dataType = dataType;
+	decoder->data = data;
+	decoder->size = size;
+	decoder->position = 0;
+	decoder->last = 0;
+	decoder->lastDelta = 0;
+}
+
+bool seriesNextInt(SeriesDecoder *decoder, int32_t *value) {
+	if (decoder->dataType != TYPE_INT_SERIES || decoder->position >= decoder->size)
+		return false;
+
+	int32_t encoded;
+	int size = decodeVarint(decoder->data + decoder->position, decoder->size - decoder->position, &encoded);
+	if (size < 0)
+		return false;
+
+	if (decoder->position == 0) {
+		decoder->last = encoded;
+	} else {
+		decoder->lastDelta = add(decoder->lastDelta, encoded);
+		decoder->last = add(decoder->last, decoder->lastDelta);
+	}
+
+	decoder->position += size;
+	*value = decoder->last;
+
+	return true;
+}
+
+bool seriesNextFloat(SeriesDecoder *decoder, float *value) {
+	if (decoder->dataType != TYPE_FLOAT_SERIES || decoder->position >= decoder->size)
+		return false;
+
+	uint8_t control = decoder->data[decoder->position];
+	int trailingBytes = control >> 4;
+	int meaningfulBytes = control & 0x0f;
+	if (trailingBytes + meaningfulBytes > 4 || (meaningfulBytes == 0 && trailingBytes != 0) ||
+			decoder->position + 1 + meaningfulBytes > decoder->size)
+		return false;
+
+	uint32_t xored = 0;
+	for (int i = 0; i < meaningfulBytes; i++)
+		xored |= (uint32_t)decoder->data[decoder->position + 1 + i] << (8 * (trailingBytes + i));
+
+	uint32_t bits = xored ^ (uint32_t)decoder->last;
+	decoder->last = (int32_t)bits;
+	decoder->position += 1 + meaningfulBytes;
+	memcpy(value, &bits, sizeof(bits));
+
+	return true;
+}
+
+int countSeriesValues(DataType dataType, const uint8_t data[], int size) {
+	SeriesDecoder decoder;
+	seriesBeginDecoding(&decoder, dataType, data, size);
+
+	int valuesSize = 0;
+	if (dataType == TYPE_INT_SERIES) {
+		int32_t iValue;
+		while (seriesNextInt(&decoder, &iValue))
+			valuesSize++;
+	} else if (dataType == TYPE_FLOAT_SERIES) {
+		float fValue;
+		while (seriesNextFloat(&decoder, &fValue))
+			valuesSize++;
+	} else {
+		return TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH;
+	}
+
+	return decoder.position == size ? valuesSize : TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+}
@@ -0,0 +1,43 @@
+#ifndef MUD_SERIES_H
+#define MUD_SERIES_H
+
+#include "protocols.h"
+
+#ifndef MAX_SIZE_SERIES_DATA
+#define MAX_SIZE_SERIES_DATA 48
+#endif
+
+// An int series is its first value followed by zigzag varints of the delta of deltas.
+// A float series is a control byte and the meaningful bytes of each value XORed with
+// the previous one, so that repeated values take a single byte.
+typedef struct {
+	DataType dataType;
+	uint8_t *buff;
+	int buffSize;
+	int size;
+	uint8_t valuesSize;
+	int32_t last;
+	int32_t lastDelta;
+} SeriesEncoder;
+
+typedef struct {
+	DataType dataType;
+	const uint8_t *data;
+	int size;
+	int position;
+	int32_t last;
+	int32_t lastDelta;
+} SeriesDecoder;
+
+bool isSeriesType(DataType dataType);
+
+void seriesBeginEncoding(SeriesEncoder *encoder, DataType dataType, uint8_t buff[], int buffSize);
+int seriesPutInt(SeriesEncoder *encoder, int32_t value);
+int seriesPutFloat(SeriesEncoder *encoder, float value);
+
+void seriesBeginDecoding(SeriesDecoder *decoder, DataType dataType, const uint8_t data[], int size);
+bool seriesNextInt(SeriesDecoder *decoder, int32_t *value);
+bool seriesNextFloat(SeriesDecoder *decoder, float *value);
+int countSeriesValues(DataType dataType, const uint8_t data[], int size);
+
+#endif
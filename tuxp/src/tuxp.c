@@ -1,208 +1,321 @@
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
 
 #include "debug.h"
 #include "tuxp.h"
+#include "allocator.h"
+#include "native_values.h"
+#include "decimal.h"
 
 #define MIN_SIZE_PROTOCOL_DATA 2 + 3
-#define MIN_SIZE_LAN_EXECUTION_DATA MIN_SIZE_PROTOCOL_DATA + (SIZE_THINGS_TINY_ID + 2) + 5
 #define MIN_SIZE_LAN_RESPONSE_DATA 2 + 5 + 1 + 1 + SIZE_THINGS_TINY_ID
-#define MIN_SIZE_LAN_ERROR_DATA 2 + 5 + 1 + 1 + SIZE_THINGS_TINY_ID + 1 + 2 + 1
-#define MIN_SIZE_LAN_NOTIFICATION_DATA MIN_SIZE_PROTOCOL_DATA + (SIZE_THINGS_TINY_ID + 2) + 5
-
-static const uint8_t LAN_EXECUTION_PREFIX_BYTES[] ={
-	0xff, 0xf8, 0x04, 0x05, 0x01, 0x01
-};
-static const int SIZE_LAN_EXECUTION_PREFIX_BYTES = sizeof(LAN_EXECUTION_PREFIX_BYTES);
-
-static const uint8_t LAN_ERROR_PREFIX_BYTES[] ={
-	0xff, 0xf8, 0x02, 0x07, 0x02, 0x00
-};
-static const uint8_t LAN_RESPONSE_PREFIX_BYTES[] = {
-	0xff, 0xf8, 0x02, 0x07, 0x01, 0x00
-};
-static const int SIZE_LAN_ANSWER_PREFIX_BYTES = sizeof(LAN_ERROR_PREFIX_BYTES);
-
-static const uint8_t LAN_NOTIFICATION_PREFIX_BYTES[] ={
-	0xff, 0xf8, 0x02, 0x05, 0x01, 0x01
-};
-static const int SIZE_LAN_NOTIFICATION_PREFIX_BYTES = sizeof(LAN_NOTIFICATION_PREFIX_BYTES);
-
-static const uint8_t LAN_REPORT_PREFIX_BYTES[] ={
-	0xff, 0xf8, 0x0a, 0x05, 0x01, 0x01
-};
-static const int SIZE_LAN_REPORT_PREFIX_BYTES = sizeof(LAN_REPORT_PREFIX_BYTES);
+
+#define NAME_ATTRIBUTE_ACK_REQUIRED_LAN_PROTOCOL 0x01
+#define NAME_ATTRIBUTE_TINY_ID_LAN_PROTOCOL 0x06
+#define NAME_ATTRIBUTE_ERROR_NUMBER_LAN_ANSWER 0x08
+
+static const ProtocolName NAME_LAN_EXECUTION = {{0xf8, 0x04}, 0x05};
+static const ProtocolName NAME_LAN_ANSWER = {{0xf8, 0x02}, 0x07};
+static const ProtocolName NAME_LAN_NOTIFICATION = {{0xf8, 0x02}, 0x05};
+static const ProtocolName NAME_LAN_REPORT = {{0xf8, 0x0a}, 0x05};
 
 Protocol createEmptyProtocol() {
 	ProtocolName name = {{0xff, 0xff}, 0xff};
 	return createProtocol(name);
 }
 
+void initProtocolAttributes(Protocol *protocol) {
+	protocol->attributesSize = 0;
+	memset(protocol->attributeSlots, 0, SIZE_ATTRIBUTE_SLOTS);
+}
+
 Protocol createProtocol(ProtocolName name) {
-	Protocol pEmpty = {name, NULL, NULL};
+	Protocol pEmpty;
+	pEmpty.name = name;
+	pEmpty.text = NULL;
+	pEmpty.children = NULL;
+	pEmpty.next = NULL;
+	initProtocolAttributes(&pEmpty);
+
 	return pEmpty;
 }
 
-void addAttributeToProtocol(Protocol *protocol, ProtocolAttribute *attribute) {
-	attribute->previous = NULL;
-	attribute->next = NULL;
+uint8_t findAttributeSlot(Protocol *protocol, uint8_t name) {
+	uint8_t slot = name % SIZE_ATTRIBUTE_SLOTS;
+	while (protocol->attributeSlots[slot] != 0 &&
+			protocol->attributes[protocol->attributeSlots[slot] - 1].name != name) {
+		slot = (slot + 1) % SIZE_ATTRIBUTE_SLOTS;
+	}
 
-	if (!protocol->attributes) {
-		protocol->attributes = attribute;
-	} else {
-		ProtocolAttribute *lastAttribute = protocol->attributes;
-		while (lastAttribute) {
-			if (lastAttribute->next)
-				lastAttribute = lastAttribute->next;
-			else
-				break;
-		}
+	return slot;
+}
+
+int checkAttributeAddable(Protocol *protocol) {
+	if (protocol->text)
+		return TUXP_ERROR_PROTOCOL_CHANGE_CLOSED;
+
+	if (protocol->attributesSize >= MAX_SIZE_ATTRIBUTES)
+		return TUXP_ERROR_TOO_MANY_ATTRIBUTES;
+
+	return 0;
+}
+
+static bool isDigit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+static int skipDigits(const char *chars, int position) {
+	while (isDigit(chars[position]))
+		position++;
+
+	return position;
+}
+
+// Plain integers short enough for a 32-bit int, or decimals with an optional exponent.
+// Anything else is read as atoi() and atof() would read it, each time.
+static uint8_t recogniseNumber(const char *chars) {
+	int position = chars[0] == '-' || chars[0] == '+' ? 1 : 0;
+	int digitsEnd = skipDigits(chars, position);
+	int digitsSize = digitsEnd - position;
+	if (chars[digitsEnd] == '\0')
+		return digitsSize > 0 && digitsSize <= 9 ? NUMBER_INT : NUMBER_NONE;
+
+	position = digitsEnd;
+	if (chars[position] == '.') {
+		int fractionEnd = skipDigits(chars, position + 1);
+		digitsSize += fractionEnd - position - 1;
+		position = fractionEnd;
+	}
+
+	if (digitsSize == 0)
+		return NUMBER_NONE;
 
-		lastAttribute->next = attribute;
-		attribute->previous = lastAttribute;
+	if (chars[position] == 'e' || chars[position] == 'E') {
+		position++;
+		if (chars[position] == '-' || chars[position] == '+')
+			position++;
+
+		if (!isDigit(chars[position]))
+			return NUMBER_NONE;
+
+		position = skipDigits(chars, position);
 	}
+
+	return chars[position] == '\0' ? NUMBER_FLOAT : NUMBER_NONE;
+}
+
+void addAttributeToProtocol(Protocol *protocol, ProtocolAttribute *attribute) {
+	ProtocolAttribute *added = protocol->attributes + protocol->attributesSize;
+	*added = *attribute;
+	added->numberType = attribute->dataType == TYPE_CHARS ? recogniseNumber(attribute->value.csValue) : NUMBER_NONE;
+	protocol->attributesSize++;
+
+	// Lookups by name always find the first attribute with the name.
+	uint8_t slot = findAttributeSlot(protocol, attribute->name);
+	if (protocol->attributeSlots[slot] == 0)
+		protocol->attributeSlots[slot] = protocol->attributesSize;
 }
 
 int addBytesAttribute(Protocol *protocol, uint8_t name, uint8_t bytes[], int size) {
-	if (protocol->text)
-		return debugErrorAndReturn("addBytesAttribute", TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
+	int addable = checkAttributeAddable(protocol);
+	if (addable != 0)
+		return debugErrorAndReturn("addBytesAttribute", addable);
 
 	if (size > MAX_SIZE_ATTRIBUTE_DATA)
 		return debugErrorAndReturn("addBytesAttribute", TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
 
-	ProtocolAttribute *attribute = malloc(sizeof(ProtocolAttribute));
-	attribute->name = name;
-	attribute->dataType = TYPE_BYTES;
+	ProtocolAttribute attribute;
+	attribute.name = name;
+	attribute.dataType = TYPE_BYTES;
 
-	attribute->value.bsValue = malloc((size + 1) * sizeof(uint8_t));
-	if (!attribute->value.bsValue)
+	attribute.value.bsValue = tuxpAlloc((size + 1) * sizeof(uint8_t), ALLOCATION_SITE_ATTRIBUTE_VALUE);
+	if (!attribute.value.bsValue)
 		return debugErrorAndReturn("addBytesAttribute", TUXP_ERROR_OUT_OF_MEMEORY);
-	*(attribute->value.bsValue) = (uint8_t)size;
-	memcpy(attribute->value.bsValue + 1, bytes, size);
+	*(attribute.value.bsValue) = (uint8_t)size;
+	memcpy(attribute.value.bsValue + 1, bytes, size);
 
-	addAttributeToProtocol(protocol, attribute);
+	addAttributeToProtocol(protocol, &attribute);
 	return 0;
 }
 
 int addStringAttribute(Protocol *protocol, uint8_t name, char string[]) {
-	if(protocol->text)
-		return debugErrorAndReturn("addStringAttribute", TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
+	int addable = checkAttributeAddable(protocol);
+	if (addable != 0)
+		return debugErrorAndReturn("addStringAttribute", addable);
 	
 	long strLength = strlen(string);
 	if (strLength > MAX_SIZE_ATTRIBUTE_DATA)
 		return debugErrorAndReturn("addStringAttribute", TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
 	
-	ProtocolAttribute *attribute = malloc(sizeof(ProtocolAttribute));
-	if (!attribute)
-		return debugErrorAndReturn("addStringAttribute", TUXP_ERROR_OUT_OF_MEMEORY);
-	
-	attribute->name = name;
-	attribute->dataType = TYPE_CHARS;
+	ProtocolAttribute attribute;
+	attribute.name = name;
+	attribute.dataType = TYPE_CHARS;
 	
-	attribute->value.csValue = malloc((strLength + 1) * sizeof(char));
-	if (!attribute->value.csValue)
+	attribute.value.csValue = tuxpAlloc((strLength + 1) * sizeof(char), ALLOCATION_SITE_ATTRIBUTE_VALUE);
+	if (!attribute.value.csValue)
 		return debugErrorAndReturn("addStringAttribute", TUXP_ERROR_OUT_OF_MEMEORY);
 	
-	strcpy(attribute->value.csValue, string);
+	strcpy(attribute.value.csValue, string);
 	
-	addAttributeToProtocol(protocol, attribute);
+	addAttributeToProtocol(protocol, &attribute);
 	return 0;
 }
 
 int addByteAttribute(Protocol *protocol, uint8_t name, uint8_t bValue) {
-	if(protocol->text)
-		return debugErrorAndReturn("addByteAttribute", TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
+	int addable = checkAttributeAddable(protocol);
+	if (addable != 0)
+		return debugErrorAndReturn("addByteAttribute", addable);
 
-	ProtocolAttribute *attribute = malloc(sizeof(ProtocolAttribute));
+	ProtocolAttribute attribute;
+	attribute.name = name;
+	attribute.dataType = TYPE_BYTE;
+	attribute.value.bValue = bValue;
 
-	attribute->name = name;
-	attribute->dataType = TYPE_BYTE;
+	addAttributeToProtocol(protocol, &attribute);
+	return 0;
+}
+
+static int addNativeAttribute(Protocol *protocol, uint8_t name, DataType dataType,
+			ProtocolAttributeValue value) {
+	int addable = checkAttributeAddable(protocol);
+	if (addable != 0)
+		return debugErrorAndReturn("addNativeAttribute", addable);
 
-	attribute->value.bValue = bValue;
+	ProtocolAttribute attribute;
+	attribute.name = name;
+	attribute.dataType = dataType;
+	attribute.value = value;
 
-	addAttributeToProtocol(protocol, attribute);
+	addAttributeToProtocol(protocol, &attribute);
 	return 0;
 }
 
-int addIntAttribute(Protocol *protocol, uint8_t name, int iValue) {
-	if(protocol->text)
-		return debugErrorAndReturn("addIntAttribute", TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
-	
-	ProtocolAttribute *attribute = malloc(sizeof(ProtocolAttribute));
+int addVarintAttribute(Protocol *protocol, uint8_t name, int32_t iValue) {
+	ProtocolAttributeValue value;
+	value.iValue = iValue;
+
+	return addNativeAttribute(protocol, name, TYPE_VARINT, value);
+}
+
+int addFloat16Attribute(Protocol *protocol, uint8_t name, float fValue) {
+	ProtocolAttributeValue value;
+	value.fValue = fValue;
+
+	return addNativeAttribute(protocol, name, TYPE_FLOAT16, value);
+}
+
+int addFloat32Attribute(Protocol *protocol, uint8_t name, float fValue) {
+	ProtocolAttributeValue value;
+	value.fValue = fValue;
+
+	return addNativeAttribute(protocol, name, TYPE_FLOAT32, value);
+}
 
-	attribute->name = name;
-	attribute->dataType = TYPE_CHARS;
+int addBoolsAttribute(Protocol *protocol, uint8_t name, bool bools[], int size) {
+	if (size > MAX_SIZE_BOOLS)
+		return debugErrorAndReturn("addBoolsAttribute", TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
 
-	char charsData[16];
-	sprintf(charsData, "%d", iValue);
-	attribute->value.csValue = malloc(sizeof(char) * (strlen(charsData) + 1));
-	if(!attribute->value.csValue)
-		return debugErrorAndReturn("addIntAttribute", TUXP_ERROR_OUT_OF_MEMEORY);
-	strcpy(attribute->value.csValue, charsData);
+	ProtocolAttributeValue value;
+	value.boolsValue = 0;
+	for (int i = 0; i < size; i++) {
+		if (bools[i])
+			value.boolsValue |= 1 << i;
+	}
+
+	return addNativeAttribute(protocol, name, TYPE_BOOLS, value);
+}
+
+int addSeriesAttribute(Protocol *protocol, uint8_t name, const SeriesEncoder *encoder) {
+	int addable = checkAttributeAddable(protocol);
+	if (addable != 0)
+		return debugErrorAndReturn("addSeriesAttribute", addable);
+
+	if (encoder->size > MAX_SIZE_SERIES_DATA)
+		return debugErrorAndReturn("addSeriesAttribute", TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
+
+	ProtocolAttribute attribute;
+	attribute.name = name;
+	attribute.dataType = encoder->dataType;
 
-	addAttributeToProtocol(protocol, attribute);
+	attribute.value.bsValue = tuxpAlloc((encoder->size + 1) * sizeof(uint8_t), ALLOCATION_SITE_ATTRIBUTE_VALUE);
+	if (!attribute.value.bsValue)
+		return debugErrorAndReturn("addSeriesAttribute", TUXP_ERROR_OUT_OF_MEMEORY);
+	*(attribute.value.bsValue) = (uint8_t)encoder->size;
+	memcpy(attribute.value.bsValue + 1, encoder->buff, encoder->size);
+
+	addAttributeToProtocol(protocol, &attribute);
 	return 0;
 }
 
-int addFloatAttribute(Protocol *protocol, uint8_t name, float fValue) {
-	if(protocol->text)
-		return debugErrorAndReturn("addFloatAttribute", TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
-	
-	ProtocolAttribute *attribute = malloc(sizeof(ProtocolAttribute));
-
-	attribute->name = name;
-	attribute->dataType = TYPE_CHARS;
-
-	char charsData[32];
-#ifdef ARDUINO
-	dtostrf(fValue, -8, 2, charsData);
-	for (int i = 0; i < 32; i++) {
-		if(charsData[i] == ' ') {
-			charsData[i] = 0;
-			break;
-		} else if (charsData[i] == 0) {
-			break;
-		} else {
-			// NOOP
-		}
+int addIntSeriesAttribute(Protocol *protocol, uint8_t name, const int32_t values[], int size) {
+	uint8_t buff[MAX_SIZE_SERIES_DATA];
+	SeriesEncoder encoder;
+	seriesBeginEncoding(&encoder, TYPE_INT_SERIES, buff, sizeof(buff));
+	for (int i = 0; i < size; i++) {
+		if (seriesPutInt(&encoder, values[i]) != 0)
+			return debugErrorAndReturn("addIntSeriesAttribute", TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
+	}
+
+	return addSeriesAttribute(protocol, name, &encoder);
+}
+
+int addFloatSeriesAttribute(Protocol *protocol, uint8_t name, const float values[], int size) {
+	uint8_t buff[MAX_SIZE_SERIES_DATA];
+	SeriesEncoder encoder;
+	seriesBeginEncoding(&encoder, TYPE_FLOAT_SERIES, buff, sizeof(buff));
+	for (int i = 0; i < size; i++) {
+		if (seriesPutFloat(&encoder, values[i]) != 0)
+			return debugErrorAndReturn("addFloatSeriesAttribute", TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
 	}
+
+	return addSeriesAttribute(protocol, name, &encoder);
+}
+
+int addIntAttribute(Protocol *protocol, uint8_t name, int iValue) {
+#ifdef TUXP_NATIVE_NUMBERS
+	return addVarintAttribute(protocol, name, iValue);
 #else
-	sprintf(charsData, "%f", fValue);
-#endif
+	char charsData[MAX_SIZE_DECIMAL_INT];
+	formatDecimalInt(iValue, charsData, sizeof(charsData));
 
-	attribute->value.csValue = malloc(sizeof(char) * (strlen(charsData) + 1));
-	if(!attribute->value.csValue)
-		return debugErrorAndReturn("addFloatAttribute", TUXP_ERROR_OUT_OF_MEMEORY);
-	strcpy(attribute->value.csValue, charsData);
-	
-	addAttributeToProtocol(protocol, attribute);
-	return 0;
+	return addStringAttribute(protocol, name, charsData);
+#endif
 }
 
-int addRbsAttribute(Protocol *protocol, uint8_t name, uint8_t rbsValue) {
-	if(protocol->text)
-		return debugErrorAndReturn("addRbsAttribute", TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
+int addFloatAttribute(Protocol *protocol, uint8_t name, float fValue) {
+#ifdef TUXP_NATIVE_NUMBERS
+	return addFloat32Attribute(protocol, name, fValue);
+#else
+	char charsData[MAX_SIZE_ATTRIBUTE_DATA + 1];
+	if (formatDecimalFixed(fValue, SIZE_DECIMAL_FRACTION_DIGITS, charsData, sizeof(charsData)) < 0)
+		return debugErrorAndReturn("addFloatAttribute", TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE);
 
-	ProtocolAttribute *attribute = malloc(sizeof(ProtocolAttribute));
+	return addStringAttribute(protocol, name, charsData);
+#endif
+}
 
-	attribute->name = name;
-	attribute->dataType = TYPE_RBS;
+int addRbsAttribute(Protocol *protocol, uint8_t name, uint8_t rbsValue) {
+	int addable = checkAttributeAddable(protocol);
+	if (addable != 0)
+		return debugErrorAndReturn("addRbsAttribute", addable);
 
-	attribute->value.rbsValue = rbsValue;
+	ProtocolAttribute attribute;
+	attribute.name = name;
+	attribute.dataType = TYPE_RBS;
+	attribute.value.rbsValue = rbsValue;
 
-	addAttributeToProtocol(protocol, attribute);
+	addAttributeToProtocol(protocol, &attribute);
 	return 0;
 }
 
 int setText(Protocol *protocol, char *text) {
-	if(protocol->text)
+	if(protocol->text || protocol->children)
 		return debugErrorAndReturn("setText", TUXP_ERROR_PROTOCOL_CHANGE_CLOSED);
 
 	if (strlen(text) > MAX_SIZE_TEXT_DATA)
 		return debugErrorAndReturn("setText", TUXP_ERROR_TEXT_DATA_TOO_LARGE);
 
-	protocol->text = malloc(sizeof(char) * (strlen(text) + 1));
+	protocol->text = tuxpAlloc(sizeof(char) * (strlen(text) + 1), ALLOCATION_SITE_TEXT);
 	if (!protocol->text)
 		return debugErrorAndReturn("setText", TUXP_ERROR_OUT_OF_MEMEORY);
 
@@ -210,103 +323,62 @@ int setText(Protocol *protocol, char *text) {
 	return 0;
 }
 
-int escape(uint8_t data[], int size, ProtocolData *pData) {
-	if (size > MAX_SIZE_ATTRIBUTE_DATA)
-		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+static Protocol *newChildProtocol() {
+	return tuxpAlloc(sizeof(Protocol), ALLOCATION_SITE_CHILD_PROTOCOL);
+}
 
-	int position = 0;
-	uint8_t buff[MAX_SIZE_ATTRIBUTE_DATA];
-	for (int i = 0; i < size; i++) {
-		if (position > MAX_SIZE_ATTRIBUTE_DATA)
-			return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
-
-		if (data[i] == FLAG_DOC_BEGINNING_END ||
-				data[i] == FLAG_UNIT_SPLITTER ||
-				data[i] == FLAG_ESCAPE ||
-				data[i] == FLAG_BYTES_TYPE ||
-				data[i] == FLAG_BYTE_TYPE) {
-			buff[position] = FLAG_ESCAPE;
-			position++;
-		}
+static void deleteChildProtocol(Protocol *child) {
+	tuxpFree(child, sizeof(Protocol));
+}
 
-		buff[position] = data[i];
-		position++;
+static Protocol *appendChild(Protocol *protocol, ProtocolName name) {
+	int childrenSize = 0;
+	Protocol **last = &protocol->children;
+	while (*last) {
+		childrenSize++;
+		last = &(*last)->next;
 	}
 
-	if (position == 1) {
-		pData->data = malloc(sizeof(uint8_t) * 2);
-		if (!pData->data)
-			return TUXP_ERROR_OUT_OF_MEMEORY;
-
-		pData->data[1] = buff[0];
-		pData->data[0] = FLAG_NOREPLACE;
-		pData->dataSize = 2;
-	} else {
-		pData->data = malloc(sizeof(uint8_t) * position);
-		if(!pData->data)
-			return TUXP_ERROR_OUT_OF_MEMEORY;
+	if (childrenSize >= MAX_SIZE_CHILDREN)
+		return NULL;
 
-		memcpy(pData->data, buff, position);
-		pData->dataSize = position;
-	}
+	Protocol *child = newChildProtocol();
+	if (!child)
+		return NULL;
 
-	return 0;
-}
+	*child = createProtocol(name);
+	*last = child;
 
-bool isEscapedByte(uint8_t b) {
-	return b >= 0xfa && b <= 0xff;
+	return child;
 }
 
-int unescape(uint8_t data[], int size, ProtocolData *pData) {
-	if (size > MAX_SIZE_ATTRIBUTE_DATA)
-		return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
-
-	int position = 0;
-	uint8_t buff[MAX_SIZE_ATTRIBUTE_DATA];
-	for (int i = 0; i < size; i++) {
-		if (data[i] == FLAG_ESCAPE && i < (size - 1) && isEscapedByte(data[i + 1])) {
-			continue;
-		}
-
-		buff[position] = data[i];
-		position++;
-	}
-
-	if (position == 1) {
-		pData->data = malloc(sizeof(uint8_t) * 1);
-		if (!pData->data)
-			return TUXP_ERROR_OUT_OF_MEMEORY;
-
-		pData->data[0] = buff[0];
-		pData->dataSize = 1;
-	} else if (buff[0] == FLAG_BYTES_TYPE) {
-		pData->data = malloc(sizeof(uint8_t) * (position - 1));
-		if(!pData->data)
-			return TUXP_ERROR_OUT_OF_MEMEORY;
+// Children are owned by their parent and released with it.
+Protocol *addChild(Protocol *protocol, ProtocolName name) {
+	if (protocol->text)
+		return NULL;
 
-		memcpy(pData->data, buff + 1, position - 1);
-		pData->dataSize = position - 1;
-	} else if ((position == 2 && buff[0] == FLAG_BYTE_TYPE) ||
-				(position == 2 && buff[0] == FLAG_NOREPLACE)) {
-		pData->data = malloc(sizeof(uint8_t) * 1);
-		if(!pData->data)
-			return TUXP_ERROR_OUT_OF_MEMEORY;
+	return appendChild(protocol, name);
+}
 
-		pData->data[0] = buff[1];
-		pData->dataSize = 1;
-	} else {
-		pData->data = malloc(sizeof(uint8_t) * position);
-		if(!pData->data)
-			return TUXP_ERROR_OUT_OF_MEMEORY;
+int getChildrenSize(Protocol *protocol) {
+	int childrenSize = 0;
+	for (Protocol *child = protocol->children; child; child = child->next)
+		childrenSize++;
 
-		memcpy(pData->data, buff, position);
-		pData->dataSize = position;
-	}
+	return childrenSize;
+}
 
-	return 0;
+static bool isTlvProtocolData(ProtocolData *pData) {
+	return pData->dataSize >= SIZE_TLV_FRAME_PREFIX + 5 &&
+		pData->data[0] == FLAG_DOC_BEGINNING_END &&
+		pData->data[1] == FLAG_TLV_FRAME &&
+		pData->dataSize == SIZE_TLV_FRAME_PREFIX + pData->data[2];
 }
 
 bool isValidProtocolData(ProtocolData *pData) {
+	if (isTlvProtocolData(pData))
+		return true;
+
 	if (pData->dataSize < MIN_SIZE_PROTOCOL_DATA)
 		return false;
 
@@ -316,214 +388,130 @@ bool isValidProtocolData(ProtocolData *pData) {
 	return true;
 }
 
+static bool hasName(ProtocolData *pData, ProtocolName name) {
+	int namePosition = isTlvProtocolData(pData) ? SIZE_TLV_FRAME_PREFIX : 1;
+
+	return pData->data[namePosition] == name.ns[0] &&
+		pData->data[namePosition + 1] == name.ns[1] &&
+		pData->data[namePosition + 2] == name.localName;
+}
+
 bool isProtocol(ProtocolData *pData, ProtocolName name) {
 	if (!isValidProtocolData(pData))
 		return false;
 
-	return pData->data[1] == name.ns[0] &&
-		pData->data[2] == name.ns[1] &&
-		pData->data[3] == name.localName;
+	return hasName(pData, name);
 }
 
 bool isBareProtocol(ProtocolData *pData, ProtocolName name) {
-	if(pData->dataSize != 5)
+	if (isTlvProtocolData(pData)) {
+		if (pData->dataSize != SIZE_TLV_FRAME_PREFIX + 5 ||
+				pData->data[SIZE_TLV_FRAME_PREFIX + 3] != 0 || pData->data[SIZE_TLV_FRAME_PREFIX + 4] != 0)
+			return false;
+	} else if(pData->dataSize != 5) {
 		return false;
-
-	return pData->data[1] == name.ns[0] &&
-		pData->data[2] == name.ns[1] &&
-		pData->data[3] == name.localName;
-}
-
-int findAttributeValueEnd(ProtocolData *pData, int position, int *escapeNumber) {
-	while (position <= (pData->dataSize - 1)) {
-		uint8_t current = pData->data[position];
-		if (current == FLAG_ESCAPE) {
-			if ((position + 1) >= (pData->dataSize - 1))
-				return -1;
-
-			if (pData->data[position + 1] < 0xfa)
-				return -1;
-
-			(*escapeNumber)++;
-			position += 2;
-			continue;
-		}
-
-		if (pData->data[position] == FLAG_UNIT_SPLITTER ||
-				pData->data[position] == FLAG_DOC_BEGINNING_END)
-			return position;
-
-		position++;
 	}
 
-	return -1;
+	return hasName(pData, name);
 }
 
-int assembleProtocolAttributeValue(ProtocolData *pData, ProtocolAttribute *attribute,
-			int attributeValueStartPosition, int attributeValueEndPosition, int escapeNumber) {
-	int attributeValueSize = (attributeValueEndPosition - attributeValueStartPosition - escapeNumber);
-	uint8_t firstByteOfAttribute = pData->data[attributeValueStartPosition];
-	if (firstByteOfAttribute == FLAG_BYTE_TYPE) {
-		if (escapeNumber > 1)
-			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+int assembleProtocolAttributeValue(AttributeView *attributeView, ProtocolAttribute *attribute) {
+	attribute->dataType = attributeView->dataType;
+
+	if (isNativeType(attributeView->dataType)) {
+		return viewDecodeNativeValue(attributeView, &attribute->value);
+	} else if (attributeView->dataType == TYPE_BYTE) {
+		attribute->value.bValue = attributeView->escapeNumber == 0 ?
+			attributeView->data[0] : attributeView->data[1];
+	} else if (attributeView->dataType == TYPE_RBS) {
+		attribute->value.rbsValue = attributeView->escapeNumber == 0 ?
+			attributeView->data[0] : attributeView->data[1];
+	} else if (attributeView->dataType == TYPE_BYTES || isSeriesType(attributeView->dataType)) {
+		uint8_t buff[MAX_SIZE_SERIES_DATA];
+		int size = viewCopyValue(attributeView, buff, attributeView->dataType == TYPE_BYTES ?
+			MAX_SIZE_ATTRIBUTE_DATA : MAX_SIZE_SERIES_DATA);
+		if (size < 0)
+			return size;
+
+		attribute->value.bsValue = tuxpAlloc(sizeof(uint8_t) * (size + 1), ALLOCATION_SITE_ATTRIBUTE_VALUE);
+		if(!attribute->value.bsValue)
+			return TUXP_ERROR_OUT_OF_MEMEORY;
 
-		attribute->dataType = TYPE_BYTE;
-		if (escapeNumber == 0) {
-			attribute->value.bValue = pData->data[attributeValueStartPosition + 1];
-		} else {
-			attribute->value.bValue = pData->data[attributeValueStartPosition + 2];
-		}
+		attribute->value.bsValue[0] = size;
+		memcpy(attribute->value.bsValue + 1, buff, size);
 	} else {
-		ProtocolData unescapedValue;
-		int attributeDataSize = attributeValueEndPosition - attributeValueStartPosition;
-		int unescapeResult = unescape(pData->data + attributeValueStartPosition,
-			attributeDataSize, &unescapedValue);
-		if (unescapeResult != 0) {
-			releaseProtocolData(&unescapedValue);
-
-			return debugErrorDetailAndReturn("assembleProtocolAttributeValue",
-				TUXP_ERROR_FAILED_TO_UNESCAPE, unescapeResult);
-		}
+		char buff[MAX_SIZE_ATTRIBUTE_DATA + 1];
+		int size = viewCopyValue(attributeView, (uint8_t *)buff, MAX_SIZE_ATTRIBUTE_DATA);
+		if (size < 0)
+			return size;
+		buff[size] = '\0';
+
+		// Sized as strlen() sees it, so that releasing the value frees the same size.
+		size = strlen(buff);
+		attribute->value.csValue = tuxpAlloc(sizeof(char) * (size + 1), ALLOCATION_SITE_ATTRIBUTE_VALUE);
+		if(!attribute->value.csValue)
+			return TUXP_ERROR_OUT_OF_MEMEORY;
 
-		if(unescapedValue.dataSize == 1 &&
-				firstByteOfAttribute != FLAG_NOREPLACE) {
-			attribute->dataType = TYPE_RBS;
-			attribute->value.rbsValue = unescapedValue.data[0];
-		} else if (firstByteOfAttribute == FLAG_BYTES_TYPE) {
-			attribute->value.bsValue = malloc(sizeof(uint8_t) * (unescapedValue.dataSize + 1));
-			if(!attribute->value.bsValue) {
-				releaseProtocolData(&unescapedValue);
-				return TUXP_ERROR_OUT_OF_MEMEORY;
-			}
-
-			attribute->dataType = TYPE_BYTES;
-			memcpy(attribute->value.bsValue + 1, unescapedValue.data, unescapedValue.dataSize);
-			attribute->value.bsValue[0] = unescapedValue.dataSize;
-		} else {
-			attribute->value.csValue = malloc(sizeof(char) * (unescapedValue.dataSize + 1));
-			if(!attribute->value.csValue) {
-				releaseProtocolData(&unescapedValue);
-				return TUXP_ERROR_OUT_OF_MEMEORY;
-			}
-
-			attribute->dataType = TYPE_CHARS;
-			memcpy(attribute->value.csValue, unescapedValue.data, unescapedValue.dataSize);
-			attribute->value.csValue[unescapedValue.dataSize] = '\0';
-		}
-		releaseProtocolData(&unescapedValue);
+		memcpy(attribute->value.csValue, buff, size + 1);
 	}
 
 	return 0;
 }
 
 int getAttributesSize(Protocol *protocol) {
-	if (!protocol->attributes)
-		return 0;
-
-	int size = 0;
-	ProtocolAttribute *current = protocol->attributes;
-	while (current) {
-		size++;
-		current = current->next;
-	}
-
-	return size;
+	return protocol->attributesSize;
 }
 
-int doParseProtocol(ProtocolData *pData, Protocol *protocol) {
-	protocol->attributes = NULL;
+int doParseProtocolView(const ProtocolView *view, Protocol *protocol) {
+	initProtocolAttributes(protocol);
 	protocol->text = NULL;
+	protocol->children = NULL;
+	protocol->next = NULL;
+	protocol->name = view->name;
+
+	if (view->attributesSize > MAX_SIZE_ATTRIBUTES)
+		return TUXP_ERROR_TOO_MANY_ATTRIBUTES;
+
+	AttributeViewIterator iterator = viewAttributes(view);
+	AttributeView attributeView;
+	while (viewNextAttribute(&iterator, &attributeView)) {
+		ProtocolAttribute attribute;
+		attribute.name = attributeView.name;
+		if (assembleProtocolAttributeValue(&attributeView, &attribute) != 0)
+			return TUXP_ERROR_FAILED_TO_ASSEMBLE_PROTOCOL_ATTRIBUTE;
 
-	if (!isValidProtocolData(pData))
-		return TUXP_ERROR_NOT_VALID_PROTOCOL;
-
-	// Is a bare protocol data.
-	if (pData->dataSize == 5) {
-		protocol->name.ns[0] = pData->data[1];
-		protocol->name.ns[1] = pData->data[2];
-		protocol->name.localName = pData->data[3];
-
-		return 0;
-	}
-
-	if (pData->dataSize < (MIN_SIZE_PROTOCOL_DATA + 2))
-		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
-
-	uint8_t childrenSize = pData->data[5] & 0x7f;
-	if (childrenSize > 0)
-		return TUXP_ERROR_FEATURE_CHILD_ELEMENT_NOT_IMPLEMENTED;
-
-	ProtocolName name = {
-		{pData->data[1], pData->data[2]},
-		pData->data[3]
-	};
-	protocol->name = name;
-	protocol->attributes = NULL;
-	protocol->text = NULL;
-
-	uint8_t attributeSize = pData->data[4];
-	bool hasText = ((pData->data[5] & 0x80) == 0x80);
-
-	if (attributeSize == 0 && !hasText) {
-		if (pData->dataSize != MIN_SIZE_PROTOCOL_DATA + 2)
-			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
-
-		return 0;
+		addAttributeToProtocol(protocol, &attribute);
 	}
 
-	int position = 5;
-	for (int i = 0; i < attributeSize; i++) {
-		if (position++ >= (pData->dataSize - 1))
-			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
-
-		ProtocolAttribute *attribute = malloc(sizeof(ProtocolAttribute));
-		if (!attribute)
+	ChildViewIterator children = viewChildren(view);
+	ProtocolView childView;
+	while (viewNextChild(&children, &childView)) {
+		Protocol *child = appendChild(protocol, childView.name);
+		if (!child)
 			return TUXP_ERROR_OUT_OF_MEMEORY;
 
-		attribute->name = pData->data[position];
-
-		position++;
-		int escapeNumber = 0;
-		int attributeValueEndPosition = findAttributeValueEnd(pData, position, &escapeNumber);
-		if (attributeValueEndPosition <= 0) {
-			free(attribute);
-			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
-		}
-
-		if (assembleProtocolAttributeValue(pData, attribute, position,
-				attributeValueEndPosition, escapeNumber) != 0) {
-			free(attribute);
-			return TUXP_ERROR_FAILED_TO_ASSEMBLE_PROTOCOL_ATTRIBUTE;
-		}
-
-		position = attributeValueEndPosition;
-		addAttributeToProtocol(protocol, attribute);
-	}
-
-	if (!hasText && (position != (pData->dataSize - 1))) {
-		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
+		int result = doParseProtocolView(&childView, child);
+		if (result != 0)
+			return result;
 	}
 
-	if (!hasText)
+	if (view->textPosition < 0)
 		return 0;
 
-	position++;
-	int textDataSize = pData->dataSize - position - 1;
-	ProtocolData textData;
-	int unescapeResult = unescape(pData->data + position, textDataSize, &textData);
-	if (unescapeResult != 0) {
-		releaseProtocolData(&textData);
-		return debugErrorDetailAndReturn("doParseProtocol", TUXP_ERROR_FAILED_TO_UNESCAPE, unescapeResult);
-	}
+	char buff[MAX_SIZE_TEXT_DATA + 1];
+	const char *textData;
+	int textSize = viewGetText(view, buff, MAX_SIZE_TEXT_DATA, &textData);
+	if (textSize < 0)
+		return TUXP_ERROR_TEXT_DATA_TOO_LARGE;
+	if (textData != buff)
+		memcpy(buff, textData, textSize);
+	buff[textSize] = 0;
 
-	char *text = malloc(sizeof(char) * (textDataSize + 1));
+	char *text = tuxpAlloc(sizeof(char) * (strlen(buff) + 1), ALLOCATION_SITE_TEXT);
 	if(!text)
 		return TUXP_ERROR_OUT_OF_MEMEORY;
 
-	memcpy(text, textData.data, textDataSize);
-	*(text + textDataSize) = 0;
-	releaseProtocolData(&textData);
-
+	strcpy(text, buff);
 	protocol->text = text;
 
 	return 0;
@@ -536,7 +524,20 @@ int parseProtocol(ProtocolData *pData, Protocol *protocol) {
 	DEBUG_OUT("enter parseProtocol.");
 #endif
 
-	int result = doParseProtocol(pData, protocol);
+	ProtocolView view;
+	int result = viewProtocol(pData, &view);
+	if (result != 0) {
+		initProtocolAttributes(protocol);
+		protocol->text = NULL;
+		protocol->children = NULL;
+		return result;
+	}
+
+	return parseProtocolView(&view, protocol);
+}
+
+int parseProtocolView(const ProtocolView *view, Protocol *protocol) {
+	int result = doParseProtocolView(view, protocol);
 	if (result != 0) {
 		releaseProtocol(protocol);
 	}
@@ -546,194 +547,124 @@ int parseProtocol(ProtocolData *pData, Protocol *protocol) {
 
 void releaseProtocol(Protocol *protocol) {
 	if (protocol->text) {
-		free(protocol->text);
+		tuxpFree(protocol->text, strlen(protocol->text) + 1);
 		protocol->text = NULL;
 	}
 
-	ProtocolAttribute *last = protocol->attributes;
-	while (last) {
-		if (last->next) {
-			last = last->next;
-		} else {
-			break;
-		}
-	}
-
-	if (!last)
-		return;
-
-	ProtocolAttribute *previous = NULL;
-	while (last) {
-		previous = last->previous;
-
-		if (last->dataType == TYPE_BYTES && last->value.bsValue != NULL) {
-			free(last->value.bsValue);
-		} else if (last->dataType == TYPE_CHARS && last->value.csValue != NULL) {
-			free(last->value.csValue);
+	for (int i = 0; i < protocol->attributesSize; i++) {
+		ProtocolAttribute *attribute = protocol->attributes + i;
+		if ((attribute->dataType == TYPE_BYTES || isSeriesType(attribute->dataType)) &&
+				attribute->value.bsValue != NULL) {
+			tuxpFree(attribute->value.bsValue, attribute->value.bsValue[0] + 1);
+		} else if (attribute->dataType == TYPE_CHARS && attribute->value.csValue != NULL) {
+			tuxpFree(attribute->value.csValue, strlen(attribute->value.csValue) + 1);
 		} else {
 			// NOOP
 		}
-		free(last);
-
-		if (previous)
-			previous->next = NULL;
+	}
 
-		last = previous;
+	Protocol *child = protocol->children;
+	while (child) {
+		Protocol *next = child->next;
+		releaseProtocol(child);
+		deleteChildProtocol(child);
+		child = next;
 	}
+	protocol->children = NULL;
+
+	initProtocolAttributes(protocol);
 }
 
 void releaseProtocolData(ProtocolData *pData) {
 	if (pData->dataSize != 0 && pData->data != NULL) {
-		free(pData->data);
+		tuxpFree(pData->data, pData->dataSize);
 		pData->data = NULL;
 		pData->dataSize = 0;
 	}
 }
 
-int translateProtocol(Protocol *protocol, ProtocolData *pData) {
-	if (getAttributesSize(protocol) > MAX_SIZE_ATTRIBUTES)
-		return debugErrorAndReturn("translateProtocol", TUXP_ERROR_TOO_MANY_ATTRIBUTES);
+static ProtocolFormat protocolFormat = PROTOCOL_FORMAT_ESCAPED;
 
-	// It's a bare protocol.
-	if (getAttributesSize(protocol) == 0 && !protocol->text) {
-		pData->dataSize = MIN_SIZE_PROTOCOL_DATA;
-		pData->data = malloc(sizeof(uint8_t) * MIN_SIZE_PROTOCOL_DATA);
-		if (!pData->data)
-			return TUXP_ERROR_OUT_OF_MEMEORY;
+void setProtocolFormat(ProtocolFormat format) {
+	protocolFormat = format;
+}
 
-		pData->data[0] = 0xff;
-		pData->data[1] = protocol->name.ns[0];
-		pData->data[2] = protocol->name.ns[1];
-		pData->data[3] = protocol->name.localName;
-		pData->data[4] = 0xff;
+ProtocolFormat getProtocolFormat() {
+	return protocolFormat;
+}
 
-		return 0;
+int encodedSizeIn(Protocol *protocol, ProtocolFormat format) {
+	int attributesSize = getAttributesSize(protocol);
+	if (attributesSize > MAX_SIZE_ATTRIBUTES)
+		return TUXP_ERROR_TOO_MANY_ATTRIBUTES;
+
+	// An embedded child has no beginning flag and shares its end flag. In TLV, it has no
+	// TLV flag and its length replaces the one of the frame.
+	int childrenSize = 0;
+	for (Protocol *child = protocol->children; child; child = child->next) {
+		int childSize = encodedSizeIn(child, format);
+		if (childSize < 0)
+			return childSize;
+
+		childrenSize += childSize - (format == PROTOCOL_FORMAT_TLV ? SIZE_TLV_FRAME_PREFIX - 1 : 1);
 	}
 
-	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
-	buff[0] = 0xff;
-	buff[1] = protocol->name.ns[0];
-	buff[2] = protocol->name.ns[1];
-	buff[3] = protocol->name.localName;
-
-	int attributesSize = getAttributesSize(protocol);
-	buff[4] = attributesSize;
-	buff[5] = protocol->text ? 0x80 : 0x00;
+	if (format == PROTOCOL_FORMAT_TLV) {
+		int size = SIZE_TLV_FRAME_PREFIX + 5;
+		for (int i = 0; i < attributesSize; i++)
+			size += encodedAttributeSizeIn(protocol->attributes + i, format);
 
-	int position = 6;
+		if (protocol->text)
+			size += encodedTextSizeIn(protocol->text, format);
 
-	ProtocolAttribute *attribute = protocol->attributes;
-	while (attribute) {
-		if (position >= MAX_SIZE_PROTOCOL_DATA - 1)
-			return debugErrorAndReturn("translateProtocol", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
+		return size + childrenSize;
+	}
 
-		buff[position] = attribute->name;
-		position++;
+	// It's a bare protocol.
+	if (attributesSize == 0 && !protocol->text && !protocol->children)
+		return MIN_SIZE_PROTOCOL_DATA;
 
-		if(position >= MAX_SIZE_PROTOCOL_DATA - 1)
-			return debugErrorAndReturn("translateProtocol", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
-
-		ProtocolData attributeData;
-		int escapeResult = 0;
-		if (attribute->dataType == TYPE_BYTE) {
-			if (isEscapedByte(attribute->value.bValue)) {
-				attributeData.data = malloc(sizeof(uint8_t) * 2);
-				attributeData.data[0] = FLAG_ESCAPE;
-				attributeData.data[1] = attribute->value.bValue;
-				attributeData.dataSize = 2;
-			} else {
-				attributeData.data = malloc(sizeof(uint8_t) * 1);
-				attributeData.data[0] = attribute->value.bValue;
-				attributeData.dataSize = 1;
-			}
-		} else if (attribute->dataType == TYPE_BYTES) {
-			int bsSize = attribute->value.bsValue[0];
-			escapeResult = escape(attribute->value.bsValue + 1, bsSize, &attributeData);
-		} else if (attribute->dataType == TYPE_RBS) {
-			if(isEscapedByte(attribute->value.rbsValue)) {
-				attributeData.data = malloc(sizeof(uint8_t) * 2);
-				attributeData.data[0] = FLAG_ESCAPE;
-				attributeData.data[1] = attribute->value.rbsValue;
-				attributeData.dataSize = 2;
-			} else {
-				attributeData.data = malloc(sizeof(uint8_t) * 1);
-				attributeData.data[0] = attribute->value.rbsValue;
-				attributeData.dataSize = 1;
-			}
-		} else { // attributeDescription->dataType == TYPE_CHARS
-			escapeResult = escape(attribute->value.csValue, strlen(attribute->value.csValue), &attributeData);
-		}
+	int size = 6;
+	for (int i = 0; i < attributesSize; i++)
+		size += encodedAttributeSize(protocol->attributes + i);
 
-		if (escapeResult != 0) {
-			releaseProtocolData(&attributeData);
-			return debugErrorDetailAndReturn("translateProtocol", TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL, escapeResult);
-		} else if (attribute->dataType == TYPE_BYTE) {
-			buff[position] = FLAG_BYTE_TYPE;
-			position++;
-		} else if (attribute->dataType == TYPE_BYTES) {
-			buff[position] = FLAG_BYTES_TYPE;
-			position++;
-		} else {
-			// NOOP
-		}
+	if (protocol->text)
+		size += encodedTextSize(protocol->text) + 1;
 
-		if (position >= MAX_SIZE_PROTOCOL_DATA - 1) {
-			releaseProtocolData(&attributeData);
-			return debugErrorAndReturn("translateProtocol", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
-		}
+	return size + childrenSize;
+}
 
-		if (position + attributeData.dataSize >= MAX_SIZE_PROTOCOL_DATA - 1) {
-			releaseProtocolData(&attributeData);
-			return debugErrorAndReturn("translateProtocol", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
-		}
-		
-		memcpy(buff + position, attributeData.data, attributeData.dataSize);
-		position += attributeData.dataSize;
+int encodedSize(Protocol *protocol) {
+	return encodedSizeIn(protocol, protocolFormat);
+}
 
-		buff[position] = FLAG_UNIT_SPLITTER;
-		position++;
-		
-		if (position >= MAX_SIZE_PROTOCOL_DATA - 1) {
-			releaseProtocolData(&attributeData);
-			return debugErrorAndReturn("translateProtocol", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
-		}
+int translateProtocol(Protocol *protocol, ProtocolData *pData) {
+	pData->data = NULL;
+	pData->dataSize = 0;
 
-		releaseProtocolData(&attributeData);
+	int dataSize = encodedSize(protocol);
+	if (dataSize < 0)
+		return debugErrorAndReturn("translateProtocol", dataSize);
 
-		attribute = attribute->next;
-	}
+	if (dataSize > MAX_SIZE_PROTOCOL_DATA)
+		return debugErrorAndReturn("translateProtocol", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
 
-	if (protocol->text) {
-		int textSize = strlen(protocol->text);
-		if (position + textSize >= MAX_SIZE_PROTOCOL_DATA - 1)
-			return debugErrorAndReturn("translateProtocol", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
+	pData->data = tuxpAlloc(dataSize * sizeof(uint8_t), ALLOCATION_SITE_PROTOCOL_DATA);
+	if (!pData->data)
+		return debugErrorAndReturn("translateProtocol", TUXP_ERROR_OUT_OF_MEMEORY);
 
-		memcpy(buff + position, protocol->text, textSize);
-		position += textSize;
-	}
+	ProtocolWriter writer;
+	writerBeginFormatAt(&writer, protocolFormat, protocol->name, pData->data, dataSize, 0);
 
-	int dataSize;
-	if (buff[position - 1] == FLAG_UNIT_SPLITTER) {
-		buff[position - 1] = FLAG_DOC_BEGINNING_END;
-		dataSize = position;
-	} else {
-		if (position >= MAX_SIZE_PROTOCOL_DATA - 1)
-			return debugErrorAndReturn("translateProtocol", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
+	writerPutProtocol(&writer, protocol);
 
-		buff[position] = FLAG_DOC_BEGINNING_END;
-		dataSize = position + 1;
+	int result = writerEnd(&writer);
+	if (result < 0) {
+		releaseProtocolData(pData);
+		return debugErrorDetailAndReturn("translateProtocol", TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL, result);
 	}
 
-	pData->data = NULL;
-	pData->dataSize = 0;
-
-	pData->data = malloc(dataSize * sizeof(uint8_t));
-	if (!pData->data)
-		return debugErrorAndReturn("translateProtocol", TUXP_ERROR_OUT_OF_MEMEORY);
-
-	memcpy(pData->data, buff, dataSize);
-	pData->dataSize = dataSize;
-
+	pData->dataSize = result;
 	return 0;
 }
 
@@ -744,63 +675,140 @@ int translateAndRelease(Protocol *protocol, ProtocolData *pData) {
 	return result;
 }
 
-int translateLanExecution(TinyId requestId, Protocol *action, ProtocolData *pData) {
-	ProtocolData pDataAction;
-	if (translateProtocol(action, &pDataAction) != 0)
-		return debugErrorAndReturn("translateLanExecution", TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL);
-
-	ProtocolData pDataEscapedTinyId;
-	int escapeResult = escape(requestId, SIZE_THINGS_TINY_ID, &pDataEscapedTinyId);
-	if (escapeResult != 0) {
-		return debugErrorDetailAndReturn("translateLanExecution", TUXP_ERROR_FAILED_TO_ESCAPE, escapeResult);
-	}
+static int limitFrameSize(int buffSize, int headroom) {
+	if (buffSize - headroom > MAX_SIZE_PROTOCOL_DATA)
+		return headroom + MAX_SIZE_PROTOCOL_DATA;
 
-	int pDataActionSize = pDataAction.dataSize - 2;
-	int lanExecutionSize = MIN_SIZE_PROTOCOL_DATA + 3 + pDataEscapedTinyId.dataSize + pDataActionSize;
-	if (lanExecutionSize > MAX_SIZE_PROTOCOL_DATA)
-		return debugErrorAndReturn("translateLanExecution", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
+	return buffSize;
+}
 
-	uint8_t leBuff[MAX_SIZE_PROTOCOL_DATA];
-	int position = 0;
-	memcpy(leBuff, LAN_EXECUTION_PREFIX_BYTES, SIZE_LAN_EXECUTION_PREFIX_BYTES);
-	position += SIZE_LAN_EXECUTION_PREFIX_BYTES;
+static int encodeLanEnvelope(ProtocolFormat format, ProtocolName name, TinyId tinyId, bool ackRequired,
+			Protocol *inner, uint8_t buff[], int buffSize, int headroom) {
+	ProtocolWriter writer;
+	writerBeginFormatAt(&writer, format, name, buff, limitFrameSize(buffSize, headroom), headroom);
+	writerPutBytes(&writer, NAME_ATTRIBUTE_TINY_ID_LAN_PROTOCOL, tinyId, SIZE_THINGS_TINY_ID);
+	if (ackRequired)
+		writerPutRbs(&writer, NAME_ATTRIBUTE_ACK_REQUIRED_LAN_PROTOCOL, 0x02);
+	writerPutChild(&writer, inner);
 
-	leBuff[position] = 0x06;
-	position++;
-	leBuff[position] = FLAG_BYTES_TYPE;
-	position++;
+	return writerEnd(&writer);
+}
 
-	memcpy(leBuff + position, pDataEscapedTinyId.data, pDataEscapedTinyId.dataSize);
-	position += pDataEscapedTinyId.dataSize;
+int encodeLanExecution(TinyId requestId, Protocol *action, uint8_t buff[], int buffSize, int headroom) {
+	return encodeLanEnvelope(protocolFormat, NAME_LAN_EXECUTION, requestId, false, action,
+		buff, buffSize, headroom);
+}
 
-	leBuff[position] = FLAG_UNIT_SPLITTER;
-	position++;
+int encodeLanNotification(TinyId requestId, Protocol *event, bool ackRequired,
+			uint8_t buff[], int buffSize, int headroom) {
+	return encodeLanEnvelope(protocolFormat, NAME_LAN_NOTIFICATION, requestId, ackRequired, event,
+		buff, buffSize, headroom);
+}
 
-	memcpy(leBuff + position, pDataAction.data + 1, pDataAction.dataSize - 2);
-	position += pDataAction.dataSize - 2;
+int encodeLanReport(TinyId requestId, Protocol *data, bool ackRequired,
+			uint8_t buff[], int buffSize, int headroom) {
+	return encodeLanEnvelope(protocolFormat, NAME_LAN_REPORT, requestId, ackRequired, data,
+		buff, buffSize, headroom);
+}
 
-	leBuff[position] = FLAG_DOC_BEGINNING_END;
-	
-	pData->data = malloc(sizeof(uint8_t) * (position + 1));
+int beginLanReportBatch(ProtocolWriter *writer, TinyId requestId, bool ackRequired,
+			uint8_t buff[], int buffSize, int headroom) {
+	writerBeginFormatAt(writer, protocolFormat, NAME_LAN_REPORT, buff, limitFrameSize(buffSize, headroom),
+		headroom);
+	writerPutBytes(writer, NAME_ATTRIBUTE_TINY_ID_LAN_PROTOCOL, requestId, SIZE_THINGS_TINY_ID);
+	if (ackRequired)
+		writerPutRbs(writer, NAME_ATTRIBUTE_ACK_REQUIRED_LAN_PROTOCOL, 0x02);
+
+	return writer->error;
+}
+
+int addLanReportSample(ProtocolWriter *writer, Protocol *data) {
+	if (writer->error != 0)
+		return writer->error;
+
+	int size = encodedSizeIn(data, writer->format);
+	if (size < 0)
+		return size;
+
+	// A sample which doesn't fit leaves the batch untouched, so it can still be ended and sent.
+	size -= writer->format == PROTOCOL_FORMAT_TLV ? SIZE_TLV_FRAME_PREFIX - 1 : 1;
+	if (writer->position + size > writer->buffSize)
+		return TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE;
+
+	return writerPutChild(writer, data);
+}
+
+// Encodes in the given format whatever the current one is. An answer carries no inner protocol.
+int encodeLanEnvelopeIn(ProtocolFormat format, LanEnvelopeType type, TinyId tinyId, bool ackRequired,
+			Protocol *inner, uint8_t buff[], int buffSize, int headroom) {
+	ProtocolName name;
+	if (type == LAN_ENVELOPE_EXECUTION) {
+		name = NAME_LAN_EXECUTION;
+	} else if (type == LAN_ENVELOPE_NOTIFICATION) {
+		name = NAME_LAN_NOTIFICATION;
+	} else if (type == LAN_ENVELOPE_REPORT) {
+		name = NAME_LAN_REPORT;
+	} else {
+		return TUXP_ERROR_NOT_VALID_PROTOCOL;
+	}
+
+	return encodeLanEnvelope(format, name, tinyId, ackRequired, inner, buff, buffSize, headroom);
+}
+
+int encodeLanAnswer(LanAnswer *answer, uint8_t buff[], int buffSize, int headroom) {
+	bool isError = isErrorTinyId(answer->traceId);
+	if (!isError && !isResponseTinyId(answer->traceId))
+		return TUXP_ERROR_UNKNOWN_ANSWER_TINY_ID_TYPE;
+
+	ProtocolWriter writer;
+	writerBeginFormatAt(&writer, protocolFormat, NAME_LAN_ANSWER, buff, limitFrameSize(buffSize, headroom),
+		headroom);
+	writerPutBytes(&writer, NAME_ATTRIBUTE_TINY_ID_LAN_PROTOCOL, answer->traceId, SIZE_THINGS_TINY_ID);
+	if (isError)
+		writerPutInt(&writer, NAME_ATTRIBUTE_ERROR_NUMBER_LAN_ANSWER, answer->errorNumber);
+
+	return writerEnd(&writer);
+}
+
+static int copyEncodedData(uint8_t buff[], int size, ProtocolData *pData) {
+	pData->data = tuxpAlloc(sizeof(uint8_t) * size, ALLOCATION_SITE_PROTOCOL_DATA);
 	if (!pData->data)
 		return TUXP_ERROR_OUT_OF_MEMEORY;
 
-	memcpy(pData->data, leBuff, (position + 1));
-	pData->dataSize = position + 1;
+	memcpy(pData->data, buff, size);
+	pData->dataSize = size;
 
 	return 0;
 }
 
+int translateLanExecution(TinyId requestId, Protocol *action, ProtocolData *pData) {
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeLanExecution(requestId, action, buff, MAX_SIZE_PROTOCOL_DATA, 0);
+	if (size < 0)
+		return debugErrorDetailAndReturn("translateLanExecution", TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL, size);
+
+	return copyEncodedData(buff, size, pData);
+}
+
 ProtocolAttribute *getAttributeByName(Protocol *protocol, uint8_t name) {
-	ProtocolAttribute *attribute = protocol->attributes;
-	while(attribute) {
-		if (attribute->name == name)
-			return attribute;
+	uint8_t slot = findAttributeSlot(protocol, name);
+	if (protocol->attributeSlots[slot] == 0)
+		return NULL;
 
-		attribute = attribute->next;
+	return protocol->attributes + (protocol->attributeSlots[slot] - 1);
+}
+
+// Returns the number type of the attribute, converting it the first time.
+static uint8_t convertNumber(ProtocolAttribute *attribute) {
+	if (attribute->numberType == NUMBER_INT) {
+		attribute->number.iValue = parseDecimalInt(attribute->value.csValue);
+		attribute->numberType |= NUMBER_CONVERTED;
+	} else if (attribute->numberType == NUMBER_FLOAT) {
+		attribute->number.fValue = parseDecimalFloat(attribute->value.csValue);
+		attribute->numberType |= NUMBER_CONVERTED;
 	}
 
-	return NULL;
+	return attribute->numberType & ~NUMBER_CONVERTED;
 }
 
 bool getIntAttributeValue(Protocol *protocol, uint8_t name, int *value) {
@@ -808,10 +816,19 @@ bool getIntAttributeValue(Protocol *protocol, uint8_t name, int *value) {
 	if (!attribute)
 		return false;
 
+	if (attribute->dataType == TYPE_VARINT) {
+		*value = attribute->value.iValue;
+		return true;
+	}
+
 	if(attribute->dataType != TYPE_CHARS)
 		return false;
 
-	*value = atoi(attribute->value.csValue);
+	if (convertNumber(attribute) == NUMBER_INT)
+		*value = attribute->number.iValue;
+	else
+		*value = parseDecimalInt(attribute->value.csValue);
+
 	return true;
 }
 
@@ -854,10 +871,52 @@ bool getFloatAttributeValue(Protocol *protocol, uint8_t name, float *value) {
 	if(!attribute)
 		return false;
 
+	if (attribute->dataType == TYPE_FLOAT16 || attribute->dataType == TYPE_FLOAT32) {
+		*value = attribute->value.fValue;
+		return true;
+	}
+
+	if (attribute->dataType == TYPE_VARINT) {
+		*value = attribute->value.iValue;
+		return true;
+	}
+
 	if(attribute->dataType != TYPE_CHARS)
 		return false;
 
-	*value = atof(attribute->value.csValue);
+	uint8_t numberType = convertNumber(attribute);
+	if (numberType == NUMBER_INT)
+		*value = attribute->number.iValue;
+	else if (numberType == NUMBER_FLOAT)
+		*value = attribute->number.fValue;
+	else
+		*value = parseDecimalFloat(attribute->value.csValue);
+
+	return true;
+}
+
+// The decoder borrows the series from the protocol, so it's valid until the protocol is released.
+bool getSeriesAttributeValue(Protocol *protocol, uint8_t name, SeriesDecoder *decoder) {
+	ProtocolAttribute *attribute = getAttributeByName(protocol, name);
+	if(!attribute)
+		return false;
+
+	if(!isSeriesType(attribute->dataType))
+		return false;
+
+	seriesBeginDecoding(decoder, attribute->dataType, attribute->value.bsValue + 1, attribute->value.bsValue[0]);
+	return true;
+}
+
+bool getBoolAttributeValue(Protocol *protocol, uint8_t name, int index, bool *value) {
+	ProtocolAttribute *attribute = getAttributeByName(protocol, name);
+	if(!attribute)
+		return false;
+
+	if(attribute->dataType != TYPE_BOOLS || index < 0 || index >= MAX_SIZE_BOOLS)
+		return false;
+
+	*value = (attribute->value.boolsValue >> index) & 1;
 	return true;
 }
 
@@ -884,9 +943,7 @@ bool isLanAnswer(ProtocolData *pData) {
 	if (pData->dataSize < MIN_SIZE_LAN_RESPONSE_DATA)
 		return false;
 
-	return pData->data[1] == 0xf8 &&
-		pData->data[2] == 0x02 &&
-		pData->data[3] == 0x07;
+	return hasName(pData, NAME_LAN_ANSWER);
 }
 
 LanAnswer createLanResonse(TinyId requestId) {
@@ -909,176 +966,142 @@ bool isLanExecution(ProtocolData *pData) {
 	if(!isValidProtocolData(pData))
 		return false;
 
-	return pData->data[1] == 0xf8 &&
-		pData->data[2] == 0x04 &&
-		pData->data[3] == 0x05;
+	return hasName(pData, NAME_LAN_EXECUTION);
 }
 
-int parseLanAnswer(ProtocolData *pData, LanAnswer *answer) {
-	if(!isLanAnswer(pData))
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
+static bool isSameName(ProtocolName name1, ProtocolName name2) {
+	return name1.ns[0] == name2.ns[0] &&
+		name1.ns[1] == name2.ns[1] &&
+		name1.localName == name2.localName;
+}
 
-	int position = SIZE_LAN_ANSWER_PREFIX_BYTES;
-	if (pData->data[position] != 0x06)
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
+static int getLanEnvelopeType(ProtocolName name, LanEnvelopeType *type) {
+	if (isSameName(name, NAME_LAN_EXECUTION)) {
+		*type = LAN_ENVELOPE_EXECUTION;
+	} else if (isSameName(name, NAME_LAN_ANSWER)) {
+		*type = LAN_ENVELOPE_ANSWER;
+	} else if (isSameName(name, NAME_LAN_NOTIFICATION)) {
+		*type = LAN_ENVELOPE_NOTIFICATION;
+	} else if (isSameName(name, NAME_LAN_REPORT)) {
+		*type = LAN_ENVELOPE_REPORT;
+	} else {
+		return TUXP_ERROR_UNKNOWN_PROTOCOL_NAME;
+	}
 
-	position++;
-	if(pData->data[position] != FLAG_BYTES_TYPE)
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
+	return 0;
+}
 
-	position++;
-	int traceIdEndPosition = -1;
-	for (int i = position; i < pData->dataSize; i++) {
-		if (pData->data[i] == FLAG_UNIT_SPLITTER || pData->data[i] == FLAG_DOC_BEGINNING_END) {
-			traceIdEndPosition = i;
-			break;
+int decodeLanEnvelopeView(const ProtocolView *view, LanEnvelope *envelope) {
+	if (getLanEnvelopeType(view->name, &envelope->type) != 0)
+		return TUXP_ERROR_UNKNOWN_PROTOCOL_NAME;
+
+	envelope->view = *view;
+
+	envelope->ackRequired = false;
+	envelope->errorNumber = 0;
+
+	bool hasTinyId = false;
+	bool hasErrorNumber = false;
+	AttributeViewIterator iterator = viewAttributes(view);
+	AttributeView attribute;
+	while (viewNextAttribute(&iterator, &attribute)) {
+		if (attribute.name == NAME_ATTRIBUTE_TINY_ID_LAN_PROTOCOL && attribute.dataType == TYPE_BYTES) {
+			hasTinyId = viewCopyValue(&attribute, envelope->tinyId, SIZE_THINGS_TINY_ID) == SIZE_THINGS_TINY_ID;
+		} else if (attribute.name == NAME_ATTRIBUTE_ACK_REQUIRED_LAN_PROTOCOL) {
+			envelope->ackRequired = true;
+		} else if (attribute.name == NAME_ATTRIBUTE_ERROR_NUMBER_LAN_ANSWER) {
+			hasErrorNumber = true;
+		} else {
+			// NOOP
 		}
 	}
 
-	if (traceIdEndPosition == -1)
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
-
-	ProtocolData traceId;
-	int unescapeResult = unescape(pData->data + position, traceIdEndPosition - position, &traceId);
-	if (unescapeResult != 0)
-		return debugErrorDetailAndReturn("parseLanAnswer", TUXP_ERROR_FAILED_TO_UNESCAPE, unescapeResult);
-
-	if (traceId.dataSize != SIZE_THINGS_TINY_ID)
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_FAILED_TO_UNESCAPE);
-
-	memcpy(answer->traceId, traceId.data, SIZE_THINGS_TINY_ID);
-
-	if (isResponseTinyId(answer->traceId)) {
-		if (pData->data[traceIdEndPosition] != FLAG_DOC_BEGINNING_END)
-			return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
+	if (!hasTinyId)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
 
-		answer->errorNumber = 0;
+	if (envelope->type != LAN_ENVELOPE_ANSWER) {
+		if (viewChild(view, &envelope->inner) != 0)
+			return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
 
 		return 0;
 	}
 
-	if(!isErrorTinyId(answer->traceId))
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_UNKNOWN_ANSWER_TINY_ID_TYPE);
-
-	position = traceIdEndPosition;
-	if(pData->data[position] != FLAG_UNIT_SPLITTER)
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
-
-	if (position + 1 + 1 + 1 > (pData->dataSize - 1))
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
+	if (view->childPosition >= 0)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
 
-	position++;
-	if (pData->data[position] != 0x08)
-		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
+	if (isResponseTinyId(envelope->tinyId))
+		return 0;
 
-	position++;
-	int LengthOfErrorNumber = pData->dataSize - position - 1;
-	char csErrorNumber[8] = {0};
-	memcpy(csErrorNumber, pData->data + position, LengthOfErrorNumber);
-	answer->errorNumber = atoi(csErrorNumber);
+	if (!isErrorTinyId(envelope->tinyId))
+		return TUXP_ERROR_UNKNOWN_ANSWER_TINY_ID_TYPE;
 
-	position += LengthOfErrorNumber;
+	int errorNumber;
+	if (!hasErrorNumber || !viewGetInt(view, NAME_ATTRIBUTE_ERROR_NUMBER_LAN_ANSWER, &errorNumber))
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
 
-	if (pData->data[position] != FLAG_DOC_BEGINNING_END)
-		return debugErrorAndReturn("parseLanAnswer",TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
-	
+	envelope->errorNumber = errorNumber;
 	return 0;
 }
 
-int translateLanResonse(LanAnswer *answer, ProtocolData *pData, ProtocolData *escapedTraceId) {
-	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+int decodeLanEnvelope(ProtocolData *pData, LanEnvelope *envelope) {
+	ProtocolView view;
+	int result = viewProtocol(pData, &view);
+	if (result != 0)
+		return debugErrorDetailAndReturn("decodeLanEnvelope", TUXP_ERROR_MALFORMED_PROTOCOL_DATA, result);
 
-	int position = 0;
-	memcpy(buff, LAN_RESPONSE_PREFIX_BYTES, SIZE_LAN_ANSWER_PREFIX_BYTES);
-	position += SIZE_LAN_ANSWER_PREFIX_BYTES;
+	result = decodeLanEnvelopeView(&view, envelope);
+	if (result != 0)
+		return debugErrorAndReturn("decodeLanEnvelope", result);
 
-	buff[position] = 0x06;
-	position++;
+	return 0;
+}
 
-	buff[position] = FLAG_BYTES_TYPE;
-	position++;
-	memcpy(buff + position, escapedTraceId->data, escapedTraceId->dataSize);
-	position += escapedTraceId->dataSize;
+int parseLanAnswer(ProtocolData *pData, LanAnswer *answer) {
+	LanEnvelope envelope;
+	int result = decodeLanEnvelope(pData, &envelope);
+	if (result != 0)
+		return result;
 
-	buff[position] = 0xff;
+	if (envelope.type != LAN_ENVELOPE_ANSWER)
+		return debugErrorAndReturn("parseLanAnswer", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
 
-	int dataSize = position + 1;
-	pData->data = malloc(sizeof(uint8_t) * dataSize);
-	if(!pData->data)
-		return debugErrorAndReturn("translateLanResonse", TUXP_ERROR_OUT_OF_MEMEORY);
+	memcpy(answer->traceId, envelope.tinyId, SIZE_THINGS_TINY_ID);
+	answer->errorNumber = envelope.errorNumber;
 
-	memcpy(pData->data, buff, dataSize);
-	pData->dataSize = dataSize;
-	
 	return 0;
 }
 
-int translateLanError(LanAnswer *answer, ProtocolData *pData, ProtocolData *escapedTraceId) {
+int translateLanAnswer(LanAnswer *answer, ProtocolData *pData) {
 	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeLanAnswer(answer, buff, MAX_SIZE_PROTOCOL_DATA, 0);
+	if (size == TUXP_ERROR_UNKNOWN_ANSWER_TINY_ID_TYPE)
+		return debugErrorAndReturn("translateLanAnswer", TUXP_ERROR_UNKNOWN_ANSWER_TINY_ID_TYPE);
 
-	int position = 0;
-	memcpy(buff, LAN_ERROR_PREFIX_BYTES, SIZE_LAN_ANSWER_PREFIX_BYTES);
-	position += SIZE_LAN_ANSWER_PREFIX_BYTES;
-
-	buff[position] = 0x06;
-	position++;
-
-	buff[position] = FLAG_BYTES_TYPE;
-	position++;
-	memcpy(buff + position, escapedTraceId->data, escapedTraceId->dataSize);
-	position += escapedTraceId->dataSize;
-
-	buff[position] = FLAG_UNIT_SPLITTER;
-	position++;
-
-	buff[position] = 0x08;
-	position++;
-
-	char csErrorNumber[8] = {0};
-	itoa(answer->errorNumber, csErrorNumber, 10);
-
-	int lengthOfErrorNumber = strlen(csErrorNumber);
-	memcpy(buff + position, csErrorNumber, lengthOfErrorNumber);
-	position += lengthOfErrorNumber;
-
-	buff[position] = 0xff;
-
-	int dataSize = position + 1;
-	pData->data = malloc(sizeof(uint8_t) * dataSize);
-	if(!pData->data)
-		return debugErrorAndReturn("translateLanError", TUXP_ERROR_OUT_OF_MEMEORY);
-
-	memcpy(pData->data, buff, dataSize);
-	pData->dataSize = dataSize;
+	if (size < 0)
+		return debugErrorDetailAndReturn("translateLanAnswer", TUXP_ERROR_FAILED_TO_TRANSLATE_ANSWER, size);
 
-	return 0;
+	return copyEncodedData(buff, size, pData);
 }
 
-int translateLanAnswer(LanAnswer *answer, ProtocolData *pData) {
-	ProtocolData escapedTraceId = {NULL, 0};
-	int escapeResult = escape(answer->traceId, SIZE_THINGS_TINY_ID, &escapedTraceId);
-	if (escapeResult != 0) {
-		releaseProtocolData(&escapedTraceId);
-		return debugErrorDetailAndReturn("translateLanAnswer", TUXP_ERROR_FAILED_TO_ESCAPE, escapeResult);
-	}
+static int parseLanEnvelopeOf(LanEnvelopeType type, ProtocolData *pData, TinyId tinyId,
+			bool *ackRequired, Protocol *inner) {
+	initProtocolAttributes(inner);
+	inner->text = NULL;
+	inner->children = NULL;
 
-	int result;
-	if (isResponseTinyId(answer->traceId)) {
-		result = translateLanResonse(answer, pData, &escapedTraceId);
-	} else if (isErrorTinyId(answer->traceId)) {
-		result = translateLanError(answer, pData, &escapedTraceId);
-	} else {
-		releaseProtocolData(&escapedTraceId);
-		return debugErrorAndReturn("translateLanAnswer", TUXP_ERROR_UNKNOWN_ANSWER_TINY_ID_TYPE);
-	}
-	releaseProtocolData(&escapedTraceId);
+	LanEnvelope envelope;
+	int result = decodeLanEnvelope(pData, &envelope);
+	if (result != 0)
+		return result;
 
-	if (result != 0) {
-		releaseProtocolData(pData);
-		return debugErrorAndReturn("translateLanAnswer", TUXP_ERROR_FAILED_TO_TRANSLATE_ANSWER);
-	}
+	if (envelope.type != type)
+		return TUXP_ERROR_MALFORMED_PROTOCOL_DATA;
 
-	return 0;
+	memcpy(tinyId, envelope.tinyId, SIZE_THINGS_TINY_ID);
+	if (ackRequired)
+		*ackRequired = envelope.ackRequired;
+
+	return parseProtocolView(&envelope.inner, inner);
 }
 
 int parseLanExecution(ProtocolData *pData, TinyId requestId, Protocol *action) {
@@ -1088,162 +1111,43 @@ int parseLanExecution(ProtocolData *pData, TinyId requestId, Protocol *action) {
 	DEBUG_OUT("enter parseLanExecution.");
 #endif
 
-	if(!isLanExecution(pData) || pData->dataSize < MIN_SIZE_LAN_EXECUTION_DATA)
-		return debugErrorAndReturn("parseLanExecution", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
+	int result = parseLanEnvelopeOf(LAN_ENVELOPE_EXECUTION, pData, requestId, NULL, action);
+	if (result != 0)
+		return debugErrorDetailAndReturn("parseLanExecution", TUXP_ERROR_MALFORMED_PROTOCOL_DATA, result);
 
-	uint8_t attributeSize = pData->data[4];
-	uint8_t childrenSize = pData->data[5] & 0x7f;
-	bool hasText = (pData->data[5] & 0x80) == 0x80;
-
-	if (attributeSize != 1 || childrenSize != 1 || hasText)
-		return debugErrorAndReturn("parseLanExecution", TUXP_ERROR_MALFORMED_PROTOCOL_DATA);
+	return 0;
+}
 
-	int requestIdStartPosition = 1 + 5 + 1 + 1;
-	memcpy(requestId, pData->data + requestIdStartPosition, SIZE_THINGS_TINY_ID);
+int parseLanNotification(ProtocolData *pData, TinyId requestId, bool *ackRequired, Protocol *event) {
+	int result = parseLanEnvelopeOf(LAN_ENVELOPE_NOTIFICATION, pData, requestId, ackRequired, event);
+	if (result != 0)
+		return debugErrorDetailAndReturn("parseLanNotification", TUXP_ERROR_MALFORMED_PROTOCOL_DATA, result);
 
-	int actionStartPosition = requestIdStartPosition + SIZE_THINGS_TINY_ID + 1;
-	uint8_t actionBuff[MAX_SIZE_PROTOCOL_DATA];
-	int actionDataSize = pData->dataSize - actionStartPosition - 1;
-	memcpy(actionBuff + 1, pData->data + actionStartPosition, actionDataSize);
-	actionBuff[0] = 0xff;
-	actionBuff[actionDataSize + 1] = 0xff;
+	return 0;
+}
 
-	ProtocolData pDataAction = {actionBuff, actionDataSize + 2};
-	int parseActionResult = parseProtocol(&pDataAction, action);
-	if(parseActionResult != 0) {
-		releaseProtocol(action);
-		return parseActionResult;
-	}
+int parseLanReport(ProtocolData *pData, TinyId requestId, bool *ackRequired, Protocol *data) {
+	int result = parseLanEnvelopeOf(LAN_ENVELOPE_REPORT, pData, requestId, ackRequired, data);
+	if (result != 0)
+		return debugErrorDetailAndReturn("parseLanReport", TUXP_ERROR_MALFORMED_PROTOCOL_DATA, result);
 
 	return 0;
 }
 
 int translateLanNotification(TinyId requestId, Protocol *event, bool ackRequired, ProtocolData *pData) {
-	ProtocolData pDataEvent;
-	int result = translateProtocol(event, &pDataEvent);
-	if(result != 0) {
-		releaseProtocolData(&pDataEvent);
-		return debugErrorDetailAndReturn("translateLanNotification",
-			TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL, result);
-	}
-
-	ProtocolData pDataEscapedTinyId;
-	int escapeResult = escape(requestId, SIZE_THINGS_TINY_ID, &pDataEscapedTinyId);
-	if(escapeResult != 0) {
-		releaseProtocolData(&pDataEscapedTinyId);
-		return debugErrorDetailAndReturn("translateLanNotification", TUXP_ERROR_FAILED_TO_ESCAPE, escapeResult);
-	}
-
-	int pDataEventSize = pDataEvent.dataSize - 2;
-	int lanNotificationSize = MIN_SIZE_PROTOCOL_DATA + 3 + pDataEscapedTinyId.dataSize + pDataEventSize;
-	if(lanNotificationSize > MAX_SIZE_PROTOCOL_DATA)
-		return debugErrorAndReturn("translateLanNotification", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
-
-	uint8_t lnBuff[MAX_SIZE_PROTOCOL_DATA];
-	int position = 0;
-	memcpy(lnBuff, LAN_NOTIFICATION_PREFIX_BYTES, SIZE_LAN_NOTIFICATION_PREFIX_BYTES);
-	position += SIZE_LAN_NOTIFICATION_PREFIX_BYTES;
-
-	if (ackRequired)
-		lnBuff[4] = 0x02;
-
-	lnBuff[position] = 0x06;
-	position++;
-	lnBuff[position] = FLAG_BYTES_TYPE;
-	position++;
-
-	memcpy(lnBuff + position, pDataEscapedTinyId.data, pDataEscapedTinyId.dataSize);
-	position += pDataEscapedTinyId.dataSize;
-	releaseProtocolData(&pDataEscapedTinyId);
-
-	lnBuff[position] = FLAG_UNIT_SPLITTER;
-	position++;
-
-	if (ackRequired) {
-		lnBuff[position] = 0x01;
-		lnBuff[position] = 0x02;
-		lnBuff[position] = FLAG_UNIT_SPLITTER;
-
-		position += 3;
-	}
-
-	memcpy(lnBuff + position, pDataEvent.data + 1, pDataEvent.dataSize - 2);
-	position += pDataEvent.dataSize - 2;
-	releaseProtocolData(&pDataEvent);
-
-	lnBuff[position] = FLAG_DOC_BEGINNING_END;
-
-	pData->data = malloc(sizeof(uint8_t) * (position + 1));
-	if(!pData->data)
-		return TUXP_ERROR_OUT_OF_MEMEORY;
-
-	memcpy(pData->data, lnBuff, (position + 1));
-	pData->dataSize = position + 1;
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeLanNotification(requestId, event, ackRequired, buff, MAX_SIZE_PROTOCOL_DATA, 0);
+	if (size < 0)
+		return debugErrorDetailAndReturn("translateLanNotification", TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL, size);
 
-	return 0;
+	return copyEncodedData(buff, size, pData);
 }
 
 int translateLanReport(TinyId requestId, Protocol *data, bool ackRequired, ProtocolData *pData) {
-	ProtocolData pDataData;
-	int result = translateProtocol(data, &pDataData);
-	if(result != 0) {
-		releaseProtocolData(&pDataData);
-		return debugErrorDetailAndReturn("translateLanReport",
-			TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL, result);
-	}
-
-	ProtocolData pDataEscapedTinyId;
-	int escapeResult = escape(requestId, SIZE_THINGS_TINY_ID, &pDataEscapedTinyId);
-	if(escapeResult != 0) {
-		releaseProtocolData(&pDataEscapedTinyId);
-		return debugErrorDetailAndReturn("translateLanReport", TUXP_ERROR_FAILED_TO_ESCAPE, escapeResult);
-	}
-
-	int pDataDataSize = pDataData.dataSize - 2;
-	int lanReportSize = MIN_SIZE_PROTOCOL_DATA + 3 + pDataEscapedTinyId.dataSize + pDataDataSize;
-	if(lanReportSize > MAX_SIZE_PROTOCOL_DATA)
-		return debugErrorAndReturn("translateLanReport", TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE);
-
-	uint8_t lrBuff[MAX_SIZE_PROTOCOL_DATA];
-	int position = 0;
-	memcpy(lrBuff, LAN_REPORT_PREFIX_BYTES, SIZE_LAN_REPORT_PREFIX_BYTES);
-	position += SIZE_LAN_REPORT_PREFIX_BYTES;
-
-	if(ackRequired)
-		lrBuff[4] = 0x02;
-
-	lrBuff[position] = 0x06;
-	position++;
-	lrBuff[position] = FLAG_BYTES_TYPE;
-	position++;
-
-	memcpy(lrBuff + position, pDataEscapedTinyId.data, pDataEscapedTinyId.dataSize);
-	position += pDataEscapedTinyId.dataSize;
-	releaseProtocolData(&pDataEscapedTinyId);
-
-	lrBuff[position] = FLAG_UNIT_SPLITTER;
-	position++;
-
-	if(ackRequired) {
-		lrBuff[position] = 0x01;
-		lrBuff[position] = 0x02;
-		lrBuff[position] = FLAG_UNIT_SPLITTER;
-
-		position += 3;
-	}
-
-	memcpy(lrBuff + position, pDataData.data + 1, pDataData.dataSize - 2);
-	position += pDataData.dataSize - 2;
-	releaseProtocolData(&pDataData);
-
-	lrBuff[position] = FLAG_DOC_BEGINNING_END;
-
-	pData->data = malloc(sizeof(uint8_t) * (position + 1));
-	if(!pData->data)
-		return TUXP_ERROR_OUT_OF_MEMEORY;
-
-	memcpy(pData->data, lrBuff, (position + 1));
-	pData->dataSize = position + 1;
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeLanReport(requestId, data, ackRequired, buff, MAX_SIZE_PROTOCOL_DATA, 0);
+	if (size < 0)
+		return debugErrorDetailAndReturn("translateLanReport", TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL, size);
 
-	return 0;
+	return copyEncodedData(buff, size, pData);
 }
@@ -3,6 +3,9 @@
 
 #include "things_tiny_id.h"
 #include "protocols.h"
+#include "protocol_view.h"
+#include "protocol_writer.h"
+#include "series.h"
 
 #define TUXP_ERROR_NOT_VALID_PROTOCOL -1
 #define TUXP_ERROR_UNKNOWN_PROTOCOL_NAME -2
@@ -29,6 +32,13 @@
 #define TUXP_ERROR_WAITING_DATA -23
 #define TUXP_ERROR_FAILED_TO_TRANSLATE_ANSWER -24
 #define TUXP_ERROR_UNKNOWN_ANSWER_TINY_ID_TYPE -25
+#define TUXP_ERROR_NO_SUCH_ATTRIBUTE -26
+#define TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH -27
+#define TUXP_ERROR_FRAGMENTED_DATA_TOO_LARGE -28
+#define TUXP_ERROR_FRAGMENT_MISMATCH -29
+#define TUXP_ERROR_TOO_MANY_CHILDREN -30
+#define TUXP_ERROR_UNKNOWN_COMPRESSION_RULE -31
+#define TUXP_ERROR_RESERVED_PROTOCOL_NAME -32
 
 #define FLAG_DOC_BEGINNING_END 0xff
 #define FLAG_UNIT_SPLITTER 0xfe
@@ -36,26 +46,52 @@
 #define FLAG_NOREPLACE 0xfc
 #define FLAG_BYTES_TYPE 0xfb
 #define FLAG_BYTE_TYPE 0xfa
+#define FLAG_TLV_FRAME 0xfc
+#define FLAG_COMPRESSED_FRAME 0xfb
+
+#define SIZE_TLV_FRAME_PREFIX 3
 
 #define MAX_SIZE_PROTOCOL_DATA 64
 #define MAX_SIZE_ATTRIBUTE_DATA 16
 #define MAX_SIZE_TEXT_DATA 32
-#define MAX_SIZE_ATTRIBUTES 8
+#define MAX_SIZE_CHILDREN 0x7f
+#define MAX_DEPTH_CHILDREN 4
 
 typedef struct {
 	TinyId traceId;
 	int8_t errorNumber;
 } LanAnswer;
 
+typedef enum {
+	LAN_ENVELOPE_EXECUTION,
+	LAN_ENVELOPE_ANSWER,
+	LAN_ENVELOPE_NOTIFICATION,
+	LAN_ENVELOPE_REPORT
+} LanEnvelopeType;
+
+typedef struct {
+	LanEnvelopeType type;
+	TinyId tinyId;
+	bool ackRequired;
+	int8_t errorNumber;
+	ProtocolView inner;
+	// A batched report carries more inner protocols. Walk them with viewChildren(&view).
+	ProtocolView view;
+} LanEnvelope;
+
 static const ProtocolName NAME_TUXP_PROTOCOL_INTRODUCTION = {{0xf8, 0x03}, 0x00};
 #define NAME_ATTRIBUTE_THING_ID_TUXP_PROTOCOL_INTRODUCTION 0x01
 #define NAME_ATTRIBUTE_ADDRESS_TUXP_PROTOCOL_INTRODUCTION 0x02
+#define NAME_ATTRIBUTE_PROTOCOL_FORMAT_TUXP_PROTOCOL_INTRODUCTION 0x03
+#define NAME_ATTRIBUTE_HEADER_COMPRESSION_TUXP_PROTOCOL_INTRODUCTION 0x04
 
 static const ProtocolName NAME_TUXP_PROTOCOL_ALLOCATION = {{0xf8, 0x03}, 0x03};
 #define NAME_ATTRIBUTE_UPLINK_CHANNEL_BEGIN_TUXP_PROTOCOL_ALLOCATION 0x04
 #define NAME_ATTRIBUTE_UPLINK_CHANNEL_END_TUXP_PROTOCOL_ALLOCATION 0x05
 #define NAME_ATTRIBUTE_UPLINK_ADDRESS_TUXP_PROTOCOL_ALLOCATION 0x06
 #define NAME_ATTRIBUTE_ALLOCATED_ADDRESS_TUXP_PROTOCOL_ALLOCATION 0x07
+#define NAME_ATTRIBUTE_PROTOCOL_FORMAT_TUXP_PROTOCOL_ALLOCATION 0x08
+#define NAME_ATTRIBUTE_COMPRESSION_RULES_TUXP_PROTOCOL_ALLOCATION 0x09
 
 static const ProtocolName NAME_TUXP_PROTOCOL_ALLOCATED = {{0xf8, 0x03}, 0x08};
 static const ProtocolName NAME_TUXP_PROTOCOL_CONFIGURED = {{0xf8, 0x03}, 0x09};
@@ -73,13 +109,27 @@ int addByteAttribute(Protocol *protocol, uint8_t name, uint8_t bValue);
 int addBytesAttribute(Protocol *protocol, uint8_t name, uint8_t bytes[], int size);
 int addStringAttribute(Protocol *protocol, uint8_t name, char string[]);
 int addRbsAttribute(Protocol *protocol, uint8_t name, uint8_t rbsValue);
+int addVarintAttribute(Protocol *protocol, uint8_t name, int32_t iValue);
+int addFloat16Attribute(Protocol *protocol, uint8_t name, float fValue);
+int addFloat32Attribute(Protocol *protocol, uint8_t name, float fValue);
+int addBoolsAttribute(Protocol *protocol, uint8_t name, bool bools[], int size);
+int addSeriesAttribute(Protocol *protocol, uint8_t name, const SeriesEncoder *encoder);
+int addIntSeriesAttribute(Protocol *protocol, uint8_t name, const int32_t values[], int size);
+int addFloatSeriesAttribute(Protocol *protocol, uint8_t name, const float values[], int size);
 int setText(Protocol *protocol, char *text);
+Protocol *addChild(Protocol *protocol, ProtocolName name);
+int getChildrenSize(Protocol *protocol);
 
 bool isProtocol(ProtocolData *pData, ProtocolName name);
 bool isBareProtocol(ProtocolData *pData, ProtocolName name);
 int parseProtocol(ProtocolData *pData, Protocol *protocol);
+int parseProtocolView(const ProtocolView *view, Protocol *protocol);
 void releaseProtocol(Protocol *protocol);
 void releaseProtocolData(ProtocolData *pData);
+void setProtocolFormat(ProtocolFormat format);
+ProtocolFormat getProtocolFormat();
+int encodedSize(Protocol *protocol);
+int encodedSizeIn(Protocol *protocol, ProtocolFormat format);
 int translateProtocol(Protocol *protocol, ProtocolData *pData);
 int translateAndRelease(Protocol *protocol, ProtocolData *pData);
 int translateLanExecution(TinyId requestId, Protocol *action, ProtocolData *pData);
@@ -91,6 +141,8 @@ bool getIntAttributeValue(Protocol *protocol, uint8_t name, int *value);
 char *getStringAttributeValue(Protocol *protocol, uint8_t name);
 bool getFloatAttributeValue(Protocol *protocol, uint8_t name, float *value);
 bool getRbsAttributeValue(Protocol *protocol, uint8_t name, uint8_t *value);
+bool getBoolAttributeValue(Protocol *protocol, uint8_t name, int index, bool *value);
+bool getSeriesAttributeValue(Protocol *protocol, uint8_t name, SeriesDecoder *decoder);
 char *getText(Protocol *protocol);
 
 bool isLanAnswer(ProtocolData *pData);
@@ -104,5 +156,21 @@ int parseLanExecution(ProtocolData *pData, TinyId requestId, Protocol *action);
 int parseProtocol(ProtocolData *pData, Protocol *protocol);
 int translateLanNotification(TinyId requestId, Protocol *event, bool ackRequired, ProtocolData *pData);
 int translateLanReport(TinyId requestId, Protocol *data, bool ackRequired, ProtocolData *pData);
+int parseLanNotification(ProtocolData *pData, TinyId requestId, bool *ackRequired, Protocol *event);
+int parseLanReport(ProtocolData *pData, TinyId requestId, bool *ackRequired, Protocol *data);
+int decodeLanEnvelope(ProtocolData *pData, LanEnvelope *envelope);
+int decodeLanEnvelopeView(const ProtocolView *view, LanEnvelope *envelope);
+
+int encodeLanExecution(TinyId requestId, Protocol *action, uint8_t buff[], int buffSize, int headroom);
+int encodeLanAnswer(LanAnswer *answer, uint8_t buff[], int buffSize, int headroom);
+int encodeLanEnvelopeIn(ProtocolFormat format, LanEnvelopeType type, TinyId tinyId, bool ackRequired,
+	Protocol *inner, uint8_t buff[], int buffSize, int headroom);
+int encodeLanNotification(TinyId requestId, Protocol *event, bool ackRequired,
+	uint8_t buff[], int buffSize, int headroom);
+int encodeLanReport(TinyId requestId, Protocol *data, bool ackRequired,
+	uint8_t buff[], int buffSize, int headroom);
+int beginLanReportBatch(ProtocolWriter *writer, TinyId requestId, bool ackRequired,
+	uint8_t buff[], int buffSize, int headroom);
+int addLanReportSample(ProtocolWriter *writer, Protocol *data);
 
 #endif
@@ -0,0 +1,339 @@
+#ifndef MUD_TUXP_MESSAGE_HPP
+#define MUD_TUXP_MESSAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <tuple>
+#include <utility>
+#include <array>
+
+#if __has_include(<span>)
+#include <span>
+#endif
+
+extern "C" {
+#include "tuxp.h"
+#include "protocol_schema.h"
+}
+
+// Typed messages for C++17 code, such as gateways and host tools:
+//
+//	using Flash = tuxp::Message<tuxp::Name<0xf7, 0x01, 0x00>,
+//		tuxp::Attr<0x01, int>, tuxp::Attr<0x02, tuxp::bytes<3>>>;
+//
+//	Flash flash;
+//	flash.get<0x01>() = 5;
+//	int size = flash.encode(buff);
+//
+// The worst case size of a message is known at compile time, and a message which may not
+// fit in a frame doesn't compile. Attributes are encoded as the protocol schemas of the C
+// library encode them, so C and C++ ends read each other's frames.
+namespace tuxp {
+
+#if defined(__cpp_lib_span) && __cpp_lib_span >= 202002L
+template <typename T>
+using Span = std::span<T>;
+#else
+// Stands in for std::span before C++20.
+template <typename T>
+class Span {
+public:
+	constexpr Span() : pointer(nullptr), length(0) {}
+	constexpr Span(T *data, std::size_t size) : pointer(data), length(size) {}
+
+	template <std::size_t N>
+	constexpr Span(T (&array)[N]) : pointer(array), length(N) {}
+
+	template <typename U, std::size_t N, typename = std::enable_if_t<std::is_convertible_v<U (*)[], T (*)[]>>>
+	constexpr Span(std::array<U, N> &array) : pointer(array.data()), length(N) {}
+
+	template <typename U, std::size_t N, typename = std::enable_if_t<std::is_convertible_v<const U (*)[], T (*)[]>>>
+	constexpr Span(const std::array<U, N> &array) : pointer(array.data()), length(N) {}
+
+	constexpr T *data() const { return pointer; }
+	constexpr std::size_t size() const { return length; }
+
+private:
+	T *pointer;
+	std::size_t length;
+};
+#endif
+
+template <uint8_t Ns0, uint8_t Ns1, uint8_t LocalName>
+struct Name {
+	static constexpr ProtocolName value() { return ProtocolName{{Ns0, Ns1}, LocalName}; }
+};
+
+// Value types beside int, float and uint8_t, which go as chars, chars and a byte.
+struct rbs { uint8_t value; };
+struct varint { int32_t value; };
+struct float16 { float value; };
+struct float32 { float value; };
+
+template <std::size_t N>
+struct chars {
+	static_assert(N <= MAX_SIZE_ATTRIBUTE_DATA, "chars are longer than MAX_SIZE_ATTRIBUTE_DATA");
+	char value[N + 1];
+};
+
+template <std::size_t N>
+struct bytes {
+	static_assert(N <= MAX_SIZE_ATTRIBUTE_DATA, "bytes are longer than MAX_SIZE_ATTRIBUTE_DATA");
+	uint8_t size;
+	uint8_t data[N];
+};
+
+// Specialised per value type. maxSize is the most bytes the value takes in either format.
+template <typename T>
+struct AttributeCodec;
+
+template <>
+struct AttributeCodec<int> {
+	static constexpr int maxSize = SCHEMA_MAX_SIZE_INT;
+	static int put(ProtocolWriter *writer, uint8_t name, int value) { return SCHEMA_PUT_INT(writer, name, value); }
+	static int decode(const AttributeView *attribute, int *value) {
+		int32_t iValue;
+		int result = schemaDecodeInt(attribute, &iValue);
+		if (result == 0)
+			*value = iValue;
+
+		return result;
+	}
+};
+
+template <>
+struct AttributeCodec<float> {
+	static constexpr int maxSize = SCHEMA_MAX_SIZE_FLOAT;
+	static int put(ProtocolWriter *writer, uint8_t name, float value) { return SCHEMA_PUT_FLOAT(writer, name, value); }
+	static int decode(const AttributeView *attribute, float *value) { return schemaDecodeFloat(attribute, value); }
+};
+
+template <>
+struct AttributeCodec<uint8_t> {
+	static constexpr int maxSize = SCHEMA_MAX_SIZE_BYTE;
+	static int put(ProtocolWriter *writer, uint8_t name, uint8_t value) { return writerPutByte(writer, name, value); }
+	static int decode(const AttributeView *attribute, uint8_t *value) {
+		return schemaDecodeByte(attribute, TYPE_BYTE, value);
+	}
+};
+
+template <>
+struct AttributeCodec<rbs> {
+	static constexpr int maxSize = SCHEMA_MAX_SIZE_RBS;
+	static int put(ProtocolWriter *writer, uint8_t name, rbs value) { return writerPutRbs(writer, name, value.value); }
+	static int decode(const AttributeView *attribute, rbs *value) {
+		return schemaDecodeByte(attribute, TYPE_RBS, &value->value);
+	}
+};
+
+template <>
+struct AttributeCodec<varint> {
+	static constexpr int maxSize = SCHEMA_MAX_SIZE_VARINT;
+	static int put(ProtocolWriter *writer, uint8_t name, varint value) {
+		return writerPutVarint(writer, name, value.value);
+	}
+	static int decode(const AttributeView *attribute, varint *value) { return schemaDecodeInt(attribute, &value->value); }
+};
+
+template <>
+struct AttributeCodec<float16> {
+	static constexpr int maxSize = SCHEMA_MAX_SIZE_FLOAT16;
+	static int put(ProtocolWriter *writer, uint8_t name, float16 value) {
+		return writerPutFloat16(writer, name, value.value);
+	}
+	static int decode(const AttributeView *attribute, float16 *value) {
+		return schemaDecodeFloat(attribute, &value->value);
+	}
+};
+
+template <>
+struct AttributeCodec<float32> {
+	static constexpr int maxSize = SCHEMA_MAX_SIZE_FLOAT32;
+	static int put(ProtocolWriter *writer, uint8_t name, float32 value) {
+		return writerPutFloat32(writer, name, value.value);
+	}
+	static int decode(const AttributeView *attribute, float32 *value) {
+		return schemaDecodeFloat(attribute, &value->value);
+	}
+};
+
+template <std::size_t N>
+struct AttributeCodec<chars<N>> {
+	static constexpr int maxSize = N;
+	static int put(ProtocolWriter *writer, uint8_t name, const chars<N> &value) {
+		return writerPutString(writer, name, value.value);
+	}
+	static int decode(const AttributeView *attribute, chars<N> *value) {
+		char buff[MAX_SIZE_ATTRIBUTE_DATA + 1];
+		int result = schemaDecodeString(attribute, buff);
+		if (result != 0)
+			return result;
+
+		if (std::strlen(buff) > N)
+			return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+		std::strcpy(value->value, buff);
+		return 0;
+	}
+};
+
+template <std::size_t N>
+struct AttributeCodec<bytes<N>> {
+	static constexpr int maxSize = 2 + 2 * N;
+	static int put(ProtocolWriter *writer, uint8_t name, const bytes<N> &value) {
+		return writerPutBytes(writer, name, value.data, value.size);
+	}
+	static int decode(const AttributeView *attribute, bytes<N> *value) {
+		SchemaBytes schemaBytes;
+		int result = schemaDecodeBytes(attribute, &schemaBytes);
+		if (result != 0)
+			return result;
+
+		if (schemaBytes.size > N)
+			return TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE;
+
+		value->size = schemaBytes.size;
+		std::memcpy(value->data, schemaBytes.data, schemaBytes.size);
+		return 0;
+	}
+};
+
+template <uint8_t AttributeName, typename T>
+struct Attr {
+	static constexpr uint8_t name = AttributeName;
+	using Type = T;
+	// The name and a splitter, or the name, TLV type and length.
+	static constexpr int maxSize = 3 + AttributeCodec<T>::maxSize;
+
+	T value{};
+	bool present = false;
+};
+
+namespace detail {
+
+template <uint8_t AttributeName, typename... Attrs>
+constexpr std::size_t indexOf() {
+	constexpr bool matches[] = {(Attrs::name == AttributeName)...};
+	for (std::size_t i = 0; i < sizeof...(Attrs); i++) {
+		if (matches[i])
+			return i;
+	}
+
+	return sizeof...(Attrs);
+}
+
+template <typename... Attrs>
+constexpr bool hasUniqueNames() {
+	constexpr uint8_t names[] = {Attrs::name...};
+	for (std::size_t i = 0; i < sizeof...(Attrs); i++) {
+		for (std::size_t j = i + 1; j < sizeof...(Attrs); j++) {
+			if (names[i] == names[j])
+				return false;
+		}
+	}
+
+	return true;
+}
+
+}
+
+template <typename ProtocolNameT, typename... Attrs>
+class Message {
+	static_assert(sizeof...(Attrs) > 0, "a message needs attributes");
+	static_assert(detail::hasUniqueNames<Attrs...>(), "attribute names of a message must be unique");
+
+public:
+	// A TLV frame prefix and protocol header, or an escaped header and end flag.
+	static constexpr int maxEncodedSize = SCHEMA_MAX_SIZE_FRAME_HEADER + (Attrs::maxSize + ...);
+	static_assert(maxEncodedSize <= MAX_SIZE_PROTOCOL_DATA, "the message may not fit in MAX_SIZE_PROTOCOL_DATA");
+
+	static constexpr ProtocolName name() { return ProtocolNameT::value(); }
+
+	template <uint8_t AttributeName>
+	auto &get() { return attribute<AttributeName>().value; }
+
+	template <uint8_t AttributeName>
+	const auto &get() const { return attribute<AttributeName>().value; }
+
+	// Whether the attribute was in the last decoded frame.
+	template <uint8_t AttributeName>
+	bool has() const { return attribute<AttributeName>().present; }
+
+	int write(ProtocolWriter *writer) const {
+		std::apply([writer](const auto &... attrs) {
+			(AttributeCodec<typename std::decay_t<decltype(attrs)>::Type>::put(writer,
+				std::decay_t<decltype(attrs)>::name, attrs.value), ...);
+		}, attributes);
+
+		return writer->error;
+	}
+
+	int encode(Span<uint8_t> buff, int headroom = 0) const {
+		ProtocolWriter writer;
+		writerBeginFormatAt(&writer, getProtocolFormat(), name(), buff.data(), (int)buff.size(), headroom);
+		write(&writer);
+
+		return writerEnd(&writer);
+	}
+
+	// Attributes the message doesn't know are skipped. The first of the same name is taken.
+	int decode(const ProtocolView &view) {
+		const ProtocolName expected = name();
+		if (view.name.ns[0] != expected.ns[0] || view.name.ns[1] != expected.ns[1] ||
+				view.name.localName != expected.localName)
+			return TUXP_ERROR_UNKNOWN_PROTOCOL_NAME;
+
+		std::apply([](auto &... attrs) { ((attrs.present = false), ...); }, attributes);
+
+		AttributeViewIterator iterator = viewAttributes(&view);
+		AttributeView attribute;
+		while (viewNextAttribute(&iterator, &attribute)) {
+			int result = std::apply([&attribute](auto &... attrs) {
+				int decoded = 0;
+				((attribute.name == std::decay_t<decltype(attrs)>::name && !attrs.present ?
+					(decoded = AttributeCodec<typename std::decay_t<decltype(attrs)>::Type>::decode(&attribute,
+						&attrs.value), attrs.present = true) : false), ...);
+
+				return decoded;
+			}, attributes);
+
+			if (result != 0)
+				return result;
+		}
+
+		return 0;
+	}
+
+	int decode(Span<const uint8_t> data) {
+		ProtocolData pData = {const_cast<uint8_t *>(data.data()), (int)data.size()};
+		ProtocolView view;
+		int result = viewProtocol(&pData, &view);
+		if (result != 0)
+			return result;
+
+		return decode(view);
+	}
+
+private:
+	template <uint8_t AttributeName>
+	auto &attribute() {
+		constexpr std::size_t index = detail::indexOf<AttributeName, Attrs...>();
+		static_assert(index < sizeof...(Attrs), "no such attribute in the message");
+		return std::get<index>(attributes);
+	}
+
+	template <uint8_t AttributeName>
+	const auto &attribute() const {
+		constexpr std::size_t index = detail::indexOf<AttributeName, Attrs...>();
+		static_assert(index < sizeof...(Attrs), "no such attribute in the message");
+		return std::get<index>(attributes);
+	}
+
+	std::tuple<Attrs...> attributes;
+};
+
+}
+
+#endif
@@ -0,0 +1,111 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "allocator.h"
+
+static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
+
+static long allocatedBytes = 0;
+static bool failAllocations = false;
+
+static void *countingAlloc(size_t size, void *context) {
+	if (failAllocations)
+		return NULL;
+
+	(*(int *)context)++;
+	allocatedBytes += size;
+	return malloc(size);
+}
+
+static void countingFree(void *p, size_t size, void *context) {
+	(*(int *)context)--;
+	allocatedBytes -= size;
+	free(p);
+}
+
+void setUp() {
+	resetAllocationStatistics();
+}
+
+void tearDown() {
+	tuxpSetAllocator(NULL, NULL, NULL);
+	failAllocations = false;
+}
+
+void testAllocationStatistics(void) {
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	TEST_ASSERT_EQUAL_INT(0, addStringAttribute(&protocol, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, "5"));
+	TEST_ASSERT_EQUAL_INT(0, setText(&protocol, "hello"));
+
+	const AllocationStatistics *statistics = getAllocationStatistics();
+	TEST_ASSERT_EQUAL_INT(2 + 6, statistics->liveBytes);
+	TEST_ASSERT_EQUAL_INT(1, statistics->allocations[ALLOCATION_SITE_ATTRIBUTE_VALUE]);
+	TEST_ASSERT_EQUAL_INT(1, statistics->allocations[ALLOCATION_SITE_TEXT]);
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&protocol, &pData));
+	TEST_ASSERT_EQUAL_INT(pData.dataSize, statistics->liveBytes);
+	TEST_ASSERT_EQUAL_INT(2 + 6 + pData.dataSize, statistics->peakBytes);
+	TEST_ASSERT_EQUAL_INT(1, statistics->allocations[ALLOCATION_SITE_PROTOCOL_DATA]);
+
+	Protocol parsed;
+	TEST_ASSERT_EQUAL_INT(0, parseProtocol(&pData, &parsed));
+	releaseProtocol(&parsed);
+	releaseProtocolData(&pData);
+
+	TEST_ASSERT_EQUAL_INT(0, statistics->liveBytes);
+	TEST_ASSERT_EQUAL_INT(2, statistics->allocations[ALLOCATION_SITE_ATTRIBUTE_VALUE]);
+	TEST_ASSERT_EQUAL_INT(2, statistics->allocations[ALLOCATION_SITE_TEXT]);
+	TEST_ASSERT_EQUAL_INT(0, statistics->failedAllocations);
+}
+
+void testPluggableAllocator(void) {
+	int liveAllocations = 0;
+	tuxpSetAllocator(countingAlloc, countingFree, &liveAllocations);
+
+	TinyId requestId = {0x01, 0xfe, 0x03, 0x04, 0x05};
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	addStringAttribute(&protocol, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, "5");
+	TEST_ASSERT_EQUAL_INT(1, liveAllocations);
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateLanExecution(requestId, &protocol, &pData));
+	releaseProtocol(&protocol);
+	TEST_ASSERT_EQUAL_INT(1, liveAllocations);
+	TEST_ASSERT_EQUAL_INT(pData.dataSize, allocatedBytes);
+
+	releaseProtocolData(&pData);
+	TEST_ASSERT_EQUAL_INT(0, liveAllocations);
+	TEST_ASSERT_EQUAL_INT(0, allocatedBytes);
+	TEST_ASSERT_EQUAL_INT(0, getAllocationStatistics()->liveBytes);
+}
+
+void testFailedAllocations(void) {
+	int liveAllocations = 0;
+	tuxpSetAllocator(countingAlloc, countingFree, &liveAllocations);
+	failAllocations = true;
+
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_OUT_OF_MEMEORY, addStringAttribute(&protocol, 0x01, "abc"));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_OUT_OF_MEMEORY, setText(&protocol, "hello"));
+	TEST_ASSERT_EQUAL_INT(0, getAttributesSize(&protocol));
+
+	const AllocationStatistics *statistics = getAllocationStatistics();
+	TEST_ASSERT_EQUAL_INT(2, statistics->failedAllocations);
+	TEST_ASSERT_EQUAL_INT(0, statistics->allocations[ALLOCATION_SITE_ATTRIBUTE_VALUE]);
+	TEST_ASSERT_EQUAL_INT(0, statistics->liveBytes);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testAllocationStatistics);
+	RUN_TEST(testPluggableAllocator);
+	RUN_TEST(testFailedAllocations);
+
+	return UNITY_END();
+}
@@ -0,0 +1,163 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "batch_decoder.h"
+
+static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
+
+void setUp() {}
+
+void tearDown() {}
+
+static int appendReport(uint8_t buff[], int position, TinyId requestId, int repeat, ProtocolFormat format) {
+	Protocol flash = createProtocol(NAME_PROTOCOL_FLASH);
+	addIntAttribute(&flash, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, repeat);
+	addBytesAttribute(&flash, 0x02, requestId, SIZE_THINGS_TINY_ID);
+
+	setProtocolFormat(format);
+	int size = encodeLanReport(requestId, &flash, true, buff + position, MAX_SIZE_PROTOCOL_DATA, 0);
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+	releaseProtocol(&flash);
+
+	TEST_ASSERT_TRUE(size > 0);
+	return position + size;
+}
+
+void testDecodeBatch(void) {
+	uint8_t stream[MAX_SIZE_PROTOCOL_DATA * 8];
+	TinyId requestId1 = {0x01, 0xff, 0x03, 0x04, 0x05};
+	TinyId requestId2 = {0x02, 0x02, 0x03, 0x04, 0xfd};
+
+	// The tail of a frame we joined in the middle.
+	int position = 0;
+	stream[position++] = 0x35;
+	stream[position++] = 0xff;
+
+	position = appendReport(stream, position, requestId1, 5, PROTOCOL_FORMAT_ESCAPED);
+	position = appendReport(stream, position, requestId2, -7, PROTOCOL_FORMAT_TLV);
+
+	uint8_t configured[] = {0xff, 0xf8, 0x03, 0x09, 0xff};
+	memcpy(stream + position, configured, sizeof(configured));
+	position += sizeof(configured);
+
+	uint8_t malformed[] = {0xff, 0xf8, 0x03, 0x09, 0x01, 0xff};
+	memcpy(stream + position, malformed, sizeof(malformed));
+	position += sizeof(malformed);
+
+	int complete = position;
+	position = appendReport(stream, position, requestId1, 9, PROTOCOL_FORMAT_ESCAPED);
+
+	TuxpBatch batch;
+	TEST_ASSERT_EQUAL_INT(3, tuxpDecodeBatch(stream, position - 3, &batch));
+	TEST_ASSERT_EQUAL_INT(1, batch.malformedFrames);
+	TEST_ASSERT_EQUAL_INT(complete, batch.consumed);
+
+	TEST_ASSERT_EQUAL_INT(LAN_ENVELOPE_REPORT, batch.envelopeTypes[0]);
+	TEST_ASSERT_EQUAL_INT(LAN_ENVELOPE_REPORT, batch.envelopeTypes[1]);
+	TEST_ASSERT_EQUAL_INT(BATCH_NO_ENVELOPE, batch.envelopeTypes[2]);
+	TEST_ASSERT_TRUE(batch.ackRequired[1]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(requestId1, batch.tinyIds[0], SIZE_THINGS_TINY_ID);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(requestId2, batch.tinyIds[1], SIZE_THINGS_TINY_ID);
+	TEST_ASSERT_EQUAL_HEX32(0xf70100, batch.names[0]);
+	TEST_ASSERT_EQUAL_HEX32(packProtocolName(NAME_TUXP_PROTOCOL_CONFIGURED), batch.names[2]);
+	TEST_ASSERT_EQUAL_INT(2, batch.frameOffsets[0]);
+
+	TEST_ASSERT_EQUAL_INT(4, batch.attributesSize);
+	TEST_ASSERT_EQUAL_INT(0, batch.attributesSizes[2]);
+
+	int total = 0;
+	for (int frame = 0; frame < batch.framesSize; frame++) {
+		int attribute = batchFindAttribute(&batch, frame, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH);
+		int repeat;
+		if (attribute >= 0 && batchGetInt(&batch, stream, attribute, &repeat))
+			total += repeat;
+	}
+	TEST_ASSERT_EQUAL_INT(-2, total);
+
+	// Escaped values are copied out, TLV values are in place.
+	uint8_t buff[MAX_SIZE_ATTRIBUTE_DATA];
+	int attribute = batchFindAttribute(&batch, 0, 0x02);
+	TEST_ASSERT_EQUAL_INT(1, batch.valueEscapes[attribute]);
+	TEST_ASSERT_EQUAL_INT(SIZE_THINGS_TINY_ID, batchCopyValue(&batch, stream, attribute, buff, sizeof(buff)));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(requestId1, buff, SIZE_THINGS_TINY_ID);
+
+	attribute = batchFindAttribute(&batch, 1, 0x02);
+	TEST_ASSERT_EQUAL_INT(0, batch.valueEscapes[attribute]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(requestId2, stream + batch.valueOffsets[attribute], SIZE_THINGS_TINY_ID);
+
+	// The rest decodes once it's complete.
+	TEST_ASSERT_EQUAL_INT(1, tuxpDecodeBatch(stream + complete, position - complete, &batch));
+	TEST_ASSERT_EQUAL_INT(position - complete, batch.consumed);
+}
+
+void testDecodeBatchStopsWhenFull(void) {
+	uint8_t stream[(MAX_SIZE_BATCH_FRAMES + 2) * 5];
+	uint8_t configured[] = {0xff, 0xf8, 0x03, 0x09, 0xff};
+	for (int i = 0; i < MAX_SIZE_BATCH_FRAMES + 2; i++)
+		memcpy(stream + i * 5, configured, 5);
+
+	TuxpBatch batch;
+	TEST_ASSERT_EQUAL_INT(MAX_SIZE_BATCH_FRAMES, tuxpDecodeBatch(stream, sizeof(stream), &batch));
+	TEST_ASSERT_EQUAL_INT(MAX_SIZE_BATCH_FRAMES * 5, batch.consumed);
+
+	ProtocolName name = unpackProtocolName(batch.names[MAX_SIZE_BATCH_FRAMES - 1]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(&NAME_TUXP_PROTOCOL_CONFIGURED, &name, 3);
+}
+
+void testDecodeBatchedReport(void) {
+	TinyId requestId = {0x01, 0x02, 0x03, 0x04, 0x05};
+	ProtocolFormat formats[] = {PROTOCOL_FORMAT_ESCAPED, PROTOCOL_FORMAT_TLV};
+	for (int i = 0; i < 2; i++) {
+		setProtocolFormat(formats[i]);
+
+		uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+		ProtocolWriter writer;
+		TEST_ASSERT_EQUAL_INT(0, beginLanReportBatch(&writer, requestId, false, buff, sizeof(buff), 0));
+
+		// Samples are added until the frame is full.
+		int samples = 0;
+		while (true) {
+			Protocol flash = createProtocol(NAME_PROTOCOL_FLASH);
+			addIntAttribute(&flash, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, samples);
+			int result = addLanReportSample(&writer, &flash);
+			releaseProtocol(&flash);
+
+			if (result == TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE)
+				break;
+
+			TEST_ASSERT_EQUAL_INT(0, result);
+			samples++;
+		}
+		TEST_ASSERT_TRUE(samples > 1);
+
+		int size = writerEnd(&writer);
+		setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+		TEST_ASSERT_TRUE(size > 0);
+
+		TuxpBatch batch;
+		TEST_ASSERT_EQUAL_INT(samples, tuxpDecodeBatch(buff, size, &batch));
+		TEST_ASSERT_EQUAL_INT(size, batch.consumed);
+		for (int frame = 0; frame < samples; frame++) {
+			TEST_ASSERT_EQUAL_INT(LAN_ENVELOPE_REPORT, batch.envelopeTypes[frame]);
+			TEST_ASSERT_EQUAL_UINT8_ARRAY(requestId, batch.tinyIds[frame], SIZE_THINGS_TINY_ID);
+
+			int repeat;
+			int attribute = batchFindAttribute(&batch, frame, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH);
+			TEST_ASSERT_TRUE(batchGetInt(&batch, buff, attribute, &repeat));
+			TEST_ASSERT_EQUAL_INT(frame, repeat);
+		}
+	}
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testDecodeBatch);
+	RUN_TEST(testDecodeBatchStopsWhenFull);
+	RUN_TEST(testDecodeBatchedReport);
+
+	return UNITY_END();
+}
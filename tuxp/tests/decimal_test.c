@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "decimal.h"
+
+void setUp() {}
+
+void tearDown() {}
+
+void testFormatDecimalInt(void) {
+	int32_t values[] = {0, 1, -1, 9, 10, -10, 12345, -1205, 2147483647, INT32_MIN};
+	for (unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		char expected[MAX_SIZE_DECIMAL_INT];
+		int expectedSize = sprintf(expected, "%ld", (long)values[i]);
+
+		char chars[MAX_SIZE_DECIMAL_INT];
+		TEST_ASSERT_EQUAL_INT(expectedSize, formatDecimalInt(values[i], chars, sizeof(chars)));
+		TEST_ASSERT_EQUAL_STRING(expected, chars);
+	}
+
+	char small[4];
+	TEST_ASSERT_EQUAL_INT(3, formatDecimalInt(-12, small, sizeof(small)));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE, formatDecimalInt(-123, small, sizeof(small)));
+}
+
+void testFormatDecimalFixed(void) {
+	float values[] = {0.0f, 1.0f, -1.0f, 21.5f, -21.37f, 0.001f, -0.001f, 1013.25f, 99.996f, 123456.7f,
+		3.14159265f, -0.0f, 4000000000.0f, 0.125f, -0.125f, 2.5f, 0.5f, 1.5f, 9.5f, 0.9995f};
+	for (unsigned int i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		for (int fractionDigits = 0; fractionDigits <= 6; fractionDigits += 2) {
+			char expected[32];
+			int expectedSize = sprintf(expected, "%.*f", fractionDigits, values[i]);
+
+			char chars[32];
+			TEST_ASSERT_EQUAL_INT(expectedSize, formatDecimalFixed(values[i], fractionDigits, chars, sizeof(chars)));
+			TEST_ASSERT_EQUAL_STRING(expected, chars);
+		}
+	}
+
+	// Exact halves go to the even digit.
+	char chars[32];
+	TEST_ASSERT_EQUAL_INT(4, formatDecimalFixed(0.125f, 2, chars, sizeof(chars)));
+	TEST_ASSERT_EQUAL_STRING("0.12", chars);
+	TEST_ASSERT_EQUAL_INT(5, formatDecimalFixed(-0.125f, 2, chars, sizeof(chars)));
+	TEST_ASSERT_EQUAL_STRING("-0.12", chars);
+	TEST_ASSERT_EQUAL_INT(4, formatDecimalFixed(0.375f, 2, chars, sizeof(chars)));
+	TEST_ASSERT_EQUAL_STRING("0.38", chars);
+	TEST_ASSERT_EQUAL_INT(1, formatDecimalFixed(2.5f, 0, chars, sizeof(chars)));
+	TEST_ASSERT_EQUAL_STRING("2", chars);
+	TEST_ASSERT_EQUAL_INT(1, formatDecimalFixed(0.5f, 0, chars, sizeof(chars)));
+	TEST_ASSERT_EQUAL_STRING("0", chars);
+	TEST_ASSERT_EQUAL_INT(1, formatDecimalFixed(3.5f, 0, chars, sizeof(chars)));
+	TEST_ASSERT_EQUAL_STRING("4", chars);
+
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE, formatDecimalFixed(1e10f, 2, chars, sizeof(chars)));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE, formatDecimalFixed(21.5f, 6, chars, 9));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE,
+		formatDecimalFixed(21.5f, MAX_SIZE_DECIMAL_FRACTION_DIGITS + 1, chars, sizeof(chars)));
+}
+
+void testParseDecimal(void) {
+	const char *ints[] = {"0", "42", "-1205", "+7", "  13", "12abc", "abc", "", "-", "2147483647", "-2147483648"};
+	for (unsigned int i = 0; i < sizeof(ints) / sizeof(ints[0]); i++)
+		TEST_ASSERT_EQUAL_INT32((int32_t)atol(ints[i]), parseDecimalInt(ints[i]));
+
+	const char *floats[] = {"0", "21.5", "-21.37", "0.000123", ".5", "5.", "-2.5e2", "1E-3", "1013.250000",
+		"3.14159265358979", "123456789012", "12abc", "abc", "1e", "-.", "1.5e+3x", "  -7.25"};
+	for (unsigned int i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+		TEST_ASSERT_EQUAL_FLOAT((float)atof(floats[i]), parseDecimalFloat(floats[i]));
+}
+
+void testFloatAttributesAsChars(void) {
+	Protocol protocol = createProtocol((ProtocolName){{0xf7, 0x02}, 0x01});
+	TEST_ASSERT_EQUAL_INT(0, addFloatAttribute(&protocol, 0x01, -21.37f));
+
+	char expected[32];
+	sprintf(expected, "%.*f", SIZE_DECIMAL_FRACTION_DIGITS, -21.37f);
+#ifndef TUXP_NATIVE_NUMBERS
+	TEST_ASSERT_EQUAL_STRING(expected, getStringAttributeValue(&protocol, 0x01));
+#endif
+
+	float value;
+	TEST_ASSERT_TRUE(getFloatAttributeValue(&protocol, 0x01, &value));
+	TEST_ASSERT_EQUAL_FLOAT(-21.37f, value);
+
+	releaseProtocol(&protocol);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testFormatDecimalInt);
+	RUN_TEST(testFormatDecimalFixed);
+	RUN_TEST(testParseDecimal);
+	RUN_TEST(testFloatAttributesAsChars);
+
+	return UNITY_END();
+}
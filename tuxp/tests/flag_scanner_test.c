@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "flag_scanner.h"
+
+static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
+
+void setUp() {}
+
+void tearDown() {}
+
+static int scanReference(const uint8_t data[], int from, int to) {
+	while (from < to && data[from] < MIN_FLAG_BYTE)
+		from++;
+
+	return from;
+}
+
+void testScannersMatchReference(void) {
+	uint8_t data[200];
+	srand(2024);
+
+	for (int round = 0; round < 200; round++) {
+		// Sparse flag bytes, so that whole blocks get skipped.
+		for (int i = 0; i < (int)sizeof(data); i++)
+			data[i] = (rand() % 64) == 0 ? 0xfa + rand() % 6 : rand() % 0xfa;
+
+		int from = rand() % 40;
+		int to = from + rand() % (sizeof(data) - from);
+		for (int position = from; position <= to; position = scanReference(data, position, to) + 1) {
+			int expected = scanReference(data, position, to);
+			TEST_ASSERT_EQUAL_INT(expected, scanFlagByte(data, position, to));
+			TEST_ASSERT_EQUAL_INT(expected, scanFlagBytePortable(data, position, to));
+		}
+	}
+
+	// Every flag byte in every lane.
+	for (int flag = 0xfa; flag <= 0xff; flag++) {
+		for (int lane = 0; lane < 40; lane++) {
+			memset(data, 0xf9, sizeof(data));
+			data[lane] = flag;
+			TEST_ASSERT_EQUAL_INT(lane, scanFlagByte(data, 0, sizeof(data)));
+			TEST_ASSERT_EQUAL_INT(lane, scanFlagBytePortable(data, 0, sizeof(data)));
+		}
+	}
+
+	memset(data, 0xf9, sizeof(data));
+	TEST_ASSERT_EQUAL_INT(sizeof(data), scanFlagByte(data, 0, sizeof(data)));
+	TEST_ASSERT_EQUAL_INT(sizeof(data), scanFlagBytePortable(data, 0, sizeof(data)));
+}
+
+void testEscapeRoundTrip(void) {
+	// An escaped escape flag in front of an escaped flag byte.
+	uint8_t bytes[MAX_SIZE_ATTRIBUTE_DATA] = {0xfd, 0xff, 0x01, 0xfd, 0xfd, 0xfe, 0xfc, 0xfa,
+		0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0xfb};
+
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	ProtocolWriter writer;
+	writerBegin(&writer, NAME_PROTOCOL_FLASH, buff, sizeof(buff));
+	writerPutBytes(&writer, 0x01, bytes, sizeof(bytes));
+	int size = writerEnd(&writer);
+	TEST_ASSERT_TRUE(size > 0);
+
+	ProtocolData pData = {buff, size};
+	ProtocolView view;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+
+	uint8_t valueBuff[MAX_SIZE_ATTRIBUTE_DATA];
+	const uint8_t *value;
+	TEST_ASSERT_EQUAL_INT(sizeof(bytes), viewGetBytes(&view, 0x01, valueBuff, sizeof(valueBuff), &value));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(bytes, value, sizeof(bytes));
+
+	uint8_t small[4];
+	AttributeView attribute;
+	TEST_ASSERT_TRUE(viewGetAttribute(&view, 0x01, &attribute));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE,
+		viewUnescape(attribute.data, attribute.dataSize, small, sizeof(small)));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testScannersMatchReference);
+	RUN_TEST(testEscapeRoundTrip);
+
+	return UNITY_END();
+}
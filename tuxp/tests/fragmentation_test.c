@@ -0,0 +1,170 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "fragmentation.h"
+
+#define SIZE_TEST_DATA 100
+
+static uint8_t testData[SIZE_TEST_DATA];
+
+void setUp() {
+	for (int i = 0; i < SIZE_TEST_DATA; i++)
+		testData[i] = 0xff - i;
+
+	resetReassembly();
+}
+
+void tearDown() {
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+}
+
+static int deliver(FragmentSender *sender, uint8_t sequence, FragmentAck *ack, bool *ackRequired) {
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeFragment(sender, sequence, buff, sizeof(buff), 0);
+	TEST_ASSERT_TRUE(size > 0);
+
+	ProtocolData pData = {buff, size};
+	TEST_ASSERT_TRUE(isFragment(&pData));
+	return receiveFragment(&pData, ack, ackRequired);
+}
+
+static void returnAck(FragmentSender *sender, FragmentAck *ack) {
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeFragmentAck(ack, buff, sizeof(buff), 0);
+	TEST_ASSERT_TRUE(size > 0);
+
+	ProtocolData pData = {buff, size};
+	FragmentAck parsed;
+	TEST_ASSERT_EQUAL_INT(0, parseFragmentAck(&pData, &parsed));
+	TEST_ASSERT_EQUAL_INT(0, processFragmentAck(sender, &parsed));
+}
+
+void testSelectiveRepeat(void) {
+	TinyId tinyId = {0xfd, 0xff, 0x03, 0x04, 0xfa};
+	FragmentSender sender;
+	TEST_ASSERT_EQUAL_INT(0, beginFragmentSending(&sender, tinyId, testData, SIZE_TEST_DATA));
+	TEST_ASSERT_EQUAL_INT(7, sender.total);
+
+	FragmentAck ack;
+	bool ackRequired;
+
+	// Fragments 2 and 5 are lost. Only the last one asks for an ack.
+	for (int sequence = getNextMissingFragment(&sender, 0); sequence >= 0;
+			sequence = getNextMissingFragment(&sender, sequence + 1)) {
+		if (sequence == 2 || sequence == 5)
+			continue;
+
+		TEST_ASSERT_EQUAL_INT(FRAGMENT_ACCEPTED, deliver(&sender, sequence, &ack, &ackRequired));
+		TEST_ASSERT_EQUAL(sequence == 6, ackRequired);
+	}
+	TEST_ASSERT_EQUAL_HEX32(0x5b, ack.receivedFragments);
+
+	int dataSize;
+	TEST_ASSERT_NULL(getReassembledData(tinyId, &dataSize));
+
+	returnAck(&sender, &ack);
+	TEST_ASSERT_FALSE(isFragmentSendingDone(&sender));
+	TEST_ASSERT_EQUAL_INT(2, getNextMissingFragment(&sender, 0));
+	TEST_ASSERT_EQUAL_INT(5, getNextMissingFragment(&sender, 3));
+
+	// The retransmission round asks for an ack on its own last fragment.
+	TEST_ASSERT_EQUAL_INT(FRAGMENT_ACCEPTED, deliver(&sender, 2, &ack, &ackRequired));
+	TEST_ASSERT_FALSE(ackRequired);
+	TEST_ASSERT_EQUAL_INT(FRAGMENTS_REASSEMBLED, deliver(&sender, 5, &ack, &ackRequired));
+	TEST_ASSERT_TRUE(ackRequired);
+
+	const uint8_t *data = getReassembledData(tinyId, &dataSize);
+	TEST_ASSERT_EQUAL_INT(SIZE_TEST_DATA, dataSize);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(testData, data, SIZE_TEST_DATA);
+
+	// The ack got lost. The repeated fragment is acked again but not reassembled again.
+	TEST_ASSERT_EQUAL_INT(FRAGMENT_ACCEPTED, deliver(&sender, 5, &ack, &ackRequired));
+	TEST_ASSERT_TRUE(ackRequired);
+
+	returnAck(&sender, &ack);
+	TEST_ASSERT_TRUE(isFragmentSendingDone(&sender));
+	TEST_ASSERT_EQUAL_INT(-1, getNextMissingFragment(&sender, 0));
+
+	releaseReassembly(tinyId);
+	TEST_ASSERT_NULL(getReassembledData(tinyId, &dataSize));
+}
+
+void testFragmentsFitInAFrame(void) {
+	uint8_t flags[SIZE_FRAGMENT_PAYLOAD * 2];
+	memset(flags, 0xff, sizeof(flags));
+	TinyId tinyId = {0xff, 0xff, 0xff, 0xff, 0xff};
+
+	FragmentSender sender;
+	TEST_ASSERT_EQUAL_INT(0, beginFragmentSending(&sender, tinyId, flags, sizeof(flags)));
+
+	uint8_t buff[SIZE_FRAGMENT_PAYLOAD + MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeFragment(&sender, 0, buff, sizeof(buff), 3);
+	TEST_ASSERT_TRUE(size > 3);
+	TEST_ASSERT_TRUE(size - 3 <= MAX_SIZE_PROTOCOL_DATA);
+
+	setProtocolFormat(PROTOCOL_FORMAT_TLV);
+	FragmentAck ack;
+	bool ackRequired;
+	TEST_ASSERT_EQUAL_INT(FRAGMENT_ACCEPTED, deliver(&sender, 1, &ack, &ackRequired));
+	TEST_ASSERT_TRUE(ackRequired);
+	TEST_ASSERT_EQUAL_HEX32(0x02, ack.receivedFragments);
+}
+
+void testRejectFragments(void) {
+	TinyId tinyId = {0x01, 0x02, 0x03, 0x04, 0x05};
+	uint8_t large[MAX_SIZE_FRAGMENTS * SIZE_FRAGMENT_PAYLOAD + 1];
+	memset(large, 0x41, sizeof(large));
+
+	FragmentSender sender;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_FRAGMENTED_DATA_TOO_LARGE,
+		beginFragmentSending(&sender, tinyId, large, sizeof(large)));
+
+	// More than the reassembly buffers can take.
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_FRAGMENTED_DATA_TOO_LARGE,
+		beginFragmentSending(&sender, tinyId, large, MAX_SIZE_FRAGMENTED_DATA + 1));
+
+	// From a peer which doesn't check it.
+	TEST_ASSERT_EQUAL_INT(0, beginFragmentSending(&sender, tinyId, large, MAX_SIZE_FRAGMENTED_DATA));
+	sender.total++;
+	FragmentAck ack;
+	bool ackRequired;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_FRAGMENTED_DATA_TOO_LARGE, deliver(&sender, 0, &ack, &ackRequired));
+
+	// The same TinyId with another total.
+	TEST_ASSERT_EQUAL_INT(0, beginFragmentSending(&sender, tinyId, testData, SIZE_TEST_DATA));
+	TEST_ASSERT_EQUAL_INT(FRAGMENT_ACCEPTED, deliver(&sender, 0, &ack, &ackRequired));
+	TEST_ASSERT_EQUAL_INT(0, beginFragmentSending(&sender, tinyId, testData, SIZE_FRAGMENT_PAYLOAD));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_FRAGMENT_MISMATCH, deliver(&sender, 0, &ack, &ackRequired));
+
+	FragmentAck otherAck = {{0x05, 0x04, 0x03, 0x02, 0x01}, 1, 0x01};
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_FRAGMENT_MISMATCH, processFragmentAck(&sender, &otherAck));
+}
+
+void testReassemblySlotsAreReused(void) {
+	FragmentSender senders[SIZE_REASSEMBLY_SLOTS + 1];
+	FragmentAck ack;
+	bool ackRequired;
+
+	for (int i = 0; i < SIZE_REASSEMBLY_SLOTS + 1; i++) {
+		TinyId tinyId = {0x01, 0x02, 0x03, 0x04, i};
+		TEST_ASSERT_EQUAL_INT(0, beginFragmentSending(senders + i, tinyId, testData, SIZE_TEST_DATA));
+		TEST_ASSERT_EQUAL_INT(FRAGMENT_ACCEPTED, deliver(senders + i, 0, &ack, &ackRequired));
+	}
+
+	// The quietest transfer was given up and starts over.
+	TEST_ASSERT_EQUAL_INT(FRAGMENT_ACCEPTED, deliver(senders, 1, &ack, &ackRequired));
+	TEST_ASSERT_EQUAL_HEX32(0x02, ack.receivedFragments);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testSelectiveRepeat);
+	RUN_TEST(testFragmentsFitInAFrame);
+	RUN_TEST(testRejectFragments);
+	RUN_TEST(testReassemblySlotsAreReused);
+
+	return UNITY_END();
+}
@@ -0,0 +1,148 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "frame_reassembler.h"
+
+static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
+#define NAME_ATTRIBUTE_ADDRESS_PROTOCOL_FLASH 0x02
+
+static FrameReassembler reassembler;
+
+void setUp() {
+	resetFrameReassembler(&reassembler);
+}
+
+void tearDown() {
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+}
+
+static int translateFlash(int repeat, uint8_t buff[]) {
+	Protocol flash = createProtocol(NAME_PROTOCOL_FLASH);
+	addIntAttribute(&flash, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, repeat);
+	uint8_t address[] = {0xff, 0xfd, 0x1f};
+	addBytesAttribute(&flash, NAME_ATTRIBUTE_ADDRESS_PROTOCOL_FLASH, address, sizeof(address));
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&flash, &pData));
+	memcpy(buff, pData.data, pData.dataSize);
+	int size = pData.dataSize;
+	releaseProtocolData(&pData);
+
+	return size;
+}
+
+// Feeds the stream in chunks of chunkSize and collects the sizes of the frames it gives.
+static int reassembleAll(const uint8_t stream[], int size, int chunkSize, int frameSizes[],
+			uint8_t frames[][MAX_SIZE_PROTOCOL_DATA]) {
+	int framesSize = 0;
+	for (int chunk = 0; chunk < size; chunk += chunkSize) {
+		int chunkEnd = chunk + chunkSize < size ? chunk + chunkSize : size;
+		int position = 0;
+		while (position < chunkEnd - chunk) {
+			int frameSize = reassembleFrame(&reassembler, stream + chunk, chunkEnd - chunk, &position);
+			if (frameSize == 0)
+				break;
+
+			frameSizes[framesSize] = frameSize;
+			if (frameSize > 0)
+				memcpy(frames[framesSize], reassembler.frame, frameSize);
+			framesSize++;
+		}
+	}
+
+	return framesSize;
+}
+
+void testReassembleFramesInAnyChunks(void) {
+	ProtocolFormat formats[] = {PROTOCOL_FORMAT_ESCAPED, PROTOCOL_FORMAT_TLV};
+	for (int i = 0; i < 2; i++) {
+		setProtocolFormat(formats[i]);
+
+		uint8_t stream[MAX_SIZE_PROTOCOL_DATA * 4];
+		int first = translateFlash(5, stream);
+		int second = translateFlash(14, stream + first);
+		int third = translateFlash(-1, stream + first + second);
+		int size = first + second + third;
+
+		int chunkSizes[] = {1, 2, 7, size};
+		for (int j = 0; j < 4; j++) {
+			resetFrameReassembler(&reassembler);
+
+			int frameSizes[4];
+			uint8_t frames[4][MAX_SIZE_PROTOCOL_DATA];
+			TEST_ASSERT_EQUAL_INT(3, reassembleAll(stream, size, chunkSizes[j], frameSizes, frames));
+			TEST_ASSERT_EQUAL_INT(first, frameSizes[0]);
+			TEST_ASSERT_EQUAL_UINT8_ARRAY(stream, frames[0], first);
+			TEST_ASSERT_EQUAL_INT(second, frameSizes[1]);
+			TEST_ASSERT_EQUAL_UINT8_ARRAY(stream + first, frames[1], second);
+			TEST_ASSERT_EQUAL_INT(third, frameSizes[2]);
+			TEST_ASSERT_EQUAL_UINT8_ARRAY(stream + first + second, frames[2], third);
+			TEST_ASSERT_FALSE(isReassemblingFrame(&reassembler));
+		}
+	}
+}
+
+void testResyncAfterNoise(void) {
+	uint8_t stream[MAX_SIZE_PROTOCOL_DATA * 2];
+	// Noise, an escaped flag, the end of a frame we joined in the middle, and the end flag
+	// of another one right before a frame.
+	uint8_t noise[] = {0x31, 0xfd, 0xff, 0x32, 0xfe, 0xff, 0x33, 0xff};
+	memcpy(stream, noise, sizeof(noise));
+	int size = sizeof(noise);
+	int frame = translateFlash(5, stream + size);
+	size += frame;
+
+	int frameSizes[2];
+	uint8_t frames[2][MAX_SIZE_PROTOCOL_DATA];
+	TEST_ASSERT_EQUAL_INT(1, reassembleAll(stream, size, size, frameSizes, frames));
+	TEST_ASSERT_EQUAL_INT(frame, frameSizes[0]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(stream + sizeof(noise), frames[0], frame);
+
+	resetFrameReassembler(&reassembler);
+	uint8_t joined[] = {0x32, 0xff, 0xff};
+	memcpy(stream, joined, sizeof(joined));
+	frame = translateFlash(5, stream + sizeof(joined) - 1);
+	size = sizeof(joined) - 1 + frame;
+	TEST_ASSERT_EQUAL_INT(1, reassembleAll(stream, size, 3, frameSizes, frames));
+	TEST_ASSERT_EQUAL_INT(frame, frameSizes[0]);
+}
+
+void testDropFrameTooLarge(void) {
+	uint8_t stream[MAX_SIZE_PROTOCOL_DATA * 3];
+	stream[0] = FLAG_DOC_BEGINNING_END;
+	memset(stream + 1, 0x41, MAX_SIZE_PROTOCOL_DATA + 10);
+	stream[MAX_SIZE_PROTOCOL_DATA + 11] = FLAG_DOC_BEGINNING_END;
+	int size = MAX_SIZE_PROTOCOL_DATA + 12;
+	int frame = translateFlash(5, stream + size);
+	size += frame;
+
+	int frameSizes[3];
+	uint8_t frames[3][MAX_SIZE_PROTOCOL_DATA];
+	TEST_ASSERT_EQUAL_INT(2, reassembleAll(stream, size, 16, frameSizes, frames));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, frameSizes[0]);
+	TEST_ASSERT_EQUAL_INT(frame, frameSizes[1]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(stream + MAX_SIZE_PROTOCOL_DATA + 12, frames[1], frame);
+
+	// A TLV frame which says it's longer than a frame can be.
+	resetFrameReassembler(&reassembler);
+	uint8_t tooLong[] = {FLAG_DOC_BEGINNING_END, FLAG_TLV_FRAME, 0xff};
+	memcpy(stream, tooLong, sizeof(tooLong));
+	frame = translateFlash(5, stream + sizeof(tooLong));
+	size = sizeof(tooLong) + frame;
+	TEST_ASSERT_EQUAL_INT(2, reassembleAll(stream, size, size, frameSizes, frames));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, frameSizes[0]);
+	TEST_ASSERT_EQUAL_INT(frame, frameSizes[1]);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testReassembleFramesInAnyChunks);
+	RUN_TEST(testResyncAfterNoise);
+	RUN_TEST(testDropFrameTooLarge);
+
+	return UNITY_END();
+}
@@ -0,0 +1,233 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "header_compression.h"
+#include "batch_decoder.h"
+
+static const ProtocolName NAME_PROTOCOL_WEATHER = {{0xf7, 0x02}, 0x01};
+#define NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER 0x01
+#define NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER 0x02
+
+static const ProtocolName NAME_PROTOCOL_ALARM = {{0xf7, 0x02}, 0x02};
+
+void setUp() {}
+
+void tearDown() {}
+
+static Protocol createWeather() {
+	Protocol weather = createProtocol(NAME_PROTOCOL_WEATHER);
+	addVarintAttribute(&weather, NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER, 2153);
+	addVarintAttribute(&weather, NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER, 61);
+
+	return weather;
+}
+
+static void testRoundTrip(ProtocolFormat format, LanEnvelopeType type, bool ackRequired, Protocol *inner) {
+	CompressionContext context;
+	initCompressionContext(&context, format);
+	TEST_ASSERT_EQUAL_INT(0, addCompressionRule(&context, LAN_ENVELOPE_REPORT, true, NAME_PROTOCOL_ALARM));
+	TEST_ASSERT_EQUAL_INT(1, addCompressionRule(&context, type, ackRequired, inner->name));
+
+	// Flag bytes in the TinyId are escaped in an escaped frame.
+	TinyId tinyId = {0x01, 0xff, 0x02, 0xfd, 0x03};
+	uint8_t original[MAX_SIZE_PROTOCOL_DATA];
+	int originalSize = encodeLanEnvelopeIn(format, type, tinyId, ackRequired, inner,
+		original, sizeof(original), 0);
+	TEST_ASSERT_GREATER_THAN(0, originalSize);
+
+	uint8_t frame[MAX_SIZE_PROTOCOL_DATA];
+	memcpy(frame, original, originalSize);
+	int compressedSize = compressFrame(&context, frame, originalSize);
+	TEST_ASSERT_TRUE(isCompressedFrame(frame, compressedSize));
+	TEST_ASSERT_EQUAL_UINT8(1, frame[3]);
+
+	// The envelope name, its attributes and the inner name leave only the TinyId behind.
+	int savedSize = format == PROTOCOL_FORMAT_TLV ? 11 : 8;
+	if (ackRequired)
+		savedSize += format == PROTOCOL_FORMAT_TLV ? 4 : 3;
+	TEST_ASSERT_EQUAL_INT(originalSize - savedSize, compressedSize);
+
+	// Compressing it again changes nothing.
+	TEST_ASSERT_EQUAL_INT(compressedSize, compressFrame(&context, frame, compressedSize));
+
+	uint8_t restored[MAX_SIZE_PROTOCOL_DATA];
+	TEST_ASSERT_EQUAL_INT(originalSize, decompressFrame(&context, frame, compressedSize,
+		restored, sizeof(restored)));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(original, restored, originalSize);
+
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, decompressFrame(&context, frame, compressedSize,
+		restored, originalSize - 1));
+}
+
+void testCompressEscapedFrames(void) {
+	Protocol weather = createWeather();
+	testRoundTrip(PROTOCOL_FORMAT_ESCAPED, LAN_ENVELOPE_REPORT, false, &weather);
+	testRoundTrip(PROTOCOL_FORMAT_ESCAPED, LAN_ENVELOPE_NOTIFICATION, true, &weather);
+	releaseProtocol(&weather);
+
+	Protocol alarm = createProtocol(NAME_PROTOCOL_ALARM);
+	testRoundTrip(PROTOCOL_FORMAT_ESCAPED, LAN_ENVELOPE_EXECUTION, false, &alarm);
+}
+
+void testCompressTlvFrames(void) {
+	Protocol weather = createWeather();
+	testRoundTrip(PROTOCOL_FORMAT_TLV, LAN_ENVELOPE_REPORT, false, &weather);
+	testRoundTrip(PROTOCOL_FORMAT_TLV, LAN_ENVELOPE_NOTIFICATION, true, &weather);
+	releaseProtocol(&weather);
+
+	Protocol alarm = createProtocol(NAME_PROTOCOL_ALARM);
+	testRoundTrip(PROTOCOL_FORMAT_TLV, LAN_ENVELOPE_EXECUTION, false, &alarm);
+}
+
+void testCompressedReport(void) {
+	CompressionContext context;
+	initCompressionContext(&context, PROTOCOL_FORMAT_ESCAPED);
+	TEST_ASSERT_EQUAL_INT(0, addCompressionRule(&context, LAN_ENVELOPE_REPORT, false, NAME_PROTOCOL_WEATHER));
+
+	TinyId tinyId = {0x01, 0x02, 0x03, 0x04, 0x05};
+	Protocol weather = createWeather();
+	uint8_t frame[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeLanReport(tinyId, &weather, false, frame, sizeof(frame), 0);
+	releaseProtocol(&weather);
+
+	uint8_t expected[] = {
+		0xff, 0xfb, 0x13, 0x00,
+			0x01, 0x02, 0x03, 0x04, 0x05,
+			0x02, 0x00,
+				0x01, 0xfd, 0x01, 0xd2, 0x21, 0xfe,
+				0x02, 0xfd, 0x01, 0x7a,
+		0xff
+	};
+	TEST_ASSERT_EQUAL_INT(sizeof(expected), compressFrame(&context, frame, size));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, frame, sizeof(expected));
+}
+
+void testFramesLeftUncompressed(void) {
+	CompressionContext context;
+	initCompressionContext(&context, PROTOCOL_FORMAT_ESCAPED);
+
+	TinyId tinyId = {0x01, 0x02, 0x03, 0x04, 0x05};
+	Protocol weather = createWeather();
+	uint8_t frame[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeLanReport(tinyId, &weather, false, frame, sizeof(frame), 0);
+	uint8_t original[MAX_SIZE_PROTOCOL_DATA];
+	memcpy(original, frame, size);
+
+	// No rules at all.
+	TEST_ASSERT_EQUAL_INT(size, compressFrame(&context, frame, size));
+
+	// Another inner protocol, another envelope and another ack.
+	addCompressionRule(&context, LAN_ENVELOPE_REPORT, false, NAME_PROTOCOL_ALARM);
+	addCompressionRule(&context, LAN_ENVELOPE_NOTIFICATION, false, NAME_PROTOCOL_WEATHER);
+	addCompressionRule(&context, LAN_ENVELOPE_REPORT, true, NAME_PROTOCOL_WEATHER);
+	TEST_ASSERT_EQUAL_INT(size, compressFrame(&context, frame, size));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(original, frame, size);
+
+	// A frame in the other format.
+	initCompressionContext(&context, PROTOCOL_FORMAT_TLV);
+	addCompressionRule(&context, LAN_ENVELOPE_REPORT, false, NAME_PROTOCOL_WEATHER);
+	TEST_ASSERT_EQUAL_INT(size, compressFrame(&context, frame, size));
+
+	// Answers have no inner protocol.
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_NOT_VALID_PROTOCOL,
+		addCompressionRule(&context, LAN_ENVELOPE_ANSWER, false, NAME_PROTOCOL_WEATHER));
+	releaseProtocol(&weather);
+}
+
+void testCompressionRules(void) {
+	CompressionContext context;
+	initCompressionContext(&context, PROTOCOL_FORMAT_ESCAPED);
+	addCompressionRule(&context, LAN_ENVELOPE_REPORT, false, NAME_PROTOCOL_WEATHER);
+	addCompressionRule(&context, LAN_ENVELOPE_NOTIFICATION, true, NAME_PROTOCOL_ALARM);
+
+	uint8_t expected[] = {
+		0x03, 0xf7, 0x02, 0x01,
+		0x82, 0xf7, 0x02, 0x02
+	};
+	uint8_t rules[MAX_SIZE_ATTRIBUTE_DATA];
+	TEST_ASSERT_EQUAL_INT(sizeof(expected), encodeCompressionRules(&context, rules, sizeof(rules)));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, rules, sizeof(expected));
+
+	CompressionContext decoded;
+	initCompressionContext(&decoded, PROTOCOL_FORMAT_ESCAPED);
+	TEST_ASSERT_EQUAL_INT(0, decodeCompressionRules(&decoded, rules, sizeof(expected)));
+	TEST_ASSERT_EQUAL_INT(2, decoded.rulesSize);
+	TEST_ASSERT_EQUAL_INT(LAN_ENVELOPE_NOTIFICATION, decoded.rules[1].envelopeType);
+	TEST_ASSERT_TRUE(decoded.rules[1].ackRequired);
+	TEST_ASSERT_EQUAL_UINT8(0x02, decoded.rules[1].name.localName);
+
+	for (int i = decoded.rulesSize; i < MAX_SIZE_COMPRESSION_RULES; i++)
+		TEST_ASSERT_EQUAL_INT(i, addCompressionRule(&decoded, LAN_ENVELOPE_REPORT, false, NAME_PROTOCOL_ALARM));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE,
+		addCompressionRule(&decoded, LAN_ENVELOPE_REPORT, false, NAME_PROTOCOL_ALARM));
+
+	uint8_t partial[] = {0x03, 0xf7, 0x02};
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, decodeCompressionRules(&decoded, partial,
+		sizeof(partial)));
+
+	uint8_t answer[] = {0x01, 0xf7, 0x02, 0x01};
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, decodeCompressionRules(&decoded, answer,
+		sizeof(answer)));
+	TEST_ASSERT_EQUAL_INT(0, decoded.rulesSize);
+}
+
+void testUnknownCompressionRule(void) {
+	CompressionContext context;
+	initCompressionContext(&context, PROTOCOL_FORMAT_ESCAPED);
+	addCompressionRule(&context, LAN_ENVELOPE_REPORT, false, NAME_PROTOCOL_WEATHER);
+
+	uint8_t frame[] = {0xff, 0xfb, 0x09, 0x01, 0x01, 0x02, 0x03, 0x04, 0x05, 0x00, 0x00, 0xff};
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_UNKNOWN_COMPRESSION_RULE, decompressFrame(&context, frame, sizeof(frame),
+		buff, sizeof(buff)));
+
+	frame[2] = 0x0a;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, decompressFrame(&context, frame, sizeof(frame),
+		buff, sizeof(buff)));
+}
+
+void testBatchOfCompressedFrames(void) {
+	CompressionContext context;
+	initCompressionContext(&context, PROTOCOL_FORMAT_ESCAPED);
+	addCompressionRule(&context, LAN_ENVELOPE_REPORT, false, NAME_PROTOCOL_WEATHER);
+
+	TinyId tinyId = {0x01, 0x02, 0x03, 0x04, 0x05};
+	Protocol weather = createWeather();
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA * 2];
+	int compressedSize = encodeLanReport(tinyId, &weather, false, buff, MAX_SIZE_PROTOCOL_DATA, 0);
+	compressedSize = compressFrame(&context, buff, compressedSize);
+	int size = encodeLanReport(tinyId, &weather, false, buff + compressedSize, MAX_SIZE_PROTOCOL_DATA, 0);
+	releaseProtocol(&weather);
+
+	static TuxpBatch batch;
+	TEST_ASSERT_EQUAL_INT(2, tuxpDecodeBatch(buff, compressedSize + size, &batch));
+	TEST_ASSERT_EQUAL_INT(compressedSize + size, batch.consumed);
+
+	TEST_ASSERT_EQUAL_INT(BATCH_COMPRESSED_FRAME, batch.envelopeTypes[0]);
+	TEST_ASSERT_EQUAL_INT(compressedSize, batch.frameSizes[0]);
+	TEST_ASSERT_EQUAL_INT(0, batch.attributesSizes[0]);
+
+	TEST_ASSERT_EQUAL_INT(LAN_ENVELOPE_REPORT, batch.envelopeTypes[1]);
+	TEST_ASSERT_EQUAL_UINT32(packProtocolName(NAME_PROTOCOL_WEATHER), batch.names[1]);
+
+	uint8_t restored[MAX_SIZE_PROTOCOL_DATA];
+	TEST_ASSERT_EQUAL_INT(size, decompressFrame(&context, buff + batch.frameOffsets[0], batch.frameSizes[0],
+		restored, sizeof(restored)));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(buff + compressedSize, restored, size);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testCompressEscapedFrames);
+	RUN_TEST(testCompressTlvFrames);
+	RUN_TEST(testCompressedReport);
+	RUN_TEST(testFramesLeftUncompressed);
+	RUN_TEST(testCompressionRules);
+	RUN_TEST(testUnknownCompressionRule);
+	RUN_TEST(testBatchOfCompressedFrames);
+
+	return UNITY_END();
+}
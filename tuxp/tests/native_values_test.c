@@ -0,0 +1,148 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "native_values.h"
+
+static const ProtocolName NAME_PROTOCOL_WEATHER = {{0xf7, 0x02}, 0x01};
+#define NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER 0x01
+#define NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER 0x02
+#define NAME_ATTRIBUTE_PRESSURE_PROTOCOL_WEATHER 0x03
+#define NAME_ATTRIBUTE_SWITCHES_PROTOCOL_WEATHER 0x04
+
+void setUp() {}
+
+void tearDown() {}
+
+void testVarintAndFloat16Codecs(void) {
+	uint8_t buff[MAX_SIZE_VARINT];
+	int32_t values[] = {0, -1, 1, 63, -64, 64, 300, -300, 2147483647, -2147483647 - 1};
+	int sizes[] = {1, 1, 1, 1, 1, 2, 2, 2, 5, 5};
+	for (int i = 0; i < 10; i++) {
+		TEST_ASSERT_EQUAL_INT(sizes[i], encodeVarint(values[i], buff));
+
+		int32_t value;
+		TEST_ASSERT_EQUAL_INT(sizes[i], decodeVarint(buff, sizes[i], &value));
+		TEST_ASSERT_EQUAL_INT32(values[i], value);
+	}
+
+	uint8_t unterminated[] = {0x80, 0x80};
+	int32_t value;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, decodeVarint(unterminated, 2, &value));
+
+	TEST_ASSERT_EQUAL_HEX16(0x3c00, encodeFloat16(1.0f));
+	TEST_ASSERT_EQUAL_HEX16(0xc000, encodeFloat16(-2.0f));
+	TEST_ASSERT_EQUAL_HEX16(0x7bff, encodeFloat16(65504.0f));
+	TEST_ASSERT_EQUAL_HEX16(0x7c00, encodeFloat16(100000.0f));
+	TEST_ASSERT_EQUAL_HEX16(0x0001, encodeFloat16(5.9604645e-8f));
+	// Ties go to the even one, anything past a tie goes up.
+	TEST_ASSERT_EQUAL_HEX16(0x3c00, encodeFloat16(0x1.002p0f));
+	TEST_ASSERT_EQUAL_HEX16(0x3c02, encodeFloat16(0x1.006p0f));
+	TEST_ASSERT_EQUAL_HEX16(0x3c01, encodeFloat16(0x1.00201p0f));
+	TEST_ASSERT_EQUAL_HEX16(0x0000, encodeFloat16(0x1p-25f));
+	TEST_ASSERT_EQUAL_HEX16(0x0002, encodeFloat16(0x1.8p-24f));
+	TEST_ASSERT_EQUAL_HEX16(0x0001, encodeFloat16(0x1.1p-25f));
+	TEST_ASSERT_EQUAL_HEX16(0x7c00, encodeFloat16(65520.0f));
+	TEST_ASSERT_EQUAL_FLOAT(1.0f, decodeFloat16(0x3c00));
+	TEST_ASSERT_EQUAL_FLOAT(5.9604645e-8f, decodeFloat16(0x0001));
+	TEST_ASSERT_FLOAT_WITHIN(0.01f, 23.45f, decodeFloat16(encodeFloat16(23.45f)));
+}
+
+void testNativeAttributesRoundTrip(void) {
+	bool switches[] = {true, false, true};
+
+	Protocol weather = createProtocol(NAME_PROTOCOL_WEATHER);
+	TEST_ASSERT_EQUAL_INT(0, addFloat16Attribute(&weather, NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER, 23.45f));
+	TEST_ASSERT_EQUAL_INT(0, addVarintAttribute(&weather, NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER, -129));
+	TEST_ASSERT_EQUAL_INT(0, addFloat32Attribute(&weather, NAME_ATTRIBUTE_PRESSURE_PROTOCOL_WEATHER, 1013.25f));
+	TEST_ASSERT_EQUAL_INT(0, addBoolsAttribute(&weather, NAME_ATTRIBUTE_SWITCHES_PROTOCOL_WEATHER, switches, 3));
+
+	// -129 zigzags to 0x0101, which is sent as 0x81 0x02.
+	uint8_t expectedHumidity[] = {0x02, 0xfd, 0x01, 0x81, 0x02, 0xfe};
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(encodedSize(&weather), 6 + 6 + 6 + 8 + 5);
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&weather, &pData));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedHumidity, pData.data + 12, sizeof(expectedHumidity));
+
+	ProtocolView view;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+
+	float temperature;
+	TEST_ASSERT_TRUE(viewGetFloat(&view, NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER, &temperature));
+	TEST_ASSERT_FLOAT_WITHIN(0.01f, 23.45f, temperature);
+
+	int humidity;
+	TEST_ASSERT_TRUE(viewGetInt(&view, NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER, &humidity));
+	TEST_ASSERT_EQUAL_INT(-129, humidity);
+
+	bool on;
+	TEST_ASSERT_TRUE(viewGetBool(&view, NAME_ATTRIBUTE_SWITCHES_PROTOCOL_WEATHER, 2, &on));
+	TEST_ASSERT_TRUE(on);
+	TEST_ASSERT_TRUE(viewGetBool(&view, NAME_ATTRIBUTE_SWITCHES_PROTOCOL_WEATHER, 1, &on));
+	TEST_ASSERT_FALSE(on);
+
+	Protocol parsed;
+	TEST_ASSERT_EQUAL_INT(0, parseProtocol(&pData, &parsed));
+
+	float pressure;
+	TEST_ASSERT_TRUE(getFloatAttributeValue(&parsed, NAME_ATTRIBUTE_PRESSURE_PROTOCOL_WEATHER, &pressure));
+	TEST_ASSERT_EQUAL_FLOAT(1013.25f, pressure);
+	TEST_ASSERT_TRUE(getIntAttributeValue(&parsed, NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER, &humidity));
+	TEST_ASSERT_EQUAL_INT(-129, humidity);
+	TEST_ASSERT_TRUE(getBoolAttributeValue(&parsed, NAME_ATTRIBUTE_SWITCHES_PROTOCOL_WEATHER, 0, &on));
+	TEST_ASSERT_TRUE(on);
+	TEST_ASSERT_NULL(getStringAttributeValue(&parsed, NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER));
+	releaseProtocol(&parsed);
+
+	releaseProtocolData(&pData);
+}
+
+void testNativeValuesWithFlagBytes(void) {
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	ProtocolWriter writer;
+	writerBegin(&writer, NAME_PROTOCOL_WEATHER, buff, sizeof(buff));
+	// 0xff escapes in the payload, as does any other flag byte.
+	writerPutBools(&writer, NAME_ATTRIBUTE_SWITCHES_PROTOCOL_WEATHER, 0xff);
+	writerPutFloat16(&writer, NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER, -65504.0f);
+	int size = writerEnd(&writer);
+
+	uint8_t expectedData[] = {
+		0xff,
+			0xf7, 0x02, 0x01, 0x02, 0x00,
+				0x04, 0xfd, 0x04, 0xfd, 0xff, 0xfe,
+				0x01, 0xfd, 0x02, 0xfd, 0xff, 0xfd, 0xfb,
+		0xff
+	};
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedData), size);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedData, buff, sizeof(expectedData));
+
+	ProtocolData pData = {buff, size};
+	ProtocolView view;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+
+	bool on;
+	TEST_ASSERT_TRUE(viewGetBool(&view, NAME_ATTRIBUTE_SWITCHES_PROTOCOL_WEATHER, 7, &on));
+	TEST_ASSERT_TRUE(on);
+
+	float temperature;
+	TEST_ASSERT_TRUE(viewGetFloat(&view, NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER, &temperature));
+	TEST_ASSERT_EQUAL_FLOAT(-65504.0f, temperature);
+
+	// Unknown type tags and short payloads are malformed.
+	buff[14] = 0x09;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, viewProtocol(&pData, &view));
+	buff[14] = TAG_FLOAT32_TYPE;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, viewProtocol(&pData, &view));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testVarintAndFloat16Codecs);
+	RUN_TEST(testNativeAttributesRoundTrip);
+	RUN_TEST(testNativeValuesWithFlagBytes);
+
+	return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "allocator.h"
+#include "pool_allocator.h"
+
+static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
+
+void setUp() {
+	initPoolAllocator();
+	usePoolAllocator();
+}
+
+void tearDown() {
+	tuxpSetAllocator(NULL, NULL, NULL);
+}
+
+void testPoolSizeClasses(void) {
+	void *value = poolAlloc(MAX_SIZE_ATTRIBUTE_DATA + 1, NULL);
+	void *text = poolAlloc(MAX_SIZE_TEXT_DATA + 1, NULL);
+	void *frame = poolAlloc(MAX_SIZE_PROTOCOL_DATA, NULL);
+	TEST_ASSERT_NOT_NULL(value);
+	TEST_ASSERT_NOT_NULL(text);
+	TEST_ASSERT_NOT_NULL(frame);
+	TEST_ASSERT_NULL(poolAlloc(sizeof(Protocol) + 1, NULL));
+
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_VALUE_BLOCKS - 1, getPoolFreeBlocks(POOL_CLASS_VALUE));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_TEXT_BLOCKS - 1, getPoolFreeBlocks(POOL_CLASS_TEXT));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_FRAME_BLOCKS - 1, getPoolFreeBlocks(POOL_CLASS_FRAME));
+
+	poolFree(value, MAX_SIZE_ATTRIBUTE_DATA + 1, NULL);
+	poolFree(text, MAX_SIZE_TEXT_DATA + 1, NULL);
+	poolFree(frame, MAX_SIZE_PROTOCOL_DATA, NULL);
+
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_VALUE_BLOCKS, getPoolFreeBlocks(POOL_CLASS_VALUE));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_TEXT_BLOCKS, getPoolFreeBlocks(POOL_CLASS_TEXT));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_FRAME_BLOCKS, getPoolFreeBlocks(POOL_CLASS_FRAME));
+}
+
+void testPoolExhaustion(void) {
+	void *values[SIZE_POOL_VALUE_BLOCKS];
+	for (int i = 0; i < SIZE_POOL_VALUE_BLOCKS; i++)
+		values[i] = poolAlloc(1, NULL);
+	TEST_ASSERT_EQUAL_INT(0, getPoolFreeBlocks(POOL_CLASS_VALUE));
+
+	void *spilled = poolAlloc(1, NULL);
+	TEST_ASSERT_NOT_NULL(spilled);
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_TEXT_BLOCKS - 1, getPoolFreeBlocks(POOL_CLASS_TEXT));
+
+	poolFree(spilled, 1, NULL);
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_TEXT_BLOCKS, getPoolFreeBlocks(POOL_CLASS_TEXT));
+
+	for (int i = 0; i < SIZE_POOL_VALUE_BLOCKS; i++)
+		poolFree(values[i], 1, NULL);
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_VALUE_BLOCKS, getPoolFreeBlocks(POOL_CLASS_VALUE));
+}
+
+void testTranslateAndParseWithPool(void) {
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	TEST_ASSERT_EQUAL_INT(0, addIntAttribute(&protocol, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5));
+	TEST_ASSERT_EQUAL_INT(0, setText(&protocol, "hello from the pool allocator"));
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&protocol, &pData));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_FRAME_BLOCKS - 1, getPoolFreeBlocks(POOL_CLASS_FRAME));
+
+	Protocol parsed;
+	TEST_ASSERT_EQUAL_INT(0, parseProtocol(&pData, &parsed));
+	int repeat;
+	TEST_ASSERT_TRUE(getIntAttributeValue(&parsed, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+	TEST_ASSERT_EQUAL_INT(5, repeat);
+	TEST_ASSERT_EQUAL_STRING("hello from the pool allocator", getText(&parsed));
+
+	releaseProtocol(&parsed);
+	releaseProtocolData(&pData);
+
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_VALUE_BLOCKS, getPoolFreeBlocks(POOL_CLASS_VALUE));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_TEXT_BLOCKS, getPoolFreeBlocks(POOL_CLASS_TEXT));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_FRAME_BLOCKS, getPoolFreeBlocks(POOL_CLASS_FRAME));
+}
+
+#if SIZE_POOL_PROTOCOL_BLOCKS > 0
+void testChildProtocolsWithPool(void) {
+	Protocol flash = createProtocol(NAME_PROTOCOL_FLASH);
+	ProtocolName firstName = {{0xf7, 0x01}, 0x01};
+	Protocol *first = addChild(&flash, firstName);
+	TEST_ASSERT_NOT_NULL(first);
+	TEST_ASSERT_EQUAL_INT(0, addIntAttribute(first, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 3));
+	ProtocolName secondName = {{0xf7, 0x01}, 0x02};
+	TEST_ASSERT_NOT_NULL(addChild(&flash, secondName));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_PROTOCOL_BLOCKS - 2, getPoolFreeBlocks(POOL_CLASS_PROTOCOL));
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&flash, &pData));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_PROTOCOL_BLOCKS, getPoolFreeBlocks(POOL_CLASS_PROTOCOL));
+
+	Protocol parsed;
+	TEST_ASSERT_EQUAL_INT(0, parseProtocol(&pData, &parsed));
+	releaseProtocolData(&pData);
+	TEST_ASSERT_EQUAL_INT(2, getChildrenSize(&parsed));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_PROTOCOL_BLOCKS - 2, getPoolFreeBlocks(POOL_CLASS_PROTOCOL));
+	int repeat;
+	TEST_ASSERT_TRUE(getIntAttributeValue(parsed.children, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+	TEST_ASSERT_EQUAL_INT(3, repeat);
+
+	releaseProtocol(&parsed);
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_VALUE_BLOCKS, getPoolFreeBlocks(POOL_CLASS_VALUE));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_FRAME_BLOCKS, getPoolFreeBlocks(POOL_CLASS_FRAME));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_PROTOCOL_BLOCKS, getPoolFreeBlocks(POOL_CLASS_PROTOCOL));
+}
+#else
+void testChildProtocolsWithPool(void) {
+	Protocol flash = createProtocol(NAME_PROTOCOL_FLASH);
+	ProtocolName firstName = {{0xf7, 0x01}, 0x01};
+	TEST_ASSERT_NULL(addChild(&flash, firstName));
+	TEST_ASSERT_EQUAL_INT(0, getChildrenSize(&flash));
+
+	releaseProtocol(&flash);
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_VALUE_BLOCKS, getPoolFreeBlocks(POOL_CLASS_VALUE));
+	TEST_ASSERT_EQUAL_INT(SIZE_POOL_FRAME_BLOCKS, getPoolFreeBlocks(POOL_CLASS_FRAME));
+}
+#endif
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testPoolSizeClasses);
+	RUN_TEST(testPoolExhaustion);
+	RUN_TEST(testTranslateAndParseWithPool);
+	RUN_TEST(testChildProtocolsWithPool);
+
+	return UNITY_END();
+}
@@ -0,0 +1,131 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "protocol_registry.h"
+
+#define SIZE_TEST_REGISTRY 8
+#define SIZE_TEST_HASH_REGISTRY 512
+#define SIZE_TEST_NAMES 300
+
+static int values[SIZE_TEST_NAMES];
+
+void setUp() {
+	for (int i = 0; i < SIZE_TEST_NAMES; i++)
+		values[i] = i;
+}
+
+void tearDown() {}
+
+// Names spread over a few namespaces, as a gateway sees them.
+static ProtocolName testName(int i) {
+	ProtocolName name = {{0xf7 + i % 3, i % 7}, (i * 37) & 0xff};
+	return name;
+}
+
+void testPackProtocolName(void) {
+	ProtocolName name = {{0xf8, 0x0b}, 0x05};
+	TEST_ASSERT_EQUAL_HEX32(0xf80b05, packProtocolName(name));
+
+	ProtocolName unpacked = unpackProtocolName(0xf80b05);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(name.ns, unpacked.ns, 2);
+	TEST_ASSERT_EQUAL_UINT8(name.localName, unpacked.localName);
+}
+
+void testSortedRegistry(void) {
+	uint32_t keys[SIZE_TEST_REGISTRY];
+	void *registryValues[SIZE_TEST_REGISTRY];
+	ProtocolRegistry registry;
+	initProtocolRegistry(&registry, keys, registryValues, SIZE_TEST_REGISTRY);
+
+	for (int i = 0; i < SIZE_TEST_REGISTRY; i++)
+		TEST_ASSERT_EQUAL_INT(0, registryPut(&registry, testName(i), &values[i]));
+
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_OUT_OF_MEMEORY, registryPut(&registry, testName(SIZE_TEST_REGISTRY),
+		&values[SIZE_TEST_REGISTRY]));
+	for (int i = 1; i < SIZE_TEST_REGISTRY; i++)
+		TEST_ASSERT_TRUE(keys[i - 1] < keys[i]);
+
+	for (int i = 0; i < SIZE_TEST_REGISTRY; i++)
+		TEST_ASSERT_EQUAL_PTR(&values[i], registryGet(&registry, testName(i)));
+	TEST_ASSERT_NULL(registryGet(&registry, testName(SIZE_TEST_REGISTRY)));
+
+	// The same name again replaces the value.
+	TEST_ASSERT_EQUAL_INT(0, registryPut(&registry, testName(3), &values[30]));
+	TEST_ASSERT_EQUAL_INT(SIZE_TEST_REGISTRY, registry.size);
+	TEST_ASSERT_EQUAL_PTR(&values[30], registryGet(&registry, testName(3)));
+
+	TEST_ASSERT_EQUAL_PTR(&values[30], registryRemove(&registry, testName(3)));
+	TEST_ASSERT_NULL(registryRemove(&registry, testName(3)));
+	TEST_ASSERT_NULL(registryGet(&registry, testName(3)));
+	TEST_ASSERT_EQUAL_PTR(&values[4], registryGet(&registry, testName(4)));
+	TEST_ASSERT_EQUAL_INT(SIZE_TEST_REGISTRY - 1, registry.size);
+}
+
+void testHashRegistry(void) {
+	uint32_t keys[SIZE_TEST_HASH_REGISTRY];
+	void *registryValues[SIZE_TEST_HASH_REGISTRY];
+	ProtocolHashRegistry registry;
+	initProtocolHashRegistry(&registry, keys, registryValues, SIZE_TEST_HASH_REGISTRY);
+
+	for (int i = 0; i < SIZE_TEST_NAMES; i++)
+		TEST_ASSERT_EQUAL_INT(0, hashRegistryPut(&registry, testName(i), &values[i]));
+	TEST_ASSERT_EQUAL_INT(SIZE_TEST_NAMES, registry.size);
+
+	// Every third name goes, the others must still be found behind the gaps.
+	for (int i = 0; i < SIZE_TEST_NAMES; i += 3)
+		TEST_ASSERT_EQUAL_PTR(&values[i], hashRegistryRemove(&registry, testName(i)));
+
+	for (int i = 0; i < SIZE_TEST_NAMES; i++) {
+		if (i % 3 == 0)
+			TEST_ASSERT_NULL(hashRegistryGet(&registry, testName(i)));
+		else
+			TEST_ASSERT_EQUAL_PTR(&values[i], hashRegistryGet(&registry, testName(i)));
+	}
+
+	ProtocolName unknown = {{0x01, 0x02}, 0x03};
+	TEST_ASSERT_NULL(hashRegistryGet(&registry, unknown));
+	TEST_ASSERT_NULL(hashRegistryRemove(&registry, unknown));
+}
+
+void testHashRegistryLoad(void) {
+	uint32_t keys[16];
+	void *registryValues[16];
+	ProtocolHashRegistry registry;
+	initProtocolHashRegistry(&registry, keys, registryValues, 16);
+
+	for (int i = 0; i < 12; i++)
+		TEST_ASSERT_EQUAL_INT(0, hashRegistryPut(&registry, testName(i), &values[i]));
+
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_OUT_OF_MEMEORY, hashRegistryPut(&registry, testName(12), &values[12]));
+	TEST_ASSERT_EQUAL_INT(0, hashRegistryPut(&registry, testName(5), &values[50]));
+	TEST_ASSERT_EQUAL_PTR(&values[50], hashRegistryGet(&registry, testName(5)));
+}
+
+void testNamespaceTable(void) {
+	ProtocolNamespaceTable table;
+	initProtocolNamespaceTable(&table, 0xf7, 0x01);
+
+	ProtocolName flash = {{0xf7, 0x01}, 0x00};
+	ProtocolName other = {{0xf7, 0x02}, 0x00};
+	TEST_ASSERT_TRUE(namespaceTablePut(&table, flash, &values[1]));
+	TEST_ASSERT_FALSE(namespaceTablePut(&table, other, &values[2]));
+
+	TEST_ASSERT_EQUAL_PTR(&values[1], namespaceTableGet(&table, flash));
+	TEST_ASSERT_NULL(namespaceTableGet(&table, other));
+	flash.localName = 0xff;
+	TEST_ASSERT_NULL(namespaceTableGet(&table, flash));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testPackProtocolName);
+	RUN_TEST(testSortedRegistry);
+	RUN_TEST(testHashRegistry);
+	RUN_TEST(testHashRegistryLoad);
+	RUN_TEST(testNamespaceTable);
+
+	return UNITY_END();
+}
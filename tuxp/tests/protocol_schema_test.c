@@ -0,0 +1,161 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "protocol_schema.h"
+
+static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
+#define NAME_ATTRIBUTE_COLOR_PROTOCOL_FLASH 0x02
+#define NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH 0x03
+
+static const ProtocolName NAME_PROTOCOL_WEATHER = {{0xf7, 0x02}, 0x01};
+#define NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER 0x01
+#define NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER 0x02
+#define NAME_ATTRIBUTE_PRESSURE_PROTOCOL_WEATHER 0x03
+#define NAME_ATTRIBUTE_STATE_PROTOCOL_WEATHER 0x04
+
+#define FLASH_SCHEMA(ATTRIBUTE) \
+	ATTRIBUTE(repeat, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, INT) \
+	ATTRIBUTE(color, NAME_ATTRIBUTE_COLOR_PROTOCOL_FLASH, RBS) \
+	ATTRIBUTE(label, NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH, STRING)
+
+DEFINE_PROTOCOL_SCHEMA(Flash, NAME_PROTOCOL_FLASH, FLASH_SCHEMA)
+
+#define WEATHER_SCHEMA(ATTRIBUTE) \
+	ATTRIBUTE(temperature, NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER, FLOAT32) \
+	ATTRIBUTE(humidity, NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER, VARINT) \
+	ATTRIBUTE(pressure, NAME_ATTRIBUTE_PRESSURE_PROTOCOL_WEATHER, FLOAT16) \
+	ATTRIBUTE(state, NAME_ATTRIBUTE_STATE_PROTOCOL_WEATHER, BYTE)
+
+DEFINE_PROTOCOL_SCHEMA(Weather, NAME_PROTOCOL_WEATHER, WEATHER_SCHEMA)
+
+void setUp() {}
+
+void tearDown() {
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+}
+
+static void assertSameAsGeneric(Protocol *generic, const uint8_t data[], int size) {
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateProtocol(generic, &pData));
+	TEST_ASSERT_EQUAL_INT(pData.dataSize, size);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(pData.data, data, size);
+	releaseProtocolData(&pData);
+}
+
+void testEncodeSchemaProtocols(void) {
+	ProtocolFormat formats[] = {PROTOCOL_FORMAT_ESCAPED, PROTOCOL_FORMAT_TLV};
+	for (int i = 0; i < 2; i++) {
+		setProtocolFormat(formats[i]);
+
+		FlashProtocol flash = {.repeat = 5, .color = 0x02, .label = "kitchen"};
+		uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+		int size = encodeFlashProtocol(&flash, buff, sizeof(buff), 0);
+		TEST_ASSERT_GREATER_THAN(0, size);
+
+		Protocol generic = createProtocol(NAME_PROTOCOL_FLASH);
+		addIntAttribute(&generic, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+		addRbsAttribute(&generic, NAME_ATTRIBUTE_COLOR_PROTOCOL_FLASH, 0x02);
+		addStringAttribute(&generic, NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH, "kitchen");
+		assertSameAsGeneric(&generic, buff, size);
+		releaseProtocol(&generic);
+
+		// A value that needs escaping.
+		WeatherProtocol weather = {.temperature = 21.5f, .humidity = 61, .pressure = -2.0f, .state = 0xfd};
+		size = encodeWeatherProtocol(&weather, buff, sizeof(buff), 3);
+		TEST_ASSERT_GREATER_THAN(3, size);
+
+		generic = createProtocol(NAME_PROTOCOL_WEATHER);
+		addFloat32Attribute(&generic, NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER, 21.5f);
+		addVarintAttribute(&generic, NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER, 61);
+		addFloat16Attribute(&generic, NAME_ATTRIBUTE_PRESSURE_PROTOCOL_WEATHER, -2.0f);
+		addByteAttribute(&generic, NAME_ATTRIBUTE_STATE_PROTOCOL_WEATHER, 0xfd);
+		assertSameAsGeneric(&generic, buff + 3, size - 3);
+		releaseProtocol(&generic);
+
+		TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, encodeWeatherProtocol(&weather, buff, 10, 0));
+	}
+}
+
+void testDecodeSchemaProtocols(void) {
+	ProtocolFormat formats[] = {PROTOCOL_FORMAT_ESCAPED, PROTOCOL_FORMAT_TLV};
+	for (int i = 0; i < 2; i++) {
+		setProtocolFormat(formats[i]);
+
+		// An attribute the schema doesn't know, a repeated one and a missing one.
+		Protocol generic = createProtocol(NAME_PROTOCOL_WEATHER);
+		addFloatAttribute(&generic, NAME_ATTRIBUTE_TEMPERATURE_PROTOCOL_WEATHER, -3.25f);
+		addIntAttribute(&generic, 0x09, 7);
+		addByteAttribute(&generic, NAME_ATTRIBUTE_STATE_PROTOCOL_WEATHER, 0xff);
+		addByteAttribute(&generic, NAME_ATTRIBUTE_STATE_PROTOCOL_WEATHER, 0x01);
+		addIntAttribute(&generic, NAME_ATTRIBUTE_HUMIDITY_PROTOCOL_WEATHER, 58);
+		ProtocolData pData;
+		TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&generic, &pData));
+
+		ProtocolView view;
+		TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+
+		WeatherProtocol weather;
+		TEST_ASSERT_EQUAL_INT(0, decodeWeatherProtocol(&view, &weather));
+		TEST_ASSERT_TRUE(weather.present.temperature);
+		TEST_ASSERT_EQUAL_FLOAT(-3.25f, weather.temperature);
+		TEST_ASSERT_TRUE(weather.present.humidity);
+		TEST_ASSERT_EQUAL_INT32(58, weather.humidity);
+		TEST_ASSERT_FALSE(weather.present.pressure);
+		TEST_ASSERT_TRUE(weather.present.state);
+		TEST_ASSERT_EQUAL_UINT8(0xff, weather.state);
+
+		FlashProtocol flash;
+		TEST_ASSERT_EQUAL_INT(TUXP_ERROR_UNKNOWN_PROTOCOL_NAME, decodeFlashProtocol(&view, &flash));
+		releaseProtocolData(&pData);
+	}
+}
+
+void testDecodeSchemaTypeMismatch(void) {
+	Protocol generic = createProtocol(NAME_PROTOCOL_FLASH);
+	addIntAttribute(&generic, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+	addStringAttribute(&generic, NAME_ATTRIBUTE_COLOR_PROTOCOL_FLASH, "red");
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&generic, &pData));
+
+	ProtocolView view;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+
+	FlashProtocol flash;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH, decodeFlashProtocol(&view, &flash));
+	releaseProtocolData(&pData);
+}
+
+void testDecodeSchemaProtocolInEnvelope(void) {
+	TinyId requestId = {0x01, 0x02, 0x03, 0x04, 0x05};
+	Protocol generic = createProtocol(NAME_PROTOCOL_FLASH);
+	addIntAttribute(&generic, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 3);
+	addStringAttribute(&generic, NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH, "hall");
+
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeLanExecution(requestId, &generic, buff, sizeof(buff), 0);
+	releaseProtocol(&generic);
+
+	ProtocolData pData = {buff, size};
+	LanEnvelope envelope;
+	TEST_ASSERT_EQUAL_INT(0, decodeLanEnvelope(&pData, &envelope));
+
+	FlashProtocol flash;
+	TEST_ASSERT_EQUAL_INT(0, decodeFlashProtocol(&envelope.inner, &flash));
+	TEST_ASSERT_EQUAL_INT32(3, flash.repeat);
+	TEST_ASSERT_FALSE(flash.present.color);
+	TEST_ASSERT_EQUAL_STRING("hall", flash.label);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testEncodeSchemaProtocols);
+	RUN_TEST(testDecodeSchemaProtocols);
+	RUN_TEST(testDecodeSchemaTypeMismatch);
+	RUN_TEST(testDecodeSchemaProtocolInEnvelope);
+
+	return UNITY_END();
+}
@@ -0,0 +1,207 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+
+static const ProtocolName NAME_PROTOCOL_INTRODUCTION = {{0xf8, 0x02}, 0x00};
+#define NAME_ATTRIBUTE_ADDRESS_PROTOCOL_INTRODUCTION 0x02
+
+static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
+
+void setUp() {}
+
+void tearDown() {}
+
+void testViewInboundProtocols(void) {
+	uint8_t flashData[] = {
+		0xff,
+			0xf7, 0x01, 0x00, 0x01, 0x00,
+				0x01, 0xfc, 0x35,
+		0xff
+	};
+
+	ProtocolData pDataFlash = CREATE_PROTOCOL_DATA(flashData);
+	ProtocolView flash;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pDataFlash, &flash));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(&NAME_PROTOCOL_FLASH, &flash.name, 3);
+	TEST_ASSERT_EQUAL_INT(1, flash.attributesSize);
+
+	int repeat;
+	TEST_ASSERT_TRUE(viewGetInt(&flash, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+	TEST_ASSERT_EQUAL_INT(5, repeat);
+
+	uint8_t introductionData[] = {
+		0xff,
+			0xf8, 0x02, 0x00, 0x01, 0x80,
+				0x02, 0xfb, 0xef, 0xee, 0x1f, 0xfe,
+				0x53, 0x4c, 0x2d, 0x4c, 0x45, 0x30, 0x31, 0x2d, 0x43, 0x39, 0x38, 0x30, 0x41, 0x46, 0x45, 0x39,
+		0xff
+	};
+
+	ProtocolData pDataIntroduction = CREATE_PROTOCOL_DATA(introductionData);
+	ProtocolView introduction;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pDataIntroduction, &introduction));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(&NAME_PROTOCOL_INTRODUCTION, &introduction.name, 3);
+
+	uint8_t buff[MAX_SIZE_ATTRIBUTE_DATA];
+	const uint8_t *address;
+	TEST_ASSERT_EQUAL_INT(3, viewGetBytes(&introduction, NAME_ATTRIBUTE_ADDRESS_PROTOCOL_INTRODUCTION,
+		buff, sizeof(buff), &address));
+	TEST_ASSERT_EQUAL_PTR(introductionData + 8, address);
+	uint8_t expectedAddress[] = {0xef, 0xee, 0x1f};
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedAddress, address, 3);
+
+	char textBuff[MAX_SIZE_TEXT_DATA];
+	const char *thingId;
+	TEST_ASSERT_EQUAL_INT(16, viewGetText(&introduction, textBuff, sizeof(textBuff), &thingId));
+	TEST_ASSERT_EQUAL_CHAR_ARRAY("SL-LE01-C980AFE9", thingId, 16);
+}
+
+void testViewEscapedAttributes(void) {
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	uint8_t bytes[] = {0x01, 0xff, 0xfe, 0x02};
+	TEST_ASSERT_EQUAL_INT(0, addBytesAttribute(&protocol, 0x01, bytes, 4));
+	TEST_ASSERT_EQUAL_INT(0, addByteAttribute(&protocol, 0x02, 0xfb));
+	TEST_ASSERT_EQUAL_INT(0, addRbsAttribute(&protocol, 0x03, 0x07));
+	TEST_ASSERT_EQUAL_INT(0, addStringAttribute(&protocol, 0x04, "abc"));
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&protocol, &pData));
+
+	ProtocolView view;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+	TEST_ASSERT_EQUAL_INT(4, view.attributesSize);
+
+	uint8_t buff[MAX_SIZE_ATTRIBUTE_DATA];
+	const uint8_t *value;
+	TEST_ASSERT_EQUAL_INT(4, viewGetBytes(&view, 0x01, buff, sizeof(buff), &value));
+	TEST_ASSERT_EQUAL_PTR(buff, value);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(bytes, value, 4);
+
+	uint8_t b;
+	TEST_ASSERT_TRUE(viewGetByte(&view, 0x02, &b));
+	TEST_ASSERT_EQUAL_UINT8(0xfb, b);
+	TEST_ASSERT_TRUE(viewGetRbs(&view, 0x03, &b));
+	TEST_ASSERT_EQUAL_UINT8(0x07, b);
+	TEST_ASSERT_FALSE(viewGetByte(&view, 0x03, &b));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_NO_SUCH_ATTRIBUTE, viewGetBytes(&view, 0x05, buff, sizeof(buff), &value));
+
+	uint8_t expectedNames[] = {0x01, 0x02, 0x03, 0x04};
+	DataType expectedTypes[] = {TYPE_BYTES, TYPE_BYTE, TYPE_RBS, TYPE_CHARS};
+	AttributeViewIterator iterator = viewAttributes(&view);
+	AttributeView attribute;
+	int i = 0;
+	while (viewNextAttribute(&iterator, &attribute)) {
+		TEST_ASSERT_EQUAL_UINT8(expectedNames[i], attribute.name);
+		TEST_ASSERT_EQUAL_INT(expectedTypes[i], attribute.dataType);
+		i++;
+	}
+	TEST_ASSERT_EQUAL_INT(4, i);
+
+	releaseProtocolData(&pData);
+}
+
+void testViewMalformedProtocols(void) {
+	uint8_t truncatedData[] = {0xff, 0xf7, 0x01, 0x00, 0x02, 0x00, 0x01, 0xfc, 0x35, 0xff};
+	ProtocolData pDataTruncated = CREATE_PROTOCOL_DATA(truncatedData);
+	ProtocolView view;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, viewProtocol(&pDataTruncated, &view));
+
+	uint8_t badEscapeData[] = {0xff, 0xf7, 0x01, 0x00, 0x01, 0x00, 0x01, 0xfd, 0x35, 0xff};
+	ProtocolData pDataBadEscape = CREATE_PROTOCOL_DATA(badEscapeData);
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, viewProtocol(&pDataBadEscape, &view));
+
+	uint8_t notProtocolData[] = {0x00, 0xf7, 0x01, 0x00, 0xff};
+	ProtocolData pDataNotProtocol = CREATE_PROTOCOL_DATA(notProtocolData);
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_NOT_VALID_PROTOCOL, viewProtocol(&pDataNotProtocol, &view));
+}
+
+void testViewTlvProtocols(void) {
+	uint8_t bytes[] = {0x01, 0xfd, 0xfa, 0xff};
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	addBytesAttribute(&protocol, 0x02, bytes, 4);
+	addByteAttribute(&protocol, 0x03, 0xfe);
+	addVarintAttribute(&protocol, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, -300);
+	setText(&protocol, "a\xff" "b");
+
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	ProtocolWriter writer;
+	writerBeginFormatAt(&writer, PROTOCOL_FORMAT_TLV, protocol.name, buff, sizeof(buff), 0);
+	writerPutProtocol(&writer, &protocol);
+	int size = writerEnd(&writer);
+	TEST_ASSERT_EQUAL_INT(encodedSizeIn(&protocol, PROTOCOL_FORMAT_TLV), size);
+
+	ProtocolData pData = {buff, size};
+	ProtocolView view;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+	TEST_ASSERT_EQUAL_INT(PROTOCOL_FORMAT_TLV, view.format);
+	TEST_ASSERT_EQUAL_INT(3, view.attributesSize);
+
+	// Values are always borrowed from a TLV frame.
+	uint8_t valueBuff[MAX_SIZE_ATTRIBUTE_DATA];
+	const uint8_t *value;
+	TEST_ASSERT_EQUAL_INT(4, viewGetBytes(&view, 0x02, valueBuff, sizeof(valueBuff), &value));
+	TEST_ASSERT_EQUAL_PTR(buff + 11, value);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(bytes, value, 4);
+
+	uint8_t b;
+	TEST_ASSERT_TRUE(viewGetByte(&view, 0x03, &b));
+	TEST_ASSERT_EQUAL_HEX8(0xfe, b);
+
+	int repeat;
+	TEST_ASSERT_TRUE(viewGetInt(&view, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+	TEST_ASSERT_EQUAL_INT(-300, repeat);
+
+	char textBuff[MAX_SIZE_TEXT_DATA];
+	const char *text;
+	TEST_ASSERT_EQUAL_INT(3, viewGetText(&view, textBuff, sizeof(textBuff), &text));
+	TEST_ASSERT_EQUAL_CHAR_ARRAY("a\xff" "b", text, 3);
+
+	Protocol parsed;
+	TEST_ASSERT_EQUAL_INT(0, parseProtocol(&pData, &parsed));
+	uint8_t *parsedBytes = getBytesAttributeValue(&parsed, 0x02);
+	TEST_ASSERT_NOT_NULL(parsedBytes);
+	TEST_ASSERT_EQUAL_UINT8(4, parsedBytes[0]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(bytes, parsedBytes + 1, 4);
+	TEST_ASSERT_EQUAL_STRING("a\xff" "b", getText(&parsed));
+	releaseProtocol(&parsed);
+
+	// A LAN envelope in TLV carries its inner protocol as a length prefixed child.
+	TinyId requestId = {0x01, 0xff, 0x03, 0xfe, 0x05};
+	setProtocolFormat(PROTOCOL_FORMAT_TLV);
+	size = encodeLanReport(requestId, &protocol, true, buff, sizeof(buff), 0);
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+	releaseProtocol(&protocol);
+	TEST_ASSERT_TRUE(size > 0);
+
+	ProtocolData pDataReport = {buff, size};
+	LanEnvelope envelope;
+	TEST_ASSERT_EQUAL_INT(0, decodeLanEnvelope(&pDataReport, &envelope));
+	TEST_ASSERT_EQUAL_INT(LAN_ENVELOPE_REPORT, envelope.type);
+	TEST_ASSERT_TRUE(envelope.ackRequired);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(requestId, envelope.tinyId, SIZE_THINGS_TINY_ID);
+	TEST_ASSERT_TRUE(viewGetInt(&envelope.inner, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+	TEST_ASSERT_EQUAL_INT(-300, repeat);
+
+	// The length must match the frame.
+	pDataReport.dataSize--;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_NOT_VALID_PROTOCOL, viewProtocol(&pDataReport, &view));
+
+	// An attribute running past the end of the frame.
+	pDataReport.dataSize = 12;
+	buff[2] = 9;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, decodeLanEnvelope(&pDataReport, &envelope));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testViewInboundProtocols);
+	RUN_TEST(testViewEscapedAttributes);
+	RUN_TEST(testViewMalformedProtocols);
+	RUN_TEST(testViewTlvProtocols);
+
+	return UNITY_END();
+}
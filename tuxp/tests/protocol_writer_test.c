@@ -0,0 +1,186 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+
+static const ProtocolName NAME_PROTOCOL_FLASH = {{0xf7, 0x01}, 0x00};
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
+
+// What the writer puts for an int added with addIntAttribute(), and 5 in a TLV frame.
+#ifdef TUXP_NATIVE_NUMBERS
+#define writerPutIntAttribute writerPutVarint
+#define TLV_INT_5 TYPE_VARINT, 0x01, 0x0a
+#else
+#define writerPutIntAttribute writerPutInt
+#define TLV_INT_5 TYPE_CHARS, 0x01, 0x35
+#endif
+
+void setUp() {}
+
+void tearDown() {}
+
+void testWriteIntroduction(void) {
+	uint8_t expectedIntroductionData[] ={
+		0xff,
+			0xf8, 0x03, 0x00, 0x02, 0x80,
+				0x01, 0x53, 0x4c, 0x2d, 0x4c, 0x45, 0x30, 0x31, 0x2d, 0x43, 0x39, 0x38, 0x30, 0x41, 0x46, 0x45, 0x39, 0xfe,
+				0x02, 0xfb, 0xef, 0xee, 0x1f, 0xfe,
+				0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c,
+		0xff
+	};
+
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	uint8_t address[] = {0xef, 0xee, 0x1f};
+	ProtocolWriter writer;
+	writerBegin(&writer, NAME_TUXP_PROTOCOL_INTRODUCTION, buff, sizeof(buff));
+	TEST_ASSERT_EQUAL_INT(0, writerPutString(&writer, NAME_ATTRIBUTE_THING_ID_TUXP_PROTOCOL_INTRODUCTION,
+		"SL-LE01-C980AFE9"));
+	TEST_ASSERT_EQUAL_INT(0, writerPutBytes(&writer, NAME_ATTRIBUTE_ADDRESS_TUXP_PROTOCOL_INTRODUCTION,
+		address, 3));
+	TEST_ASSERT_EQUAL_INT(0, writerSetText(&writer, "abcdefghijkl"));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_CHANGE_CLOSED, writerPutRbs(&writer, 0x03, 0x01));
+
+	writerBegin(&writer, NAME_TUXP_PROTOCOL_INTRODUCTION, buff, sizeof(buff));
+	writerPutString(&writer, NAME_ATTRIBUTE_THING_ID_TUXP_PROTOCOL_INTRODUCTION, "SL-LE01-C980AFE9");
+	writerPutBytes(&writer, NAME_ATTRIBUTE_ADDRESS_TUXP_PROTOCOL_INTRODUCTION, address, 3);
+	writerSetText(&writer, "abcdefghijkl");
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedIntroductionData), writerEnd(&writer));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedIntroductionData, buff, sizeof(expectedIntroductionData));
+
+	uint8_t expectedBareData[] = {0xff, 0xf8, 0x03, 0x09, 0xff};
+	writerBegin(&writer, NAME_TUXP_PROTOCOL_CONFIGURED, buff, sizeof(buff));
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedBareData), writerEnd(&writer));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedBareData, buff, sizeof(expectedBareData));
+}
+
+void testWriterMatchesTranslation(void) {
+	uint8_t bytes[] = {0x01, 0xff, 0xfe, 0xfc};
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	addIntAttribute(&protocol, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+	addBytesAttribute(&protocol, 0x02, bytes, 4);
+	addByteAttribute(&protocol, 0x03, 0xfc);
+	addRbsAttribute(&protocol, 0x04, 0xfa);
+	addStringAttribute(&protocol, 0x05, "x");
+	setText(&protocol, "hello");
+
+	int size = encodedSize(&protocol);
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&protocol, &pData));
+	TEST_ASSERT_EQUAL_INT(size, pData.dataSize);
+
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	ProtocolWriter writer;
+	writerBegin(&writer, NAME_PROTOCOL_FLASH, buff, sizeof(buff));
+	writerPutIntAttribute(&writer, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+	writerPutBytes(&writer, 0x02, bytes, 4);
+	writerPutByte(&writer, 0x03, 0xfc);
+	writerPutRbs(&writer, 0x04, 0xfa);
+	writerPutString(&writer, 0x05, "x");
+	writerSetText(&writer, "hello");
+	TEST_ASSERT_EQUAL_INT(pData.dataSize, writerEnd(&writer));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(pData.data, buff, pData.dataSize);
+
+	Protocol parsed;
+	TEST_ASSERT_EQUAL_INT(0, parseProtocol(&pData, &parsed));
+	uint8_t *parsedBytes = getBytesAttributeValue(&parsed, 0x02);
+	TEST_ASSERT_NOT_NULL(parsedBytes);
+	TEST_ASSERT_EQUAL_UINT8(4, parsedBytes[0]);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(bytes, parsedBytes + 1, 4);
+	TEST_ASSERT_EQUAL_STRING("hello", getText(&parsed));
+	releaseProtocol(&parsed);
+
+	releaseProtocolData(&pData);
+}
+
+void testWriterRejectsOversizeFrames(void) {
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	uint8_t bytes[MAX_SIZE_ATTRIBUTE_DATA];
+	memset(bytes, 0xff, sizeof(bytes));
+	for (int i = 0; i < 3; i++)
+		addBytesAttribute(&protocol, i, bytes, sizeof(bytes));
+
+	TEST_ASSERT_TRUE(encodedSize(&protocol) > MAX_SIZE_PROTOCOL_DATA);
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, translateAndRelease(&protocol, &pData));
+
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	ProtocolWriter writer;
+	writerBegin(&writer, NAME_PROTOCOL_FLASH, buff, sizeof(buff));
+	for (int i = 0; i < 3; i++)
+		writerPutBytes(&writer, i, bytes, sizeof(bytes));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, writerEnd(&writer));
+}
+
+void testWriterRejectsReservedNames(void) {
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	ProtocolWriter writer;
+	ProtocolName compressedName = {{FLAG_COMPRESSED_FRAME, 0x01}, 0x00};
+	writerBegin(&writer, compressedName, buff, sizeof(buff));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_RESERVED_PROTOCOL_NAME, writerEnd(&writer));
+
+	ProtocolName tlvName = {{FLAG_TLV_FRAME, 0x01}, 0x00};
+	writerBeginFormatAt(&writer, PROTOCOL_FORMAT_TLV, tlvName, buff, sizeof(buff), 0);
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_RESERVED_PROTOCOL_NAME, writerEnd(&writer));
+
+	Protocol protocol = createProtocol(compressedName);
+	addIntAttribute(&protocol, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_FAILED_TO_TRANSLATE_PROTOCOL, translateAndRelease(&protocol, &pData));
+}
+
+void testWriteTlvFrames(void) {
+	uint8_t expectedData[] = {
+		0xff, 0xfc, 0x14,
+			0xf7, 0x01, 0x00, 0x02, 0x80,
+				0x01, TLV_INT_5,
+				0x02, TYPE_BYTES, 0x03, 0xff, 0xfe, 0xfd,
+				0x68, 0x65, 0x6c, 0x6c, 0x6f
+	};
+
+	uint8_t bytes[] = {0xff, 0xfe, 0xfd};
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	ProtocolWriter writer;
+	writerBeginFormatAt(&writer, PROTOCOL_FORMAT_TLV, NAME_PROTOCOL_FLASH, buff, sizeof(buff), 0);
+	writerPutIntAttribute(&writer, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+	writerPutBytes(&writer, 0x02, bytes, 3);
+	writerSetText(&writer, "hello");
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedData), writerEnd(&writer));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedData, buff, sizeof(expectedData));
+
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	addIntAttribute(&protocol, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+	addBytesAttribute(&protocol, 0x02, bytes, 3);
+	setText(&protocol, "hello");
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedData), encodedSizeIn(&protocol, PROTOCOL_FORMAT_TLV));
+
+	setProtocolFormat(PROTOCOL_FORMAT_TLV);
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&protocol, &pData));
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedData), pData.dataSize);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedData, pData.data, pData.dataSize);
+	releaseProtocolData(&pData);
+
+	uint8_t expectedBareData[] = {0xff, 0xfc, 0x05, 0xf8, 0x03, 0x09, 0x00, 0x00};
+	writerBeginFormatAt(&writer, PROTOCOL_FORMAT_TLV, NAME_TUXP_PROTOCOL_CONFIGURED, buff, sizeof(buff), 0);
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedBareData), writerEnd(&writer));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedBareData, buff, sizeof(expectedBareData));
+
+	ProtocolData pDataBare = CREATE_PROTOCOL_DATA(expectedBareData);
+	TEST_ASSERT_TRUE(isBareProtocol(&pDataBare, NAME_TUXP_PROTOCOL_CONFIGURED));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testWriteIntroduction);
+	RUN_TEST(testWriterMatchesTranslation);
+	RUN_TEST(testWriterRejectsOversizeFrames);
+	RUN_TEST(testWriterRejectsReservedNames);
+	RUN_TEST(testWriteTlvFrames);
+
+	return UNITY_END();
+}
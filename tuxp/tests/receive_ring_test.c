@@ -0,0 +1,66 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "receive_ring.h"
+
+static ReceiveRing ring;
+
+void setUp() {
+	initReceiveRing(&ring);
+}
+
+void tearDown() {}
+
+void testPutAndTakeAcrossTheWrap(void) {
+	uint8_t data[SIZE_RECEIVE_RING];
+	for (int i = 0; i < SIZE_RECEIVE_RING; i++)
+		data[i] = 0xff - i;
+
+	uint8_t buff[SIZE_RECEIVE_RING];
+	// The counters go round the byte many times.
+	for (int round = 0; round < 600; round++) {
+		int size = 1 + round % (SIZE_RECEIVE_RING - 1);
+		TEST_ASSERT_EQUAL_INT(size, ringPutBytes(&ring, data, size));
+		TEST_ASSERT_EQUAL_INT(size, ringAvailable(&ring));
+
+		int taken = ringTakeBytes(&ring, buff, size / 2);
+		TEST_ASSERT_EQUAL_INT(size / 2, taken);
+		taken += ringTakeBytes(&ring, buff + taken, SIZE_RECEIVE_RING);
+		TEST_ASSERT_EQUAL_INT(size, taken);
+		TEST_ASSERT_EQUAL_UINT8_ARRAY(data, buff, size);
+		TEST_ASSERT_EQUAL_INT(0, ringAvailable(&ring));
+	}
+
+	TEST_ASSERT_EQUAL_UINT8(0, ring.overflows);
+}
+
+void testFullRing(void) {
+	for (int i = 0; i < SIZE_RECEIVE_RING; i++)
+		TEST_ASSERT_TRUE(ringPutByte(&ring, i));
+
+	TEST_ASSERT_EQUAL_INT(SIZE_RECEIVE_RING, ringAvailable(&ring));
+	TEST_ASSERT_FALSE(ringPutByte(&ring, 0xff));
+	TEST_ASSERT_EQUAL_UINT8(1, ring.overflows);
+
+	uint8_t buff[SIZE_RECEIVE_RING];
+	TEST_ASSERT_EQUAL_INT(3, ringTakeBytes(&ring, buff, 3));
+	uint8_t data[] = {0xfa, 0xfb, 0xfc, 0xfd, 0xfe};
+	TEST_ASSERT_EQUAL_INT(3, ringPutBytes(&ring, data, sizeof(data)));
+	TEST_ASSERT_EQUAL_UINT8(2, ring.overflows);
+
+	TEST_ASSERT_EQUAL_INT(SIZE_RECEIVE_RING, ringTakeBytes(&ring, buff, sizeof(buff)));
+	TEST_ASSERT_EQUAL_UINT8(3, buff[0]);
+	TEST_ASSERT_EQUAL_UINT8(0xfa, buff[SIZE_RECEIVE_RING - 3]);
+	TEST_ASSERT_EQUAL_UINT8(0xfc, buff[SIZE_RECEIVE_RING - 1]);
+	TEST_ASSERT_EQUAL_INT(0, ringTakeBytes(&ring, buff, sizeof(buff)));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testPutAndTakeAcrossTheWrap);
+	RUN_TEST(testFullRing);
+
+	return UNITY_END();
+}
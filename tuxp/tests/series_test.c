@@ -0,0 +1,170 @@
+#include <string.h>
+
+#include "unity.h"
+
+#include "tuxp.h"
+#include "series.h"
+
+static const ProtocolName NAME_PROTOCOL_WEATHER = {{0xf7, 0x02}, 0x01};
+#define NAME_ATTRIBUTE_TEMPERATURES_PROTOCOL_WEATHER 0x05
+#define NAME_ATTRIBUTE_PRESSURES_PROTOCOL_WEATHER 0x06
+
+#define SIZE_SAMPLES 30
+
+void setUp() {}
+
+void tearDown() {}
+
+static void makeTemperatures(int32_t temperatures[]) {
+	// Hundredths of a degree, warming up slowly.
+	for (int i = 0; i < SIZE_SAMPLES; i++)
+		temperatures[i] = 2150 + i * 2 + (i % 7 == 0 ? 1 : 0);
+}
+
+void testIntSeries(void) {
+	int32_t temperatures[SIZE_SAMPLES];
+	makeTemperatures(temperatures);
+
+	uint8_t buff[MAX_SIZE_SERIES_DATA];
+	SeriesEncoder encoder;
+	seriesBeginEncoding(&encoder, TYPE_INT_SERIES, buff, sizeof(buff));
+	for (int i = 0; i < SIZE_SAMPLES; i++)
+		TEST_ASSERT_EQUAL_INT(0, seriesPutInt(&encoder, temperatures[i]));
+
+	// Two bytes of base value and a byte for each of the others.
+	TEST_ASSERT_EQUAL_INT(2 + SIZE_SAMPLES - 1, encoder.size);
+	TEST_ASSERT_EQUAL_INT(SIZE_SAMPLES, countSeriesValues(TYPE_INT_SERIES, buff, encoder.size));
+
+	SeriesDecoder decoder;
+	seriesBeginDecoding(&decoder, TYPE_INT_SERIES, buff, encoder.size);
+	int32_t value;
+	for (int i = 0; i < SIZE_SAMPLES; i++) {
+		TEST_ASSERT_TRUE(seriesNextInt(&decoder, &value));
+		TEST_ASSERT_EQUAL_INT32(temperatures[i], value);
+	}
+	TEST_ASSERT_FALSE(seriesNextInt(&decoder, &value));
+
+	// Deltas wrap around.
+	int32_t extremes[] = {2147483647, -2147483647 - 1, 0, 2147483647, -1};
+	seriesBeginEncoding(&encoder, TYPE_INT_SERIES, buff, sizeof(buff));
+	for (int i = 0; i < 5; i++)
+		TEST_ASSERT_EQUAL_INT(0, seriesPutInt(&encoder, extremes[i]));
+
+	seriesBeginDecoding(&decoder, TYPE_INT_SERIES, buff, encoder.size);
+	for (int i = 0; i < 5; i++) {
+		TEST_ASSERT_TRUE(seriesNextInt(&decoder, &value));
+		TEST_ASSERT_EQUAL_INT32(extremes[i], value);
+	}
+
+	// A value which doesn't fit leaves the encoder as it was.
+	seriesBeginEncoding(&encoder, TYPE_INT_SERIES, buff, 3);
+	TEST_ASSERT_EQUAL_INT(0, seriesPutInt(&encoder, 2150));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE, seriesPutInt(&encoder, 100000));
+	TEST_ASSERT_EQUAL_INT(2, encoder.size);
+	TEST_ASSERT_EQUAL_INT(1, encoder.valuesSize);
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_TYPE_MISMATCH, seriesPutFloat(&encoder, 1.0f));
+
+	uint8_t truncated[] = {0x01, 0x80};
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, countSeriesValues(TYPE_INT_SERIES, truncated, 2));
+}
+
+void testFloatSeries(void) {
+	float pressures[] = {1013.25f, 1013.25f, 1013.25f, 1013.5f, 1013.5f, -0.0f, 3.4e38f, 1013.25f};
+	int sizes[] = {1 + 3, 1, 1, 1 + 1, 1, 1 + 3, 1 + 4, 1 + 4};
+
+	uint8_t buff[MAX_SIZE_SERIES_DATA];
+	SeriesEncoder encoder;
+	seriesBeginEncoding(&encoder, TYPE_FLOAT_SERIES, buff, sizeof(buff));
+	for (int i = 0; i < 8; i++) {
+		int size = encoder.size;
+		TEST_ASSERT_EQUAL_INT(0, seriesPutFloat(&encoder, pressures[i]));
+		TEST_ASSERT_EQUAL_INT(sizes[i], encoder.size - size);
+	}
+	TEST_ASSERT_EQUAL_INT(8, countSeriesValues(TYPE_FLOAT_SERIES, buff, encoder.size));
+
+	SeriesDecoder decoder;
+	seriesBeginDecoding(&decoder, TYPE_FLOAT_SERIES, buff, encoder.size);
+	float value;
+	for (int i = 0; i < 8; i++) {
+		TEST_ASSERT_TRUE(seriesNextFloat(&decoder, &value));
+		TEST_ASSERT_EQUAL_MEMORY(pressures + i, &value, sizeof(float));
+	}
+	TEST_ASSERT_FALSE(seriesNextFloat(&decoder, &value));
+
+	// More meaningful bytes than a float has.
+	uint8_t malformed[] = {0x14, 0x01, 0x02, 0x03, 0x04};
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, countSeriesValues(TYPE_FLOAT_SERIES, malformed, 5));
+}
+
+void testSeriesAttributesRoundTrip(void) {
+	int32_t temperatures[SIZE_SAMPLES];
+	makeTemperatures(temperatures);
+	float pressures[] = {1013.25f, 1013.25f, 1013.5f};
+
+	ProtocolFormat formats[] = {PROTOCOL_FORMAT_ESCAPED, PROTOCOL_FORMAT_TLV};
+	for (int i = 0; i < 2; i++) {
+		setProtocolFormat(formats[i]);
+
+		Protocol weather = createProtocol(NAME_PROTOCOL_WEATHER);
+		TEST_ASSERT_EQUAL_INT(0, addIntSeriesAttribute(&weather, NAME_ATTRIBUTE_TEMPERATURES_PROTOCOL_WEATHER,
+			temperatures, SIZE_SAMPLES));
+		TEST_ASSERT_EQUAL_INT(0, addFloatSeriesAttribute(&weather, NAME_ATTRIBUTE_PRESSURES_PROTOCOL_WEATHER,
+			pressures, 3));
+
+		ProtocolData pData;
+		int size = encodedSize(&weather);
+		TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&weather, &pData));
+		TEST_ASSERT_EQUAL_INT(size, pData.dataSize);
+		TEST_ASSERT_TRUE(pData.dataSize <= MAX_SIZE_PROTOCOL_DATA);
+
+		ProtocolView view;
+		TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+
+		uint8_t buff[MAX_SIZE_SERIES_DATA];
+		SeriesDecoder decoder;
+		TEST_ASSERT_EQUAL_INT(0, viewGetSeries(&view, NAME_ATTRIBUTE_TEMPERATURES_PROTOCOL_WEATHER,
+			buff, sizeof(buff), &decoder));
+		int32_t temperature;
+		for (int j = 0; j < SIZE_SAMPLES; j++) {
+			TEST_ASSERT_TRUE(seriesNextInt(&decoder, &temperature));
+			TEST_ASSERT_EQUAL_INT32(temperatures[j], temperature);
+		}
+
+		Protocol parsed;
+		TEST_ASSERT_EQUAL_INT(0, parseProtocol(&pData, &parsed));
+		releaseProtocolData(&pData);
+
+		TEST_ASSERT_TRUE(getSeriesAttributeValue(&parsed, NAME_ATTRIBUTE_PRESSURES_PROTOCOL_WEATHER, &decoder));
+		float pressure;
+		for (int j = 0; j < 3; j++) {
+			TEST_ASSERT_TRUE(seriesNextFloat(&decoder, &pressure));
+			TEST_ASSERT_EQUAL_FLOAT(pressures[j], pressure);
+		}
+		TEST_ASSERT_FALSE(seriesNextInt(&decoder, &temperature));
+
+		releaseProtocol(&parsed);
+	}
+
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+
+	// A series which doesn't decode makes the frame malformed.
+	uint8_t malformed[] = {
+		0xff,
+			0xf7, 0x02, 0x01, 0x01, 0x00,
+				0x05, 0xfd, 0x05, 0x01, 0x80,
+		0xff
+	};
+	ProtocolData pDataMalformed = {malformed, sizeof(malformed)};
+	Protocol parsed;
+	TEST_ASSERT_NOT_EQUAL(0, parseProtocol(&pDataMalformed, &parsed));
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testIntSeries);
+	RUN_TEST(testFloatSeries);
+	RUN_TEST(testSeriesAttributesRoundTrip);
+
+	return UNITY_END();
+}
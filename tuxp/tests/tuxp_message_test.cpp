@@ -0,0 +1,138 @@
+#include <cstring>
+
+#include "unity.h"
+
+#include "tuxp_message.hpp"
+
+#define NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH 0x01
+#define NAME_ATTRIBUTE_ADDRESS_PROTOCOL_FLASH 0x02
+#define NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH 0x03
+#define NAME_ATTRIBUTE_BRIGHTNESS_PROTOCOL_FLASH 0x04
+
+using FlashName = tuxp::Name<0xf7, 0x01, 0x00>;
+using Flash = tuxp::Message<FlashName,
+	tuxp::Attr<NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, int>,
+	tuxp::Attr<NAME_ATTRIBUTE_ADDRESS_PROTOCOL_FLASH, tuxp::bytes<3>>,
+	tuxp::Attr<NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH, tuxp::chars<8>>,
+	tuxp::Attr<NAME_ATTRIBUTE_BRIGHTNESS_PROTOCOL_FLASH, tuxp::float16>>;
+
+using Weather = tuxp::Message<tuxp::Name<0xf7, 0x02, 0x01>,
+	tuxp::Attr<0x01, float>,
+	tuxp::Attr<0x02, tuxp::varint>,
+	tuxp::Attr<0x03, uint8_t>,
+	tuxp::Attr<0x04, tuxp::rbs>>;
+
+static_assert(Flash::maxEncodedSize == 8 + (3 + 11) + (3 + 8) + (3 + 8) + (3 + 5), "worst case size of Flash");
+static_assert(Flash::maxEncodedSize <= MAX_SIZE_PROTOCOL_DATA, "Flash fits in a frame");
+
+void setUp() {}
+
+void tearDown() {
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+}
+
+static Flash makeFlash() {
+	Flash flash;
+	flash.get<NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH>() = 5;
+	tuxp::bytes<3> &address = flash.get<NAME_ATTRIBUTE_ADDRESS_PROTOCOL_FLASH>();
+	address.size = 3;
+	address.data[0] = 0xef;
+	address.data[1] = 0xfe;
+	address.data[2] = 0x1f;
+	std::strcpy(flash.get<NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH>().value, "hall");
+	flash.get<NAME_ATTRIBUTE_BRIGHTNESS_PROTOCOL_FLASH>().value = 0.5f;
+
+	return flash;
+}
+
+void testEncodeMessageAsGenericProtocol(void) {
+	ProtocolFormat formats[] = {PROTOCOL_FORMAT_ESCAPED, PROTOCOL_FORMAT_TLV};
+	for (ProtocolFormat format : formats) {
+		setProtocolFormat(format);
+
+		uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+		int size = makeFlash().encode(buff);
+		TEST_ASSERT_GREATER_THAN(0, size);
+		TEST_ASSERT_LESS_OR_EQUAL(Flash::maxEncodedSize, size);
+
+		Protocol generic = createProtocol(FlashName::value());
+		addIntAttribute(&generic, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+		uint8_t address[] = {0xef, 0xfe, 0x1f};
+		addBytesAttribute(&generic, NAME_ATTRIBUTE_ADDRESS_PROTOCOL_FLASH, address, sizeof(address));
+		char label[] = "hall";
+		addStringAttribute(&generic, NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH, label);
+		addFloat16Attribute(&generic, NAME_ATTRIBUTE_BRIGHTNESS_PROTOCOL_FLASH, 0.5f);
+
+		ProtocolData pData;
+		TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&generic, &pData));
+		TEST_ASSERT_EQUAL_INT(pData.dataSize, size);
+		TEST_ASSERT_EQUAL_UINT8_ARRAY(pData.data, buff, size);
+		releaseProtocolData(&pData);
+
+		TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, makeFlash().encode(tuxp::Span<uint8_t>(buff, 8)));
+	}
+}
+
+void testDecodeMessage(void) {
+	ProtocolFormat formats[] = {PROTOCOL_FORMAT_ESCAPED, PROTOCOL_FORMAT_TLV};
+	for (ProtocolFormat format : formats) {
+		setProtocolFormat(format);
+
+		std::array<uint8_t, MAX_SIZE_PROTOCOL_DATA> buff;
+		int size = makeFlash().encode(buff);
+
+		Flash flash;
+		TEST_ASSERT_EQUAL_INT(0, flash.decode(tuxp::Span<const uint8_t>(buff.data(), size)));
+		TEST_ASSERT_TRUE(flash.has<NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH>());
+		TEST_ASSERT_EQUAL_INT(5, flash.get<NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH>());
+		TEST_ASSERT_EQUAL_INT(3, flash.get<NAME_ATTRIBUTE_ADDRESS_PROTOCOL_FLASH>().size);
+		TEST_ASSERT_EQUAL_UINT8(0xfe, flash.get<NAME_ATTRIBUTE_ADDRESS_PROTOCOL_FLASH>().data[1]);
+		TEST_ASSERT_EQUAL_STRING("hall", flash.get<NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH>().value);
+		TEST_ASSERT_EQUAL_FLOAT(0.5f, flash.get<NAME_ATTRIBUTE_BRIGHTNESS_PROTOCOL_FLASH>().value);
+
+		Weather weather;
+		TEST_ASSERT_EQUAL_INT(TUXP_ERROR_UNKNOWN_PROTOCOL_NAME, weather.decode(tuxp::Span<const uint8_t>(buff.data(),
+			size)));
+	}
+}
+
+void testDecodeMessageFromGenericProtocol(void) {
+	// An attribute the message doesn't know, a missing one and a string longer than the message takes.
+	Protocol generic = createProtocol(Weather::name());
+	addFloatAttribute(&generic, 0x01, -3.25f);
+	addIntAttribute(&generic, 0x09, 7);
+	addByteAttribute(&generic, 0x03, 0xff);
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&generic, &pData));
+
+	ProtocolView view;
+	TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+
+	Weather weather;
+	TEST_ASSERT_EQUAL_INT(0, weather.decode(view));
+	TEST_ASSERT_EQUAL_FLOAT(-3.25f, weather.get<0x01>());
+	TEST_ASSERT_FALSE(weather.has<0x02>());
+	TEST_ASSERT_EQUAL_UINT8(0xff, weather.get<0x03>());
+	TEST_ASSERT_FALSE(weather.has<0x04>());
+	releaseProtocolData(&pData);
+
+	generic = createProtocol(FlashName::value());
+	char label[] = "front door";
+	addStringAttribute(&generic, NAME_ATTRIBUTE_LABEL_PROTOCOL_FLASH, label);
+	TEST_ASSERT_EQUAL_INT(0, translateAndRelease(&generic, &pData));
+
+	Flash flash;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_ATTRIBUTE_DATA_TOO_LARGE, flash.decode(tuxp::Span<const uint8_t>(pData.data,
+		pData.dataSize)));
+	releaseProtocolData(&pData);
+}
+
+int main() {
+	UNITY_BEGIN();
+
+	RUN_TEST(testEncodeMessageAsGenericProtocol);
+	RUN_TEST(testDecodeMessage);
+	RUN_TEST(testDecodeMessageFromGenericProtocol);
+
+	return UNITY_END();
+}
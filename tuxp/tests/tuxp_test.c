@@ -1,6 +1,17 @@
 #include "unity.h"
 
 #include "tuxp.h"
+#include "native_values.h"
+#include "pool_allocator.h"
+
+// Small ints as addIntAttribute() encodes them.
+#ifdef TUXP_NATIVE_NUMBERS
+#define ENCODED_INT_3 0xfd, TAG_VARINT_TYPE, 0x06
+#define ENCODED_INT_5 0xfd, TAG_VARINT_TYPE, 0x0a
+#else
+#define ENCODED_INT_3 0xfc, 0x33
+#define ENCODED_INT_5 0xfc, 0x35
+#endif
 
 #define CHANGE_MODE_ACTION_ERROR_INVLID_MODE -1
 
@@ -67,10 +78,278 @@ void testParseInboundProtocols(void) {
 	releaseProtocol(&introduction);
 }
 
+void testProtocolAttributesTable(void) {
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	for (int i = 0; i < MAX_SIZE_ATTRIBUTES; i++)
+		TEST_ASSERT_EQUAL_INT(0, addIntAttribute(&protocol, i * SIZE_ATTRIBUTE_SLOTS, i));
+
+	TEST_ASSERT_EQUAL_INT(MAX_SIZE_ATTRIBUTES, getAttributesSize(&protocol));
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_TOO_MANY_ATTRIBUTES, addRbsAttribute(&protocol, 0xf0, 0x01));
+
+	for (int i = 0; i < MAX_SIZE_ATTRIBUTES; i++) {
+		int value;
+		TEST_ASSERT_TRUE(getIntAttributeValue(&protocol, i * SIZE_ATTRIBUTE_SLOTS, &value));
+		TEST_ASSERT_EQUAL_INT(i, value);
+	}
+
+	int value;
+	TEST_ASSERT_FALSE(getIntAttributeValue(&protocol, 0x01, &value));
+
+	releaseProtocol(&protocol);
+	TEST_ASSERT_EQUAL_INT(0, getAttributesSize(&protocol));
+
+	TEST_ASSERT_EQUAL_INT(0, addRbsAttribute(&protocol, 0x01, 0x01));
+	TEST_ASSERT_EQUAL_INT(0, addRbsAttribute(&protocol, 0x01, 0x02));
+
+	uint8_t rbsValue;
+	TEST_ASSERT_TRUE(getRbsAttributeValue(&protocol, 0x01, &rbsValue));
+	TEST_ASSERT_EQUAL_UINT8(0x01, rbsValue);
+
+	releaseProtocol(&protocol);
+}
+
+void testNumberAttributes(void) {
+	Protocol protocol = createProtocol(NAME_PROTOCOL_FLASH);
+	addStringAttribute(&protocol, 0x01, "-1205");
+	addStringAttribute(&protocol, 0x02, "21.5");
+	addStringAttribute(&protocol, 0x03, "-2.5e2");
+	addStringAttribute(&protocol, 0x04, "12abc");
+	addStringAttribute(&protocol, 0x05, "1234567890");
+
+	ProtocolAttribute *attribute = protocol.attributes;
+	TEST_ASSERT_EQUAL_UINT8(NUMBER_INT, attribute->numberType);
+	TEST_ASSERT_EQUAL_UINT8(NUMBER_FLOAT, protocol.attributes[2].numberType);
+	TEST_ASSERT_EQUAL_UINT8(NUMBER_NONE, protocol.attributes[3].numberType);
+	TEST_ASSERT_EQUAL_UINT8(NUMBER_NONE, protocol.attributes[4].numberType);
+
+	// Converted once, then read from the attribute.
+	int iValue;
+	for (int i = 0; i < 2; i++) {
+		TEST_ASSERT_TRUE(getIntAttributeValue(&protocol, 0x01, &iValue));
+		TEST_ASSERT_EQUAL_INT(-1205, iValue);
+		TEST_ASSERT_EQUAL_UINT8(NUMBER_INT | NUMBER_CONVERTED, attribute->numberType);
+	}
+
+	float fValue;
+	TEST_ASSERT_TRUE(getFloatAttributeValue(&protocol, 0x01, &fValue));
+	TEST_ASSERT_EQUAL_FLOAT(-1205.0f, fValue);
+	TEST_ASSERT_TRUE(getFloatAttributeValue(&protocol, 0x02, &fValue));
+	TEST_ASSERT_EQUAL_FLOAT(21.5f, fValue);
+	TEST_ASSERT_TRUE(getFloatAttributeValue(&protocol, 0x03, &fValue));
+	TEST_ASSERT_EQUAL_FLOAT(-250.0f, fValue);
+
+	// The others read as atoi() and atof() would read them.
+	TEST_ASSERT_TRUE(getIntAttributeValue(&protocol, 0x02, &iValue));
+	TEST_ASSERT_EQUAL_INT(21, iValue);
+	TEST_ASSERT_TRUE(getIntAttributeValue(&protocol, 0x04, &iValue));
+	TEST_ASSERT_EQUAL_INT(12, iValue);
+	TEST_ASSERT_TRUE(getFloatAttributeValue(&protocol, 0x04, &fValue));
+	TEST_ASSERT_EQUAL_FLOAT(12.0f, fValue);
+
+	releaseProtocol(&protocol);
+}
+
+void testEncodeLanEnvelopes(void) {
+	uint8_t expectedReportData[] = {
+		0x00, 0x00, 0x00,
+		0xff,
+			0xf8, 0x0a, 0x05, 0x02, 0x01,
+				0x06, 0xfb, 0x01, 0xfd, 0xfe, 0x03, 0x04, 0x05, 0xfe,
+				0x01, 0x02, 0xfe,
+				0xf7, 0x01, 0x00, 0x01, 0x00,
+					0x01, ENCODED_INT_5,
+		0xff
+	};
+
+	TinyId requestId = {0x01, 0xfe, 0x03, 0x04, 0x05};
+	Protocol flash = createProtocol(NAME_PROTOCOL_FLASH);
+	addIntAttribute(&flash, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+
+	uint8_t buff[3 + MAX_SIZE_PROTOCOL_DATA] = {0};
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedReportData), encodeLanReport(requestId, &flash, true, buff, sizeof(buff), 3));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedReportData, buff, sizeof(expectedReportData));
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(0, translateLanReport(requestId, &flash, true, &pData));
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedReportData) - 3, pData.dataSize);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedReportData + 3, pData.data, pData.dataSize);
+	releaseProtocolData(&pData);
+	releaseProtocol(&flash);
+
+	Protocol bare = createProtocol(NAME_PROTOCOL_FLASH);
+	uint8_t expectedBareExecutionData[] = {
+		0xff,
+			0xf8, 0x04, 0x05, 0x01, 0x01,
+				0x06, 0xfb, 0x01, 0xfd, 0xfe, 0x03, 0x04, 0x05, 0xfe,
+				0xf7, 0x01, 0x00,
+		0xff
+	};
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedBareExecutionData), encodeLanExecution(requestId, &bare, buff, sizeof(buff), 0));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedBareExecutionData, buff, sizeof(expectedBareExecutionData));
+
+	TEST_ASSERT_EQUAL_INT(0, makeTinyId(0, REQUEST, 1000, requestId));
+	LanAnswer error = createLanError(requestId, -3);
+	int size = encodeLanAnswer(&error, buff, sizeof(buff), 3);
+	TEST_ASSERT_TRUE(size > 3);
+
+	ProtocolData pDataError = {buff + 3, size - 3};
+	LanAnswer parsed;
+	TEST_ASSERT_EQUAL_INT(0, parseLanAnswer(&pDataError, &parsed));
+	TEST_ASSERT_EQUAL_INT(-3, parsed.errorNumber);
+
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_DATA_TOO_LARGE, encodeLanAnswer(&error, buff, 3 + 10, 3));
+}
+
+void testDecodeLanEnvelopes(void) {
+	uint8_t reportData[] = {
+		0xff,
+			0xf8, 0x0a, 0x05, 0x02, 0x01,
+				0x06, 0xfb, 0x01, 0xfd, 0xfe, 0x03, 0x04, 0x05, 0xfe,
+				0x01, 0x02, 0xfe,
+				0xf7, 0x01, 0x00, 0x01, 0x00,
+					0x01, 0xfc, 0x35,
+		0xff
+	};
+	TinyId expectedRequestId = {0x01, 0xfe, 0x03, 0x04, 0x05};
+
+	ProtocolData pData = {reportData, sizeof(reportData)};
+	LanEnvelope envelope;
+	TEST_ASSERT_EQUAL_INT(0, decodeLanEnvelope(&pData, &envelope));
+	TEST_ASSERT_EQUAL_INT(LAN_ENVELOPE_REPORT, envelope.type);
+	TEST_ASSERT_TRUE(envelope.ackRequired);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedRequestId, envelope.tinyId, SIZE_THINGS_TINY_ID);
+	TEST_ASSERT_EQUAL_UINT8(NAME_PROTOCOL_FLASH.localName, envelope.inner.name.localName);
+	TEST_ASSERT_TRUE(envelope.inner.data == reportData);
+
+	int repeat;
+	TEST_ASSERT_TRUE(viewGetInt(&envelope.inner, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+	TEST_ASSERT_EQUAL_INT(5, repeat);
+
+	TinyId requestId;
+	bool ackRequired;
+	Protocol flash;
+	TEST_ASSERT_EQUAL_INT(0, parseLanReport(&pData, requestId, &ackRequired, &flash));
+	TEST_ASSERT_TRUE(ackRequired);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedRequestId, requestId, SIZE_THINGS_TINY_ID);
+	TEST_ASSERT_TRUE(getIntAttributeValue(&flash, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+	TEST_ASSERT_EQUAL_INT(5, repeat);
+
+	// A report isn't an execution.
+	Protocol action;
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, parseLanExecution(&pData, requestId, &action));
+
+	uint8_t buff[MAX_SIZE_PROTOCOL_DATA];
+	int size = encodeLanNotification(expectedRequestId, &flash, false, buff, sizeof(buff), 0);
+	releaseProtocol(&flash);
+
+	ProtocolData pDataNotification = {buff, size};
+	Protocol event;
+	TEST_ASSERT_EQUAL_INT(0, parseLanNotification(&pDataNotification, requestId, &ackRequired, &event));
+	TEST_ASSERT_FALSE(ackRequired);
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedRequestId, requestId, SIZE_THINGS_TINY_ID);
+	TEST_ASSERT_TRUE(getIntAttributeValue(&event, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+	TEST_ASSERT_EQUAL_INT(5, repeat);
+	releaseProtocol(&event);
+
+	Protocol bare = createProtocol(NAME_PROTOCOL_FLASH);
+	size = encodeLanExecution(expectedRequestId, &bare, buff, sizeof(buff), 0);
+	ProtocolData pDataExecution = {buff, size};
+	TEST_ASSERT_EQUAL_INT(0, parseLanExecution(&pDataExecution, requestId, &action));
+	TEST_ASSERT_EQUAL_INT(0, getAttributesSize(&action));
+	TEST_ASSERT_NULL(getText(&action));
+
+	// Truncated envelope.
+	ProtocolData pDataTruncated = {reportData, 18};
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_MALFORMED_PROTOCOL_DATA, decodeLanEnvelope(&pDataTruncated, &envelope));
+}
+
+void testChildProtocols(void) {
+#if defined(MUD_NO_HEAP) && SIZE_POOL_PROTOCOL_BLOCKS == 0
+	TEST_IGNORE_MESSAGE("No pool blocks for child protocols");
+#endif
+	uint8_t expectedData[] = {
+		0xff,
+			0xf7, 0x01, 0x00, 0x01, 0x02,
+				0x01, ENCODED_INT_5, 0xfe,
+				0xf7, 0x01, 0x01, 0x01, 0x00,
+					0x01, ENCODED_INT_3, 0xfe,
+				0xf7, 0x01, 0x02,
+		0xff
+	};
+
+	Protocol flash = createProtocol(NAME_PROTOCOL_FLASH);
+	addIntAttribute(&flash, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 5);
+	ProtocolName firstName = {{0xf7, 0x01}, 0x01};
+	Protocol *first = addChild(&flash, firstName);
+	TEST_ASSERT_NOT_NULL(first);
+	addIntAttribute(first, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 3);
+	ProtocolName secondName = {{0xf7, 0x01}, 0x02};
+	TEST_ASSERT_NOT_NULL(addChild(&flash, secondName));
+	TEST_ASSERT_EQUAL_INT(2, getChildrenSize(&flash));
+
+	// Text and children can't be mixed yet.
+	TEST_ASSERT_EQUAL_INT(TUXP_ERROR_PROTOCOL_CHANGE_CLOSED, setText(&flash, "text"));
+
+	ProtocolData pData;
+	TEST_ASSERT_EQUAL_INT(sizeof(expectedData), encodedSize(&flash));
+	TEST_ASSERT_EQUAL_INT(0, translateProtocol(&flash, &pData));
+	TEST_ASSERT_EQUAL_UINT8_ARRAY(expectedData, pData.data, sizeof(expectedData));
+	releaseProtocolData(&pData);
+
+	// A grandchild, in both formats.
+	ProtocolName grandchildName = {{0xf7, 0x01}, 0x03};
+	Protocol *grandchild = addChild(first, grandchildName);
+	addIntAttribute(grandchild, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, 7);
+
+	ProtocolFormat formats[] = {PROTOCOL_FORMAT_ESCAPED, PROTOCOL_FORMAT_TLV};
+	for (int i = 0; i < 2; i++) {
+		setProtocolFormat(formats[i]);
+
+		int size = encodedSize(&flash);
+		TEST_ASSERT_EQUAL_INT(0, translateProtocol(&flash, &pData));
+		TEST_ASSERT_EQUAL_INT(size, pData.dataSize);
+
+		ProtocolView view;
+		TEST_ASSERT_EQUAL_INT(0, viewProtocol(&pData, &view));
+		ChildViewIterator iterator = viewChildren(&view);
+		ProtocolView child;
+		int children = 0;
+		while (viewNextChild(&iterator, &child))
+			children++;
+		TEST_ASSERT_EQUAL_INT(2, children);
+
+		Protocol parsed;
+		TEST_ASSERT_EQUAL_INT(0, parseProtocol(&pData, &parsed));
+		releaseProtocolData(&pData);
+
+		int repeat;
+		TEST_ASSERT_EQUAL_INT(2, getChildrenSize(&parsed));
+		TEST_ASSERT_TRUE(getIntAttributeValue(&parsed, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+		TEST_ASSERT_EQUAL_INT(5, repeat);
+		TEST_ASSERT_EQUAL_UINT8(0x01, parsed.children->name.localName);
+		TEST_ASSERT_TRUE(getIntAttributeValue(parsed.children, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH, &repeat));
+		TEST_ASSERT_EQUAL_INT(3, repeat);
+		TEST_ASSERT_TRUE(getIntAttributeValue(parsed.children->children, NAME_ATTRIBUTE_REPEAT_PROTOCOL_FLASH,
+			&repeat));
+		TEST_ASSERT_EQUAL_INT(7, repeat);
+		TEST_ASSERT_EQUAL_UINT8(0x02, parsed.children->next->name.localName);
+		TEST_ASSERT_EQUAL_INT(0, getAttributesSize(parsed.children->next));
+		releaseProtocol(&parsed);
+	}
+
+	setProtocolFormat(PROTOCOL_FORMAT_ESCAPED);
+	releaseProtocol(&flash);
+}
+
 int main() {
 	UNITY_BEGIN();
 	
 	RUN_TEST(testParseInboundProtocols);
+	RUN_TEST(testProtocolAttributesTable);
+	RUN_TEST(testNumberAttributes);
+	RUN_TEST(testEncodeLanEnvelopes);
+	RUN_TEST(testDecodeLanEnvelopes);
+	RUN_TEST(testChildProtocols);
 	
 	return UNITY_END();
 }